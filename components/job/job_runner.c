@@ -28,42 +28,376 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+
+#include "string.h"
+#include "stdio.h"
+
+#include "nvs.h"
 
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_console.h"
 
 #define SAFE_FREE(ptr) if(ptr){free(ptr);}
 
+// FreeRTOS fills fresh task stacks with this byte, uxTaskGetStackHighWaterMark counts how much of it is left
+#define JOB_RUNNER_STACK_FILL_BYTE 0xa5
+
+// Below a function's stack pointer the Xtensa windowed ABI keeps a 16 byte base save area, where window overflow
+// spills the registers of the function's caller. Repainting stops short of it.
+#define JOB_RUNNER_STACK_SAVE_AREA 16
+
+// Further out than any real deadline while still comparing correctly across tick wrap
+#define JOB_RUNNER_FAR_FUTURE 0x3fffffff
+
+// Shutdown completion is reported on shared event groups, every response handle owns one bit. Another group is added
+// whenever all bits are taken.
+// FreeRTOS keeps the top 8 bits of an event group for itself
+#define JOB_RUNNER_DONE_BITS 24
+
+// Hot table state bits
+#define JOB_RUNNER_HOT_NOTIF 0x01
+#define JOB_RUNNER_HOT_BLOCKED 0x02
+
+// Rate monotonic bounds n(2^(1/n) - 1) in 1/1000, larger sets use the limit ln 2 which is always below the real bound
+static const uint16_t job_runner_rm_bounds[] = { 1000, 1000, 828, 779, 756, 743, 734, 728, 724, 720, 717 };
+#define JOB_RUNNER_RM_LIMIT 693
+
+// Ticks the phase search spreads runs over, periods longer than this only have their first run placed
+#define JOB_RUNNER_PHASE_WINDOW 1024
+
+// Entries checked per step of the due scan, the inner loop has no early exit so it can be vectorized
+#define JOB_RUNNER_SCAN_BLOCK 16
+
+#define JOB_RUNNER_CMD_QUEUE_LEN 5
+
+// Control lane, calls, delayed notifications and urgent notifications are taken before anything on cmd_queue
+#define JOB_RUNNER_CTL_QUEUE_LEN 4
+
+// Offloaded jobs waiting for a free helper, a job is never queued twice
+#define JOB_RUNNER_OFFLOAD_QUEUE_LEN 8
+
+typedef job_runner_state_t (*job_runner_callback_t) (job_runner_state_t state, void* data);
+
 struct job_runner_job {
 
-    job_runner_state_t (*job_callback) (job_runner_state_t state, void* data);
-    TickType_t last_run;
+    // Only what a call needs is kept from the descriptor, the rest lives in the fields below
+    void* job_callback;
+    void* context;
+    int8_t with_context;
+    TickType_t next_run;
     TickType_t repeat_delay;
     int16_t job_id;
     
     int8_t notif;
     void* notif_data;
     void (*notif_dtor)(void* notif_data);
+    uint32_t notif_size;
+    uint8_t notif_inline[JOB_RUNNER_INLINE_SIZE] __attribute__((aligned(8)));
+
+    // Set instead of notif_dtor when the payload came from a topic, every subscriber holds a reference
+    struct job_runner_share* notif_share;
+    uint16_t topics;
+
+    // Latency stamps of the pending notification, the per job histograms only exist while job_runner_track_latency is on
+    uint32_t notif_enqueued_us;
+    uint32_t notif_dequeued_us;
+    struct job_runner_latency_stats* latency;
+
+    // Send order of the pending notification, see job_cmd.cmd_seq
+    uint32_t notif_seq;
+
+    uint32_t stack_used;
+    uint32_t busy_us;
+    uint32_t max_late;
+
+    // Set when the first run was placed by the caller, staggering leaves these jobs alone
+    int8_t phase_pinned;
+
+    // Deferred with portMAX_DELAY, only a notification or the shutdown runs it again
+    int8_t parked;
+
+    // Declared worst case callback time, wcet_measured_us is the longest callback seen since the last calibration
+    uint32_t wcet_us;
+    uint32_t wcet_measured_us;
+
+    struct job_runner_notif_slot* notif_slot;
+
+    // Offloaded jobs run on a helper task, the runner leaves them alone while in_flight is set
+    int8_t offload;
+    int8_t in_flight;
+    job_runner_state_t offload_state;
+    void* offload_data;
+    void (*offload_dtor)(void* offload_data);
+    uint32_t offload_size;
+    uint8_t offload_inline[JOB_RUNNER_INLINE_SIZE] __attribute__((aligned(8)));
+    struct job_runner_share* offload_share;
+
+    // Position in the runner's hot table, only meaningful while the table holds this job
+    uint32_t hot_index;
+
+    // Jobs from a descriptor table share one allocation, block_index finds its start
+    uint8_t pooled;
+    uint16_t block_index;
 
     struct job_runner_job* next;
 
 };
 
+// One published payload delivered to several jobs, destroyed once the last of them ran
+struct job_runner_share {
+
+    uint32_t refs;
+    void* data;
+    void (*dtor)(void* data);
+
+};
+
+// Subscriber index entry, sorted by topic so a publish finds all its subscribers in one run
+struct job_runner_sub {
+
+    job_runner_topic_t topic;
+    struct job_runner_job* job;
+
+};
+
+// Delayed notification, the runner keeps them in a min heap on due so the earliest is always timers[0]
+struct job_runner_timer {
+
+    TickType_t due;
+    job_runner_timer_t handle;
+    int16_t job_id;
+    void* data;
+    void (*dtor)(void* data);
+
+};
+
+struct job_runner_job_block {
+
+    uint32_t live;
+    struct job_runner_job jobs[];
+
+};
+
+struct job_runner_lane {
+
+    uint16_t peak_depth;
+    uint32_t commands;
+    uint64_t wait_us;
+    uint32_t max_wait_us;
+
+};
+
 struct job_runner {
 
     TaskHandle_t task_hnd;
     struct job_runner_job* jobs;
+    struct job_runner_job* paused;
     TickType_t loop_delay;
     job_runner_state_t state;
     xQueueHandle* cmd_queue;
-    xQueueHandle* shutdown_resp_channel;
+    xQueueHandle* ctl_queue;
+    struct job_runner_lane lanes[JOB_RUNNER_NUM_LANES];
+    int16_t done_slot;
+    volatile int8_t shutdown_pending;
+    int8_t started;
+    int8_t anchored;
+    int8_t simulating;
+
+    // Set while a balancer starts its runners, the task waits for a notification before it touches a job
+    int8_t held;
+    int8_t stagger;
+
+    // Hot scheduling fields of the active jobs in list order, the due scan reads nothing else. The list stays the owner.
+    // Jobs joining or leaving at run time are patched in place, bigger changes set hot_dirty for a rebuild before the
+    // next scan. hot_capacity covers every job the runner owns and is reserved when they join, so neither allocates.
+    TickType_t* hot_next_run;
+    uint8_t* hot_state;
+    struct job_runner_job** hot_jobs;
+    uint32_t hot_count;
+    uint32_t hot_capacity;
+    uint32_t hot_cursor;
+    uint32_t hot_passes;
+    int8_t hot_dirty;
+    int8_t hot_short;
+    struct job_runner_clock clock;
+
+    job_runner_stack_monitor_t stack_monitor;
+    int8_t calibrating;
+    uint32_t stack_size;
+    uint32_t stack_min_free;
+    int16_t stack_deepest_job;
+
+    uint32_t busy_us;
+    uint32_t load_mark_us;
+    struct job_runner_balancer* balancer;
+
+    // Adaptive sleep, loop_delay is the fixed delay when adaptive is off
+    int8_t adaptive;
+    TickType_t delay_floor;
+    TickType_t delay_ceiling;
+    TickType_t effective_delay;
+    TickType_t next_due;
+    TickType_t pass_next_due;
+    uint32_t dispatched;
+    uint32_t commands;
+    uint32_t wakeups;
+
+    // Priority boost, base_priority is what job_runner_execute started the task with
+    int8_t boost_enabled;
+    struct job_runner_boost boost;
+    int8_t boosted;
+    unsigned int base_priority;
+    TickType_t backlog_late;        // Worst lateness of the last pass that ran a job, raised right away by a later run
+    TickType_t pass_late;           // Worst lateness of the pass in progress
+    int8_t pass_ran;
+    TickType_t boost_since;
+    uint32_t boosts;
+    uint32_t boosted_ticks;
+
+    struct job_runner_notif_slot* notif_slots;
+    uint16_t num_notif_slots;
+    SemaphoreHandle_t notif_lock;
+
+    struct job_runner_sub* subs;
+    uint16_t num_subs;
+    uint16_t subs_capacity;
+
+    struct job_runner_timer* timers;
+    uint16_t num_timers;
+    uint16_t timers_capacity;
+    job_runner_timer_t next_timer_handle;
+
+    // Memory accounting, notif_bytes is added to by producers so it is only touched atomically
+    uint32_t job_bytes;
+    uint32_t notif_bytes;
+    uint32_t peak_bytes;
+    uint32_t mem_budget;
+    uint32_t mem_rejected;
+
+    // Stamped on every notification by the producers, only touched atomically
+    uint32_t notif_seq;
+
+    struct job_runner_latency_stats latency;
+
+    // Admission control, wcet_window_end closes the calibration window while wcet_calibrating is set
+    job_runner_admission_t admission;
+    job_runner_bound_t bound;
+    int8_t wcet_calibrating;
+    TickType_t wcet_window_end;
+
+    // Workload recorder, entries are reserved with an atomic add so producers and the runner can append at once.
+    // rec_writers counts appends between reading rec_buffer and finishing the copy, stopping waits for it to drain.
+    uint8_t* rec_buffer;
+    uint32_t rec_capacity;
+    uint32_t rec_next;
+    uint32_t rec_dropped;
+    uint32_t rec_writers;
+
+    // Job whose callback is running on the runner task, -1 in between
+    int16_t running_id;
+
+    // Set by job_runner_defer_job during that callback, used in place of the period for the next run
+    int8_t deferred;
+    int8_t defer_parked;
+    TickType_t defer_ticks;
+
+    uint8_t num_helpers;
+    uint8_t helpers_running;
+    uint32_t helper_stack;
+    unsigned int helper_priority;
+    xQueueHandle* offload_queue;
+    SemaphoreHandle_t helpers_exited;
+
+};
+
+struct job_runner_notif_slot {
+
+    int16_t job_id;
+    job_runner_coalesce_t mode;
+    void* (*merge)(void* pending, void* incoming);
+
+    // Token bucket, one notification costs configTICK_RATE_HZ tokens and rate tokens come back every tick
+    uint32_t rate;
+    uint32_t capacity;
+    uint32_t tokens;
+    TickType_t refill_tick;
+
+    // Set from the moment a notify command is queued until the job picks the payload up
+    int8_t queued;
+    void* data;
+    void (*dtor)(void* data);
+    uint32_t size;
+    uint8_t inline_len;
+    uint8_t inline_data[JOB_RUNNER_INLINE_SIZE] __attribute__((aligned(8)));
+
+    struct job_runner_notif_stats stats;
+
+};
+
+// Single producer, single consumer ring of fixed size slots. head is only written by the producer, tail only by the
+// consumer, both run freely and wrap through mask.
+struct job_runner_stream {
+
+    uint8_t* slots;
+    uint16_t* lengths;
+    uint32_t slot_size;
+    uint32_t mask;
+
+    uint32_t head;
+    uint32_t tail;
+
+    TaskHandle_t consumer;
+    uint32_t notify_bits;
+
+    struct job_runner_stream_stats stats;
+
+};
+
+struct job_runner_route {
+
+    int16_t job_id;
+    struct job_runner* owner;
+
+};
+
+struct job_runner_balancer {
+
+    struct job_runner** runners;
+    uint32_t* last_busy_us;
+    uint8_t* utilization;
+    uint8_t num_runners;
+    uint8_t threshold;
+    TickType_t period;
+
+    struct job_runner_route* routes;
+    uint16_t num_routes;
+
+    TaskHandle_t task_hnd;
+    xQueueHandle* done;
     int8_t started;
+    volatile int8_t stop;
 
 };
 
 enum cmd_type {
 
-    JR_CMD_TYPE_SHUTDOWN,
-    JR_CMD_TYPE_NOTIFY
+    JR_CMD_TYPE_NOTIFY,
+    JR_CMD_TYPE_MIGRATE,
+    JR_CMD_TYPE_ADOPT,
+    JR_CMD_TYPE_PAUSE,
+    JR_CMD_TYPE_RESUME,
+    JR_CMD_TYPE_SET_PERIOD,
+    JR_CMD_TYPE_SET_DEADLINE,
+    JR_CMD_TYPE_SET_OFFLOAD,
+    JR_CMD_TYPE_CALL,
+    JR_CMD_TYPE_OFFLOAD_DONE,
+    JR_CMD_TYPE_PUBLISH,
+    JR_CMD_TYPE_TIMER,
+    JR_CMD_TYPE_WAKE,
+    JR_CMD_TYPE_SHUTDOWN
 
 };
 
@@ -73,424 +407,7141 @@ struct job_cmd {
     int16_t job_id;
     void* cmd_data;
     void (*cmd_dtor)(void* cmd_data);
+    uint32_t cmd_arg;
+
+    // Handle of a delayed notification, cmd_arg is its due tick
+    uint32_t cmd_handle;
+
+    // esp_timer time the notification was sent, truncated, only differences are used
+    uint32_t enqueued_us;
+
+    // Send order of notifications and publishes across both lanes. Compared by wrapping difference, which only goes
+    // wrong with 2^31 notifications sent while one is pending.
+    uint32_t cmd_seq;
+
+    // Inline notification payload, used instead of cmd_data when inline_len is set
+    uint8_t inline_len;
+    uint8_t inline_data[JOB_RUNNER_INLINE_SIZE];
 
 };
 
-static void __job_runner_free_job(struct job_runner_job* job){
+struct job_runner_latency_request {
 
-    if(job->notif_data){
+    int16_t job_id;
+    struct job_runner_latency_stats* stats;
+    int8_t reset;
 
-        if(job->notif_dtor){
+};
 
-            job->notif_dtor(job->notif_data);
-            job->notif_dtor = NULL;
-        
-        }
-        
-        job->notif_data = NULL;
+struct job_runner_track_request {
 
-    }
+    int16_t job_id;
+    struct job_runner_latency_stats* stats;     // Allocated by the caller, handed back when the runner has no use for it
+    int8_t enable;
 
-    SAFE_FREE(job);
-}
+};
 
-static void __job_runner_free_runner(struct job_runner* runner){
+struct job_runner_inspect_request {
 
-    if(runner){
-        if(runner->cmd_queue){
-            vQueueDelete(runner->cmd_queue);
-        }
-    }
+    struct job_runner_info* info;
+    struct job_runner_job_info* jobs;
+    uint16_t max_jobs;
+    uint16_t filled;
 
-    SAFE_FREE(runner);
-}
+};
 
-static bool __job_runner_contains_job(struct job_runner* runner, int16_t job_id){
+struct job_runner_sub_request {
 
-    if(runner == NULL){
-        return false;
+    int16_t job_id;
+    job_runner_topic_t topic;
+    int8_t subscribe;
+
+};
+
+struct job_runner_call {
+
+    jrerr_t (*fn)(struct job_runner* runner, void* arg);
+    void* arg;
+    xQueueHandle* resp;
+
+};
+
+#define JOB_RUNNER_SNAPSHOT_MAGIC 0x4a52534e
+#define JOB_RUNNER_SNAPSHOT_VERSION 1
+
+#define JOB_RUNNER_SNAPSHOT_PAUSED 0x01
+#define JOB_RUNNER_SNAPSHOT_OFFLOAD 0x02
+#define JOB_RUNNER_SNAPSHOT_CONTEXT 0x04      // The context itself comes from the restore entry
+#define JOB_RUNNER_SNAPSHOT_PIN_PHASE 0x08
+
+struct job_runner_snapshot_header {
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+
+};
+
+struct job_runner_snapshot_entry {
+
+    int16_t job_id;
+    uint8_t flags;
+    uint8_t reserved;
+    uint32_t repeat_delay;
+    uint32_t next_in;           // Ticks from the snapshot to the next deadline
+
+};
+
+#define JOB_RUNNER_RECORD_MAGIC 0x4a525243
+#define JOB_RUNNER_RECORD_VERSION 1
+
+enum job_runner_record_type {
+
+    JOB_RUNNER_RECORD_ADD,          // arg period, arg2 ticks to the first run
+    JOB_RUNNER_RECORD_REMOVE,       // Done or migrated away
+    JOB_RUNNER_RECORD_NOTIFY,       // arg payload size
+    JOB_RUNNER_RECORD_RUN           // arg callback time in us
+
+};
+
+#define JOB_RUNNER_RECORD_INLINE 0x01
+
+struct job_runner_record_header {
+
+    uint32_t magic;
+    uint16_t version;
+    uint16_t tick_rate_hz;
+    uint32_t start_tick;
+    uint32_t count;
+
+};
+
+struct job_runner_record_entry {
+
+    uint8_t type;
+    uint8_t flags;
+    int16_t job_id;
+    uint32_t tick;
+    uint32_t arg;
+    uint32_t arg2;
+
+};
+
+struct job_runner_replay;
+
+// Context of one replayed job, the shared callback gets to its replay through it
+struct job_runner_replay_job {
+
+    struct job_runner_replay* replay;
+    uint32_t phase;
+    uint32_t period;
+    uint32_t remove_tick;
+    uint64_t busy_us;
+    uint32_t runs;
+    uint32_t mean_us;
+
+};
+
+struct job_runner_replay {
+
+    struct job_runner* runner;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_replay_job* jobs;
+    int16_t first_id;
+
+};
+
+struct job_runner_snapshot_request {
+
+    uint8_t* buffer;
+    size_t size;
+    size_t used;
+
+};
+
+// Groups are only ever appended and never freed, a handle stays valid after its runner is gone
+struct job_runner_done_group {
+
+    EventGroupHandle_t group;
+    uint32_t claimed;
+    int16_t index;
+    struct job_runner_done_group* next;
+
+};
+
+static struct job_runner_done_group* job_runner_done_groups = NULL;
+static portMUX_TYPE job_runner_done_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Shared by every balancer, a runner takes it to leave its balancer before it frees itself
+static SemaphoreHandle_t job_runner_balancer_lock = NULL;
+
+static struct job_runner_route* __job_runner_balancer_route(struct job_runner_balancer* balancer, int16_t job_id);
+static struct job_runner_done_group* __job_runner_done_group(int16_t slot);
+static jrerr_t __job_runner_call(struct job_runner* runner, jrerr_t (*fn)(struct job_runner* runner, void* arg), void* arg);
+static void __job_runner_console_forget(struct job_runner* runner);
+static void __job_runner_balancer_forget(struct job_runner* runner);
+
+// One flag test on top of the call, the flag sits next to the callback in the job
+static inline job_runner_state_t __job_runner_invoke(struct job_runner_job* job, job_runner_state_t state, void* data){
+
+    if(job->with_context){
+        return ((job_runner_context_callback_t) job->job_callback)(state, data, job->context);
     }
 
-    struct job_runner_job* start = runner->jobs;
-    
-    while( start != NULL ){
+    return ((job_runner_callback_t) job->job_callback)(state, data);
 
-        if(start->job_id == job_id){
-            return true;
-        }
+}
 
-        start = start->next;
+static TickType_t __job_runner_now(struct job_runner* runner){
 
+    // FreeRTOS ticks unless job_runner_set_clock replaced the clock
+    if(runner->clock.now != NULL){
+        return (TickType_t) runner->clock.now(runner->clock.ctx);
     }
 
-    return false;
+    return xTaskGetTickCount();
 
 }
 
-static jrerr_t __job_runner_find_job(struct job_runner* runner, struct job_runner_job** job, int16_t job_id){
-    
-    jrerr_t err = JR_SUCCESS;
+// Stamps for notification latency and lane waits. They follow a replaced clock, so a simulation or a replay measures
+// on its own timeline instead of however fast the host got through it.
+static uint32_t __job_runner_now_us(struct job_runner* runner){
 
-    if(runner == NULL || job == NULL){
-        err = JR_NULL_POINTER;
+    if(runner->clock.now != NULL){
+        return (uint32_t) (runner->clock.now(runner->clock.ctx) * portTICK_PERIOD_MS * 1000);
     }
 
-    if(err == JR_SUCCESS){
-    
-        struct job_runner_job* start = runner->jobs;
-        
-        while( start != NULL ){
+    return (uint32_t) esp_timer_get_time();
 
-            *job = NULL;
+}
 
-            if(start->job_id == job_id){
-                *job = start;
-                break;
-            }
+static uint32_t __job_runner_next_seq(struct job_runner* runner){
 
-            start = start->next;
+    return __atomic_add_fetch(&runner->notif_seq, 1, __ATOMIC_SEQ_CST);
 
-        }
+}
 
-        if(job == NULL){
-            err = JR_JOB_NOT_EXIST;
-        }
-    
-    }
+// What next_run counts from, the start offset until the runner anchored its jobs and the clock after
+static TickType_t __job_runner_base(struct job_runner* runner){
 
-    return err;
+    return runner->anchored ? __job_runner_now(runner) : 0;
 
 }
 
-static jrerr_t __job_runner_assign_job_id(struct job_runner* runner, struct job_runner_job* job){
+static uint32_t __job_runner_job_bytes(struct job_runner_job* job){
 
-    jrerr_t err = JR_SUCCESS;
+    // The block header of a descriptor table is left out, it is shared by the whole table
+    return sizeof(struct job_runner_job) + (job->latency ? sizeof(struct job_runner_latency_stats) : 0);
 
-    if(runner == NULL || job == NULL){
+}
 
-        err = JR_NULL_POINTER;
+static void __job_runner_track_peak(struct job_runner* runner){
+
+    uint32_t total = runner->job_bytes + __atomic_load_n(&runner->notif_bytes, __ATOMIC_SEQ_CST);
 
+    // A lost update under contention only makes the peak a little low
+    if(total > runner->peak_bytes){
+        runner->peak_bytes = total;
     }
 
-    if(err == JR_SUCCESS){
+}
 
-        int16_t id = 0;
+static void __job_runner_release_bytes(struct job_runner* runner, uint32_t size){
 
-        while( __job_runner_contains_job(runner, id) ){
+    if(runner != NULL && size > 0){
+        __atomic_sub_fetch(&runner->notif_bytes, size, __ATOMIC_SEQ_CST);
+    }
+
+}
+
+static void __job_runner_release_share(struct job_runner* runner, struct job_runner_share* share){
 
-            id++;
+    if(__atomic_sub_fetch(&share->refs, 1, __ATOMIC_SEQ_CST) == 0){
 
+        if(share->data != NULL && share->dtor != NULL){
+            share->dtor(share->data);
         }
 
-        job->job_id = id;
+        __job_runner_release_bytes(runner, sizeof(struct job_runner_share));
+        free(share);
 
     }
 
-    return err;
-
 }
 
-static jrerr_t __job_runner_process_notification(struct job_runner* runner, struct job_cmd* cmd){
+static void __job_runner_drop_notif(struct job_runner* runner, struct job_runner_job* job){
 
-    jrerr_t err = JR_SUCCESS;
+    __job_runner_release_bytes(runner, job->notif_size);
 
-    struct job_runner_job* job = NULL;
+    if(job->notif_share != NULL){
+
+        __job_runner_release_share(runner, job->notif_share);
 
-    if(runner == NULL || cmd == NULL){
-        err = JR_NULL_POINTER;
     }
+    else if(job->notif_data != NULL && job->notif_dtor != NULL){
 
-    if(err == JR_SUCCESS){
+        job->notif_dtor(job->notif_data);
 
-        err = __job_runner_find_job(runner, &job, cmd->job_id);
-    
     }
 
-    if(err == JR_SUCCESS){
+    job->notif_data = NULL;
+    job->notif_dtor = NULL;
+    job->notif_size = 0;
+    job->notif_share = NULL;
 
-        job->notif = 1;
-        job->notif_data = cmd->cmd_data;
-        job->notif_dtor = cmd->cmd_dtor;
+}
 
-        // Pass ownership of this data onto the notification system. 
-        cmd->cmd_data = NULL;
-        cmd->cmd_dtor = NULL;
+static void __job_runner_drop_subs(struct job_runner* runner, struct job_runner_job* job){
+
+    uint16_t kept = 0;
+
+    for(uint16_t i = 0; i < runner->num_subs; i++){
+
+        if(runner->subs[i].job != job){
+            runner->subs[kept++] = runner->subs[i];
+        }
 
     }
 
-    return err;
+    runner->num_subs = kept;
+    job->topics = 0;
 
 }
 
-static jrerr_t __job_runner_process_current(struct job_runner* runner, struct job_runner_job** in_current, struct job_runner_job** in_previous){
+static void __job_runner_record(struct job_runner* runner, uint8_t type, uint8_t flags, int16_t job_id, uint32_t arg, uint32_t arg2){
 
-    if(runner == NULL){
-        return JR_NULL_POINTER;
+    if(__atomic_load_n(&runner->rec_buffer, __ATOMIC_SEQ_CST) == NULL){
+        return;
     }
 
-    if(*in_current == NULL){
-        *in_previous = *in_current;
-        *in_current = runner->jobs;
-    }
+    // Counted before the buffer is read again, a stop that cleared it in between waits for this copy or we see NULL
+    __atomic_add_fetch(&runner->rec_writers, 1, __ATOMIC_SEQ_CST);
 
-    struct job_runner_job* previous = *in_previous;
-    struct job_runner_job* current = *in_current;
+    uint8_t* buffer = __atomic_load_n(&runner->rec_buffer, __ATOMIC_SEQ_CST);
+
+    if(buffer != NULL){
+
+        struct job_runner_record_entry entry = { .type = type, .flags = flags, .job_id = job_id, .tick = __job_runner_now(runner), .arg = arg, .arg2 = arg2 };
+        uint32_t index = __atomic_fetch_add(&runner->rec_next, 1, __ATOMIC_SEQ_CST);
+
+        if(index < runner->rec_capacity){
+            memcpy(buffer + sizeof(struct job_runner_record_header) + index * sizeof(entry), &entry, sizeof(entry));
+        }
+        else {
+            __atomic_add_fetch(&runner->rec_dropped, 1, __ATOMIC_SEQ_CST);
+        }
 
-    if(current == NULL){
-        return JR_NULL_POINTER;
     }
 
-    TickType_t now = xTaskGetTickCount();
-    TickType_t elapsed = now - current->last_run;
+    __atomic_sub_fetch(&runner->rec_writers, 1, __ATOMIC_SEQ_CST);
 
-    if( (elapsed >= current->repeat_delay) || current->notif || (runner->state == JOB_RUNNER_SHUT_DOWN) ){
+}
 
-        job_runner_state_t job_state = current->job_callback(runner->state, current->notif_data);
-        if(job_state == JOB_RUNNER_IM_DONE){
-            if(previous == NULL){
-                // We must be at the head
-                runner->jobs = current->next;
-                __job_runner_free_job(current);
-                current = runner->jobs;
-            } 
-            else {
-                previous->next = current->next;
-                __job_runner_free_job(current);
-                current = previous->next;
-            }
-            
-            *in_previous = previous;
-            *in_current = current;
+static void __job_runner_record_add(struct job_runner* runner, struct job_runner_job* job){
 
-        } 
-        else {
+    int32_t next_in = (int32_t) (job->next_run - __job_runner_base(runner));
 
-            current->last_run = xTaskGetTickCount();
-            *in_previous = current;
-            *in_current = current->next;
+    __job_runner_record(runner, JOB_RUNNER_RECORD_ADD, 0, job->job_id, job->repeat_delay, (next_in > 0) ? next_in : 0);
 
-            current->notif = 0;
-            if(current->notif_data){
+}
 
-                if(current->notif_dtor){
+static void __job_runner_free_job(struct job_runner* runner, struct job_runner_job* job){
 
-                    current->notif_dtor(current->notif_data);
-                    current->notif_dtor = NULL;
-                
-                }
-                
-                current->notif_data = NULL;
+    if(runner != NULL){
 
-            }
+        runner->job_bytes -= __job_runner_job_bytes(job);
+        __job_runner_release_bytes(runner, job->offload_size);
 
+        // The index holds plain pointers, nothing may point at the job once it is gone
+        if(job->topics > 0){
+            __job_runner_drop_subs(runner, job);
         }
 
-    } 
-    else {
+    }
 
-        *in_previous = current;
-        *in_current = current->next;
-    
+    __job_runner_drop_notif(runner, job);
+
+    if(job->offload_share != NULL){
+        __job_runner_release_share(runner, job->offload_share);
+    }
+    else if(job->offload_data && job->offload_dtor){
+        job->offload_dtor(job->offload_data);
     }
 
-    return JR_SUCCESS;
+    SAFE_FREE(job->latency);
 
-}
+    if(job->pooled){
+
+        struct job_runner_job_block* block = (struct job_runner_job_block*) ((uint8_t*) (job - job->block_index) - offsetof(struct job_runner_job_block, jobs));
+
+        // Jobs of one block can end up on different runners after a migration
+        if(__atomic_sub_fetch(&block->live, 1, __ATOMIC_SEQ_CST) == 0){
+            free(block);
+        }
 
-static jrerr_t __job_runner_process_command(struct job_runner* runner){
-    
-    if(runner == NULL){
-        return JR_NULL_POINTER;
     }
+    else {
+
+        SAFE_FREE(job);
+
+    }
+}
+
+// Nobody is left to process the command, release whatever it carries
+static void __job_runner_release_cmd(struct job_cmd* cmd){
+
+    if(cmd->type == JR_CMD_TYPE_CALL){
+
+        struct job_runner_call* call = (struct job_runner_call*) cmd->cmd_data;
+        jrerr_t resp = JR_NOT_STARTED;
+        xQueueSend(call->resp, &resp, portMAX_DELAY);
+
+    }
+    else if(cmd->type == JR_CMD_TYPE_ADOPT && cmd->cmd_data != NULL){
+
+        __job_runner_free_job(NULL, cmd->cmd_data);
+
+    }
+    else if((cmd->type == JR_CMD_TYPE_NOTIFY || cmd->type == JR_CMD_TYPE_PUBLISH || cmd->type == JR_CMD_TYPE_TIMER) && cmd->cmd_data != NULL && cmd->cmd_dtor != NULL){
+
+        cmd->cmd_dtor(cmd->cmd_data);
+
+    }
+
+}
+
+static void __job_runner_release_cmds(xQueueHandle* queue){
+
+    struct job_cmd cmd;
+
+    while( xQueueReceive(queue, &cmd, 0) == pdTRUE ){
+
+        __job_runner_release_cmd(&cmd);
+
+    }
+
+}
+
+static void __job_runner_drain_queue(xQueueHandle* queue){
+
+    __job_runner_release_cmds(queue);
+    vQueueDelete(queue);
+
+}
+
+static void __job_runner_free_runner(struct job_runner* runner){
+
+    if(runner){
+
+        if(runner->ctl_queue){
+            __job_runner_drain_queue(runner->ctl_queue);
+        }
+
+        if(runner->cmd_queue){
+            __job_runner_drain_queue(runner->cmd_queue);
+        }
+
+        for(uint16_t i = 0; i < runner->num_notif_slots; i++){
+
+            struct job_runner_notif_slot* slot = &runner->notif_slots[i];
+            if(slot->data && slot->dtor){
+                slot->dtor(slot->data);
+            }
+
+        }
+
+        for(uint16_t i = 0; i < runner->num_timers; i++){
+
+            struct job_runner_timer* timer = &runner->timers[i];
+            if(timer->data && timer->dtor){
+                timer->dtor(timer->data);
+            }
+
+        }
+
+        SAFE_FREE(runner->notif_slots);
+        SAFE_FREE(runner->subs);
+        SAFE_FREE(runner->timers);
+
+        if(runner->notif_lock){
+            vSemaphoreDelete(runner->notif_lock);
+        }
+
+        if(runner->offload_queue){
+            vQueueDelete(runner->offload_queue);
+        }
+
+        if(runner->helpers_exited){
+            vSemaphoreDelete(runner->helpers_exited);
+        }
+
+        SAFE_FREE(runner->hot_next_run);
+        SAFE_FREE(runner->hot_state);
+        SAFE_FREE(runner->hot_jobs);
+    }
+
+    SAFE_FREE(runner);
+}
+
+static bool __job_runner_contains_job(struct job_runner* runner, int16_t job_id){
+
+    if(runner == NULL){
+        return false;
+    }
+
+    struct job_runner_job* start = runner->jobs;
+    
+    while( start != NULL ){
+
+        if(start->job_id == job_id){
+            return true;
+        }
+
+        start = start->next;
+
+    }
+
+    for(start = runner->paused; start != NULL; start = start->next){
+
+        if(start->job_id == job_id){
+            return true;
+        }
+
+    }
+
+    return false;
+
+}
+
+static jrerr_t __job_runner_find_job(struct job_runner* runner, struct job_runner_job** job, int16_t job_id){
+    
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || job == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+    
+        struct job_runner_job* start = runner->jobs;
+
+        *job = NULL;
+        
+        while( start != NULL ){
+
+            if(start->job_id == job_id){
+                *job = start;
+                break;
+            }
+
+            start = start->next;
+
+        }
+
+        if(*job == NULL){
+            err = JR_JOB_NOT_EXIST;
+        }
+    
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_find_paused_job(struct job_runner* runner, struct job_runner_job** job, struct job_runner_job** previous, int16_t job_id){
+
+    *job = NULL;
+    *previous = NULL;
+
+    for(struct job_runner_job* start = runner->paused; start != NULL; start = start->next){
+
+        if(start->job_id == job_id){
+            *job = start;
+            break;
+        }
+
+        *previous = start;
+
+    }
+
+    return (*job == NULL) ? JR_JOB_NOT_EXIST : JR_SUCCESS;
+
+}
+
+static uint8_t __job_runner_hot_state(struct job_runner_job* job){
+
+    return (job->notif ? JOB_RUNNER_HOT_NOTIF : 0) | (job->in_flight ? JOB_RUNNER_HOT_BLOCKED : 0);
+
+}
+
+static void __job_runner_hot_sync(struct job_runner* runner, struct job_runner_job* job){
+
+    // Paused and migrated jobs are not in the table, neither is anything linked since the last rebuild
+    if( ! runner->hot_dirty && job->hot_index < runner->hot_count && runner->hot_jobs[job->hot_index] == job ){
+
+        runner->hot_next_run[job->hot_index] = job->next_run;
+        runner->hot_state[job->hot_index] = __job_runner_hot_state(job);
+
+    }
+
+}
+
+static uint32_t __job_runner_count_jobs(struct job_runner* runner){
+
+    uint32_t count = 0;
+
+    struct job_runner_job* lists[] = { runner->jobs, runner->paused };
+
+    for(int l = 0; l < 2; l++){
+        for(struct job_runner_job* job = lists[l]; job != NULL; job = job->next){
+            count++;
+        }
+    }
+
+    return count;
+
+}
+
+// Makes room for count jobs in the hot table. Called where jobs join the runner, never from dispatch.
+static jrerr_t __job_runner_hot_reserve(struct job_runner* runner, uint32_t count){
+
+    if(count <= runner->hot_capacity){
+        return JR_SUCCESS;
+    }
+
+    uint32_t capacity = count + count / 2 + 8;
+
+    // Each array keeps whatever it got, the capacity only moves once all three have grown
+    TickType_t* next_run = realloc(runner->hot_next_run, capacity * sizeof(TickType_t));
+    if(next_run != NULL){
+        runner->hot_next_run = next_run;
+    }
+
+    uint8_t* state = realloc(runner->hot_state, capacity * sizeof(uint8_t));
+    if(state != NULL){
+        runner->hot_state = state;
+    }
+
+    struct job_runner_job** jobs = realloc(runner->hot_jobs, capacity * sizeof(struct job_runner_job*));
+    if(jobs != NULL){
+        runner->hot_jobs = jobs;
+    }
+
+    if(next_run == NULL || state == NULL || jobs == NULL){
+        return JR_MEMORY_ALLOC_FAIL;
+    }
+
+    runner->job_bytes += (capacity - runner->hot_capacity) * (sizeof(TickType_t) + sizeof(uint8_t) + sizeof(struct job_runner_job*));
+    runner->hot_capacity = capacity;
+
+    return JR_SUCCESS;
+
+}
+
+static void __job_runner_hot_renumber(struct job_runner* runner, uint32_t from){
+
+    for(uint32_t i = from; i < runner->hot_count; i++){
+        runner->hot_jobs[i]->hot_index = i;
+    }
+
+}
+
+// Later entries move down one instead of the last one filling the gap, the scan order stays the list order
+static void __job_runner_hot_remove(struct job_runner* runner, struct job_runner_job* job){
+
+    uint32_t index = job->hot_index;
+
+    if(runner->hot_dirty || index >= runner->hot_count || runner->hot_jobs[index] != job){
+        return;
+    }
+
+    uint32_t tail = runner->hot_count - index - 1;
+
+    memmove(&runner->hot_next_run[index], &runner->hot_next_run[index + 1], tail * sizeof(TickType_t));
+    memmove(&runner->hot_state[index], &runner->hot_state[index + 1], tail * sizeof(uint8_t));
+    memmove(&runner->hot_jobs[index], &runner->hot_jobs[index + 1], tail * sizeof(struct job_runner_job*));
+
+    runner->hot_count--;
+    __job_runner_hot_renumber(runner, index);
+
+    // The entry the cursor pointed at moved down with the rest
+    if(runner->hot_cursor > index){
+        runner->hot_cursor--;
+    }
+
+}
+
+// For a job just linked at the head of the list, the list and the table keep the same order
+static void __job_runner_hot_insert(struct job_runner* runner, struct job_runner_job* job){
+
+    if(runner->hot_dirty){
+        return;
+    }
+
+    if(runner->hot_count >= runner->hot_capacity){
+        runner->hot_dirty = 1;
+        return;
+    }
+
+    uint32_t count = runner->hot_count;
+
+    memmove(&runner->hot_next_run[1], &runner->hot_next_run[0], count * sizeof(TickType_t));
+    memmove(&runner->hot_state[1], &runner->hot_state[0], count * sizeof(uint8_t));
+    memmove(&runner->hot_jobs[1], &runner->hot_jobs[0], count * sizeof(struct job_runner_job*));
+
+    runner->hot_jobs[0] = job;
+    runner->hot_next_run[0] = job->next_run;
+    runner->hot_state[0] = __job_runner_hot_state(job);
+
+    runner->hot_count++;
+    __job_runner_hot_renumber(runner, 0);
+
+    // Keeps pointing at the same job, the new one is visited from the next pass on
+    if(runner->hot_cursor > 0){
+        runner->hot_cursor++;
+    }
+
+}
+
+// Lays the table out from the list again. It never allocates: jobs that do not fit, only possible after an adoption
+// that could not grow the table, stay out and hot_short has the next loop try to reserve room for them.
+static void __job_runner_hot_rebuild(struct job_runner* runner){
+
+    uint32_t index = 0;
+    struct job_runner_job* job = runner->jobs;
+
+    for( ; job != NULL && index < runner->hot_capacity; job = job->next){
+
+        job->hot_index = index;
+        runner->hot_jobs[index] = job;
+        runner->hot_next_run[index] = job->next_run;
+        runner->hot_state[index] = __job_runner_hot_state(job);
+        index++;
+
+    }
+
+    runner->hot_count = index;
+    runner->hot_short = (job != NULL);
+    runner->hot_dirty = runner->hot_short;
+
+    if(runner->hot_cursor > index){
+        runner->hot_cursor = index;
+    }
+
+}
+
+static void __job_runner_unlink_job(struct job_runner* runner, struct job_runner_job* job){
+
+    struct job_runner_job* previous = NULL;
+    struct job_runner_job* start = runner->jobs;
+
+    while( start != NULL && start != job ){
+        previous = start;
+        start = start->next;
+    }
+
+    if(start == NULL){
+        return;
+    }
+
+    if(previous == NULL){
+        runner->jobs = job->next;
+    }
+    else {
+        previous->next = job->next;
+    }
+
+    job->next = NULL;
+    __job_runner_hot_remove(runner, job);
+
+}
+
+static void __job_runner_link_job(struct job_runner* runner, struct job_runner_job* job){
+
+    job->next = runner->jobs;
+    runner->jobs = job;
+    __job_runner_hot_insert(runner, job);
+
+}
+
+static uint32_t __job_runner_hot_scan(struct job_runner* runner, TickType_t now, uint8_t force){
+
+    const TickType_t* next_run = runner->hot_next_run;
+    const uint8_t* state = runner->hot_state;
+    uint32_t count = runner->hot_count;
+    uint32_t found = count;
+    int32_t until = JOB_RUNNER_FAR_FUTURE;
+
+    for(uint32_t i = runner->hot_cursor; i < count && found == count; i += JOB_RUNNER_SCAN_BLOCK){
+
+        uint32_t end = (count - i < JOB_RUNNER_SCAN_BLOCK) ? count : i + JOB_RUNNER_SCAN_BLOCK;
+        uint8_t any = 0;
+
+        for(uint32_t k = i; k < end; k++){
+
+            int32_t left = (int32_t) (next_run[k] - now);
+            uint8_t open = ! (state[k] & JOB_RUNNER_HOT_BLOCKED);
+            uint8_t ready = open & ((left <= 0) | ((state[k] & JOB_RUNNER_HOT_NOTIF) != 0) | force);
+
+            any |= ready;
+
+            // Ready jobs note their new deadline once they run, jobs on a helper once they come back
+            left = (open & ! ready) ? left : JOB_RUNNER_FAR_FUTURE;
+            until = (left < until) ? left : until;
+
+        }
+
+        for(uint32_t k = i; any && k < end; k++){
+
+            if( ! (state[k] & JOB_RUNNER_HOT_BLOCKED) && ((int32_t) (next_run[k] - now) <= 0 || (state[k] & JOB_RUNNER_HOT_NOTIF) || force) ){
+                found = k;
+                break;
+            }
+
+        }
+
+    }
+
+    if((int32_t) ((now + until) - runner->pass_next_due) < 0){
+        runner->pass_next_due = now + until;
+    }
+
+    return found;
+
+}
+
+// Only used while calibrating, resets the watermark so the next callback is measured on its own. Painted from the stack
+// base up to this function's own frame minus the base save area, word by word so no callee frame lands in the range.
+// An interrupt taken meanwhile saves its context below the frame and is done with it before painting carries on.
+static void __attribute__((noinline)) __job_runner_paint_stack(void){
+
+    const uint32_t fill = JOB_RUNNER_STACK_FILL_BYTE * 0x01010101u;
+    volatile uint32_t* word = (volatile uint32_t*) pxTaskGetStackStart(NULL);
+    uintptr_t limit = (uintptr_t) __builtin_frame_address(0) - JOB_RUNNER_STACK_SAVE_AREA;
+
+    while(word != NULL && (uintptr_t) (word + 1) <= limit){
+        *word++ = fill;
+    }
+
+}
+
+static void __job_runner_track_stack(struct job_runner* runner, struct job_runner_job* job){
+
+    // On ESP-IDF the watermark is reported in bytes, same unit as runner_stack
+    uint32_t free_bytes = uxTaskGetStackHighWaterMark(NULL);
+    uint32_t used = 0;
+
+    if(runner->stack_size > free_bytes){
+        used = runner->stack_size - free_bytes;
+    }
+
+    if(runner->calibrating || free_bytes < runner->stack_min_free){
+
+        // Outside of calibration the watermark only moves when a job goes deeper than all before it
+        if(used > job->stack_used){
+            job->stack_used = used;
+        }
+
+    }
+
+    if(free_bytes < runner->stack_min_free){
+        runner->stack_min_free = free_bytes;
+        runner->stack_deepest_job = job->job_id;
+    }
+
+    if(runner->calibrating){
+        ESP_LOGI("Job Runner","Job %d used %u bytes of stack", (int) job->job_id, (unsigned int) used);
+    }
+
+}
+
+static struct job_runner_notif_slot* __job_runner_find_notif_slot(struct job_runner* runner, int16_t job_id){
+
+    // The slot table is fixed once the runner is started so producers can search it without locking
+    for(uint16_t i = 0; i < runner->num_notif_slots; i++){
+
+        if(runner->notif_slots[i].job_id == job_id){
+            return &runner->notif_slots[i];
+        }
+
+    }
+
+    return NULL;
+
+}
+
+static jrerr_t __job_runner_coalesce_notification(struct job_runner* runner, struct job_runner_notif_slot* slot, void* notif_data, void (*notif_dtor)(void* nd), uint32_t notif_size, uint8_t inline_len, int8_t* send){
+
+    jrerr_t err = JR_SUCCESS;
+
+    void* stale_data = NULL;
+    void (*stale_dtor)(void* nd) = NULL;
+    uint32_t stale_size = 0;
+    void* spent_data = NULL;
+    void (*spent_dtor)(void* nd) = NULL;
+
+    *send = 1;
+
+    xSemaphoreTake(runner->notif_lock, portMAX_DELAY);
+
+    if(slot->rate > 0){
+
+        TickType_t now = __job_runner_now(runner);
+        TickType_t elapsed = now - slot->refill_tick;
+        slot->refill_tick = now;
+
+        if(elapsed >= slot->capacity / slot->rate){
+            slot->tokens = slot->capacity;
+        }
+        else {
+            uint32_t refill = elapsed * slot->rate;
+            slot->tokens = (refill >= slot->capacity - slot->tokens) ? slot->capacity : slot->tokens + refill;
+        }
+
+        if(slot->tokens < configTICK_RATE_HZ){
+            slot->stats.dropped++;
+            err = JR_RATE_LIMITED;
+        }
+        else {
+            slot->tokens -= configTICK_RATE_HZ;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && slot->mode != JOB_RUNNER_COALESCE_NONE){
+
+        // Only the first notification of a burst uses a queue slot, the rest fold into the pending payload
+        *send = ! slot->queued;
+
+        if( ! slot->queued ){
+
+            slot->queued = 1;
+            slot->data = notif_data;
+            slot->dtor = notif_dtor;
+            slot->size = notif_size;
+
+        }
+        else if(slot->mode == JOB_RUNNER_COALESCE_MERGE && slot->merge != NULL && slot->data != NULL && notif_data != NULL){
+
+            void* merged = slot->merge(slot->data, notif_data);
+
+            // Whichever input did not become the result is no longer needed
+            if(merged == slot->data){
+                stale_data = notif_data;
+                stale_dtor = notif_dtor;
+                stale_size = notif_size;
+            }
+            else if(merged == notif_data){
+                stale_data = slot->data;
+                stale_dtor = slot->dtor;
+                stale_size = slot->size;
+                slot->dtor = notif_dtor;
+                slot->size = notif_size;
+            }
+            else {
+
+                // A new result takes over the pending payload's destructor and size, both inputs go
+                stale_data = slot->data;
+                stale_dtor = slot->dtor;
+                stale_size = notif_size;
+                spent_data = notif_data;
+                spent_dtor = notif_dtor;
+
+            }
+
+            slot->data = merged;
+            slot->stats.merged++;
+
+        }
+        else {
+
+            stale_data = slot->data;
+            stale_dtor = slot->dtor;
+            stale_size = slot->size;
+
+            slot->data = notif_data;
+            slot->dtor = notif_dtor;
+            slot->size = notif_size;
+            slot->stats.coalesced++;
+
+        }
+
+        // An inline payload only points at the caller's bytes, keep a copy if it is the one that stayed
+        if(inline_len > 0 && slot->data == notif_data){
+
+            memcpy(slot->inline_data, notif_data, inline_len);
+            slot->inline_len = inline_len;
+            slot->data = slot->inline_data;
+
+        }
+
+    }
+
+    xSemaphoreGive(runner->notif_lock);
+
+    __job_runner_release_bytes(runner, stale_size);
+
+    if(stale_data != NULL && stale_dtor != NULL){
+        stale_dtor(stale_data);
+    }
+
+    if(spent_data != NULL && spent_dtor != NULL){
+        spent_dtor(spent_data);
+    }
+
+    return err;
+
+}
+
+static void __job_runner_take_coalesced(struct job_runner* runner, struct job_runner_job* job){
+
+    struct job_runner_notif_slot* slot = job->notif_slot;
+
+    xSemaphoreTake(runner->notif_lock, portMAX_DELAY);
+
+    if(slot->data == NULL){
+
+        // Only a published payload is pending, topics do not go through the slot
+        slot->queued = 0;
+        xSemaphoreGive(runner->notif_lock);
+        return;
+
+    }
+
+    // The slot holds the newer payload, a published one delivered meanwhile gives way
+    if(job->notif_data != NULL){
+        __job_runner_drop_notif(runner, job);
+    }
+
+    job->notif_data = slot->data;
+    job->notif_dtor = slot->dtor;
+    job->notif_size = slot->size;
+
+    if(slot->data == slot->inline_data){
+        memcpy(job->notif_inline, slot->inline_data, slot->inline_len);
+        job->notif_data = job->notif_inline;
+    }
+
+    slot->data = NULL;
+    slot->dtor = NULL;
+    slot->size = 0;
+    slot->queued = 0;
+
+    xSemaphoreGive(runner->notif_lock);
+
+}
+
+static void __job_runner_latency_add(struct job_runner_latency_hist* hist, uint32_t us){
+
+    // Bucket i holds [2^i, 2^(i+1)) us, one clz per sample
+    uint32_t bucket = (us < 2) ? 0 : 31 - __builtin_clz(us);
+
+    if(bucket >= JOB_RUNNER_LATENCY_BUCKETS){
+        bucket = JOB_RUNNER_LATENCY_BUCKETS - 1;
+    }
+
+    hist->buckets[bucket]++;
+    hist->count++;
+    hist->total_us += us;
+
+    if(us > hist->max_us){
+        hist->max_us = us;
+    }
+
+}
+
+static void __job_runner_record_latency(struct job_runner* runner, struct job_runner_job* job, uint32_t entry_us){
+
+    uint32_t queue_us = job->notif_dequeued_us - job->notif_enqueued_us;
+    uint32_t dispatch_us = entry_us - job->notif_dequeued_us;
+
+    __job_runner_latency_add(&runner->latency.queue, queue_us);
+    __job_runner_latency_add(&runner->latency.dispatch, dispatch_us);
+    __job_runner_latency_add(&runner->latency.total, queue_us + dispatch_us);
+
+    // Only jobs tracked with job_runner_track_latency have their own histograms, the runner's count every job
+    if(job->latency != NULL){
+
+        __job_runner_latency_add(&job->latency->queue, queue_us);
+        __job_runner_latency_add(&job->latency->dispatch, dispatch_us);
+        __job_runner_latency_add(&job->latency->total, queue_us + dispatch_us);
+
+    }
+
+}
+
+static jrerr_t __job_runner_process_notification(struct job_runner* runner, struct job_cmd* cmd){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_job* job = NULL;
+
+    if(runner == NULL || cmd == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_find_job(runner, &job, cmd->job_id);
+
+        if(err == JR_JOB_NOT_EXIST){
+
+            // A paused job keeps its notification until it is resumed
+            struct job_runner_job* previous = NULL;
+            err = __job_runner_find_paused_job(runner, &job, &previous, cmd->job_id);
+
+        }
+    
+    }
+
+    if(err == JR_SUCCESS && job->notif_slot != NULL && job->notif_slot->mode != JOB_RUNNER_COALESCE_NONE){
+
+        // Latency is measured from the oldest notification folded into the pending run
+        if( ! job->notif ){
+            job->notif_enqueued_us = cmd->enqueued_us;
+            job->notif_dequeued_us = __job_runner_now_us(runner);
+        }
+
+        job->notif_seq = cmd->cmd_seq;
+
+        // The payload waits in the slot until the job runs so later notifications can still fold into it
+        job->notif = 1;
+        __job_runner_hot_sync(runner, job);
+
+    }
+    else if(err == JR_SUCCESS && job->notif && (int32_t) (cmd->cmd_seq - job->notif_seq) < 0){
+
+        // Sent before the pending one, which took the control lane and got here first. The newer one stays, this
+        // payload is left in cmd for the caller to destroy. Without a destructor there is nothing to destroy, the
+        // caller still owns it.
+        if(cmd->cmd_dtor == NULL && cmd->cmd_data != NULL){
+            __job_runner_release_bytes(runner, cmd->cmd_arg);
+            cmd->cmd_data = NULL;
+        }
+
+    }
+    else if(err == JR_SUCCESS){
+
+        if(job->notif){
+
+            // The replaced notification is still a sample, its wait ends here instead of in the callback
+            __job_runner_record_latency(runner, job, __job_runner_now_us(runner));
+
+        }
+
+        if(job->notif_data != NULL){
+
+            // A second notification before the job ran replaces the first, which used to be lost without its destructor
+            __job_runner_drop_notif(runner, job);
+
+        }
+
+        job->notif = 1;
+        job->notif_enqueued_us = cmd->enqueued_us;
+        job->notif_dequeued_us = __job_runner_now_us(runner);
+        job->notif_seq = cmd->cmd_seq;
+        job->notif_data = cmd->cmd_data;
+        job->notif_dtor = cmd->cmd_dtor;
+        job->notif_size = (cmd->cmd_data != NULL) ? cmd->cmd_arg : 0;
+
+        if(cmd->inline_len > 0){
+            memcpy(job->notif_inline, cmd->inline_data, cmd->inline_len);
+            job->notif_data = job->notif_inline;
+        }
+
+        __job_runner_hot_sync(runner, job);
+
+        // Pass ownership of this data onto the notification system. 
+        cmd->cmd_data = NULL;
+        cmd->cmd_dtor = NULL;
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_note_deadline(struct job_runner* runner, struct job_runner_job* job){
+
+    if((int32_t) (job->next_run - runner->pass_next_due) < 0){
+        runner->pass_next_due = job->next_run;
+    }
+
+}
+
+static uint32_t __job_runner_job_wcet(struct job_runner_job* job){
+
+    return job->wcet_us ? job->wcet_us : job->wcet_measured_us;
+
+}
+
+// Share of the runner task in 1/1000000, a period of 0 runs every loop and is charged once per tick
+static uint64_t __job_runner_utilization(uint32_t wcet_us, TickType_t period){
+
+    uint64_t period_us = (uint64_t) (period > 0 ? period : 1) * portTICK_PERIOD_MS * 1000;
+
+    return ((uint64_t) wcet_us * 1000000) / period_us;
+
+}
+
+static void __job_runner_sched_add(struct job_runner* runner, struct job_runner_job* job, struct job_runner_sched_stats* stats, uint64_t* total){
+
+    for( ; job != NULL; job = job->next){
+
+        if(job->offload && runner->num_helpers > 0){
+            continue;
+        }
+
+        uint32_t wcet_us = __job_runner_job_wcet(job);
+
+        stats->periodic_jobs++;
+
+        if(wcet_us == 0){
+            stats->unknown_jobs++;
+        }
+
+        *total += __job_runner_utilization(wcet_us, job->repeat_delay);
+
+    }
+
+}
+
+// Paused jobs count too, resuming one must not be what overloads the runner. extra_jobs and extra are a change that
+// has not been applied yet.
+static void __job_runner_sched_stats(struct job_runner* runner, uint16_t extra_jobs, uint64_t extra, struct job_runner_sched_stats* stats){
+
+    uint64_t total = extra;
+
+    memset(stats, 0, sizeof(struct job_runner_sched_stats));
+
+    __job_runner_sched_add(runner, runner->jobs, stats, &total);
+    __job_runner_sched_add(runner, runner->paused, stats, &total);
+
+    stats->periodic_jobs += extra_jobs;
+    stats->utilization = (uint32_t) ((total + 999) / 1000);
+
+    if(runner->bound == JOB_RUNNER_BOUND_EDF){
+        stats->bound = 1000;
+    }
+    else if(stats->periodic_jobs < sizeof(job_runner_rm_bounds) / sizeof(job_runner_rm_bounds[0])){
+        stats->bound = job_runner_rm_bounds[stats->periodic_jobs];
+    }
+    else {
+        stats->bound = JOB_RUNNER_RM_LIMIT;
+    }
+
+    stats->headroom = (int32_t) stats->bound - (int32_t) stats->utilization;
+    stats->calibrating = runner->wcet_calibrating;
+
+}
+
+// Changes that are already applied can only be reported, can_reject is 0 for those
+static jrerr_t __job_runner_admit(struct job_runner* runner, uint16_t extra_jobs, uint64_t extra, int8_t can_reject){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_sched_stats stats;
+
+    if(runner->admission == JOB_RUNNER_ADMIT_OFF){
+        return err;
+    }
+
+    __job_runner_sched_stats(runner, extra_jobs, extra, &stats);
+
+    if(stats.headroom < 0){
+
+        ESP_LOGE("Job Runner","%s: utilization %u.%u%% over the %s bound of %u.%u%% with %u jobs",
+            (can_reject && runner->admission == JOB_RUNNER_ADMIT_REJECT) ? "Rejected" : "Unschedulable",
+            (unsigned int) (stats.utilization / 10), (unsigned int) (stats.utilization % 10), (runner->bound == JOB_RUNNER_BOUND_EDF) ? "EDF" : "RM",
+            (unsigned int) (stats.bound / 10), (unsigned int) (stats.bound % 10), (unsigned int) stats.periodic_jobs);
+
+        if(can_reject && runner->admission == JOB_RUNNER_ADMIT_REJECT){
+            err = JR_UNSCHEDULABLE;
+        }
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_check_calibration(struct job_runner* runner, TickType_t now){
+
+    if(runner->wcet_calibrating && (int32_t) (now - runner->wcet_window_end) >= 0){
+
+        struct job_runner_sched_stats stats;
+
+        runner->wcet_calibrating = 0;
+        __job_runner_sched_stats(runner, 0, 0, &stats);
+
+        ESP_LOGI("Job Runner","WCET calibration done, utilization %u.%u%%, headroom %d.%u%%, %u of %u jobs never ran",
+            (unsigned int) (stats.utilization / 10), (unsigned int) (stats.utilization % 10), (int) (stats.headroom / 10),
+            (unsigned int) ((stats.headroom < 0 ? -stats.headroom : stats.headroom) % 10), (unsigned int) stats.unknown_jobs, (unsigned int) stats.periodic_jobs);
+
+        // Already running, the measured set can only be reported
+        __job_runner_admit(runner, 0, 0, 0);
+
+    }
+
+}
+
+// Shortens delay so the runner is awake when the earliest delayed notification is due
+static TickType_t __job_runner_timer_delay(struct job_runner* runner, TickType_t delay){
+
+    if(runner->num_timers > 0){
+
+        int32_t until_due = (int32_t) (runner->timers[0].due - __job_runner_now(runner));
+
+        if(until_due < (int32_t) delay){
+            delay = (until_due > 0) ? (TickType_t) until_due : 0;
+        }
+
+    }
+
+    return delay;
+
+}
+
+static void __job_runner_sleep(struct job_runner* runner, int8_t busy){
+
+    if( ! runner->adaptive ){
+
+        TickType_t delay = __job_runner_timer_delay(runner, runner->loop_delay);
+
+        runner->effective_delay = delay;
+
+        if(runner->clock.sleep != NULL){
+            runner->clock.sleep(runner->clock.ctx, delay);
+        }
+        else {
+            vTaskDelay(delay);
+        }
+
+        return;
+
+    }
+
+    TickType_t delay = runner->effective_delay;
+
+    if(busy){
+
+        // Work is coming in, stay at the floor until things quiet down
+        delay = runner->delay_floor;
+
+    }
+    else {
+
+        delay = (delay > 0) ? delay * 2 : 1;
+
+    }
+
+    if(delay > runner->delay_ceiling){
+        delay = runner->delay_ceiling;
+    }
+
+    if(runner->jobs != NULL){
+
+        // Never sleep past the earliest deadline seen in the last pass
+        int32_t until_due = (int32_t) (runner->next_due - __job_runner_now(runner));
+
+        if(until_due < (int32_t) delay){
+            delay = (until_due > (int32_t) runner->delay_floor) ? (TickType_t) until_due : runner->delay_floor;
+        }
+
+    }
+
+    // Delayed notifications are not held to the floor, they were asked for a tick
+    delay = __job_runner_timer_delay(runner, delay);
+
+    runner->effective_delay = delay;
+
+    if(delay > 0 && runner->clock.sleep != NULL){
+
+        runner->clock.sleep(runner->clock.ctx, delay);
+
+    }
+    else if(delay > 0 && uxQueueMessagesWaiting(runner->ctl_queue) == 0){
+
+        // Peek so a new command ends the sleep early without being taken off the queue. Control commands sent from
+        // here on come with a wake command, the ones already waiting are taken without sleeping.
+        struct job_cmd cmd;
+        xQueuePeek(runner->cmd_queue, &cmd, delay);
+
+    }
+
+}
+
+static void __job_runner_check_boost(struct job_runner* runner){
+
+    struct job_runner_boost* boost = &runner->boost;
+
+    TickType_t now = __job_runner_now(runner);
+    uint32_t queued = uxQueueMessagesWaiting(runner->cmd_queue) + uxQueueMessagesWaiting(runner->ctl_queue);
+
+    // Raised past the on levels, lowered only below the off levels, so a runner on the edge does not flap
+    int8_t behind = (boost->late_on > 0 && runner->backlog_late >= boost->late_on) || (boost->queue_on > 0 && queued >= boost->queue_on);
+    int8_t caught_up = (boost->late_on == 0 || runner->backlog_late <= boost->late_off) && (boost->queue_on == 0 || queued <= boost->queue_off);
+
+    // Simulated runners have no task, they only keep the stats
+    int8_t has_task = (runner->task_hnd != NULL && boost->priority > runner->base_priority);
+
+    if( ! runner->boosted && behind ){
+
+        runner->boosted = 1;
+        runner->boosts++;
+        runner->boost_since = now;
+
+        if(has_task){
+            vTaskPrioritySet(runner->task_hnd, boost->priority);
+        }
+
+    }
+    else if(runner->boosted && caught_up){
+
+        runner->boosted = 0;
+        runner->boosted_ticks += now - runner->boost_since;
+
+        if(has_task){
+            vTaskPrioritySet(runner->task_hnd, runner->base_priority);
+        }
+
+    }
+
+}
+
+static void __job_runner_offload_job(struct job_runner* runner, struct job_runner_job* job){
+
+    // Only the runner task sends to the offload queue, a free space cannot disappear before the send
+    if(uxQueueSpacesAvailable(runner->offload_queue) == 0){
+        return;
+    }
+
+    if(job->notif && job->notif_slot != NULL && job->notif_slot->mode != JOB_RUNNER_COALESCE_NONE){
+        __job_runner_take_coalesced(runner, job);
+    }
+
+    // Handing the job to a helper counts as its dispatch, the helper does not touch the histograms
+    if(job->notif){
+        __job_runner_record_latency(runner, job, __job_runner_now_us(runner));
+    }
+
+    // The helper gets its own copy of the payload, new notifications can land while it runs
+    job->offload_state = runner->state;
+    job->offload_data = job->notif_data;
+    job->offload_dtor = job->notif_dtor;
+    job->offload_size = job->notif_size;
+    job->offload_share = job->notif_share;
+
+    if(job->notif_data == job->notif_inline){
+        memcpy(job->offload_inline, job->notif_inline, JOB_RUNNER_INLINE_SIZE);
+        job->offload_data = job->offload_inline;
+    }
+    job->notif = 0;
+    job->notif_data = NULL;
+    job->notif_dtor = NULL;
+    job->notif_size = 0;
+    job->notif_share = NULL;
+    job->in_flight = 1;
+    __job_runner_hot_sync(runner, job);
+
+    xQueueSend(runner->offload_queue, &job, 0);
+    runner->dispatched++;
+
+}
+
+static void __job_runner_helper_task( void* params ){
+
+    struct job_runner* runner = (struct job_runner*) params;
+    struct job_runner_job* job = NULL;
+
+    // A NULL job is the signal to exit
+    while( xQueueReceive(runner->offload_queue, &job, portMAX_DELAY) == pdTRUE && job != NULL ){
+
+        job_runner_state_t job_state = __job_runner_invoke(job, job->offload_state, job->offload_data);
+
+        // The result goes back through the command queue so only the runner task touches its lists
+        struct job_cmd cmd = { .type = JR_CMD_TYPE_OFFLOAD_DONE, .job_id = job->job_id, .cmd_data = job, .cmd_dtor = NULL, .cmd_arg = job_state,
+            .enqueued_us = __job_runner_now_us(runner) };
+        xQueueSend(runner->cmd_queue, &cmd, portMAX_DELAY);
+
+    }
+
+    xSemaphoreGive(runner->helpers_exited);
+
+    vTaskDelete(NULL);
+
+}
+
+static jrerr_t __job_runner_process_current(struct job_runner* runner){
+
+    if(runner == NULL){
+        return JR_NULL_POINTER;
+    }
+
+    if(runner->hot_dirty){
+        __job_runner_hot_rebuild(runner);
+    }
+
+    TickType_t now = __job_runner_now(runner);
+    uint8_t force = (runner->state == JOB_RUNNER_SHUT_DOWN) || runner->calibrating;
+
+    // Skips straight to the next job that has to run, the rest of the table is never touched
+    uint32_t index = __job_runner_hot_scan(runner, now, force);
+
+    if(index >= runner->hot_count){
+
+        // Only a whole pass that ran jobs can lower the backlog, neither one job on time between late ones nor the idle
+        // passes between two periods end it
+        if(runner->pass_ran){
+            runner->backlog_late = runner->pass_late;
+        }
+
+        runner->pass_late = 0;
+        runner->pass_ran = 0;
+
+        // A full pass is done, its earliest deadline bounds the adaptive sleep
+        runner->hot_cursor = 0;
+        runner->hot_passes++;
+        runner->next_due = runner->pass_next_due;
+        runner->pass_next_due = now + JOB_RUNNER_FAR_FUTURE;
+
+        __job_runner_check_calibration(runner, now);
+
+        return JR_SUCCESS;
+
+    }
+
+    struct job_runner_job* current = runner->hot_jobs[index];
+    runner->hot_cursor = index + 1;
+
+    if(current->parked && ! current->notif && ! force){
+
+        // Its far deadline came around before any notification did, it stays parked
+        current->next_run = now + JOB_RUNNER_FAR_FUTURE;
+        __job_runner_hot_sync(runner, current);
+
+        return JR_SUCCESS;
+
+    }
+
+    if(current->offload && runner->helpers_running > 0){
+
+        __job_runner_offload_job(runner, current);
+        return JR_SUCCESS;
+
+    }
+
+    if(runner->calibrating){
+        __job_runner_paint_stack();
+    }
+
+    if(current->notif && current->notif_slot != NULL && current->notif_slot->mode != JOB_RUNNER_COALESCE_NONE){
+        __job_runner_take_coalesced(runner, current);
+    }
+
+    int32_t late = (int32_t) (now - current->next_run);
+
+    if(late > 0 && (uint32_t) late > current->max_late){
+        current->max_late = late;
+    }
+
+    runner->pass_ran = 1;
+
+    if(late > 0 && (TickType_t) late > runner->pass_late){
+        runner->pass_late = late;
+    }
+
+    if(runner->pass_late > runner->backlog_late){
+        runner->backlog_late = runner->pass_late;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    if(current->notif){
+        __job_runner_record_latency(runner, current, __job_runner_now_us(runner));
+    }
+
+    runner->running_id = current->job_id;
+    runner->deferred = 0;
+
+    job_runner_state_t job_state = __job_runner_invoke(current, runner->state, current->notif_data);
+    runner->dispatched++;
+
+    runner->running_id = -1;
+
+    uint32_t busy_us = (uint32_t) (esp_timer_get_time() - start_us);
+    runner->busy_us += busy_us;
+    current->busy_us += busy_us;
+
+    if(busy_us > current->wcet_measured_us){
+        current->wcet_measured_us = busy_us;
+    }
+
+    __job_runner_record(runner, JOB_RUNNER_RECORD_RUN, 0, current->job_id, busy_us, 0);
+
+    if(runner->stack_monitor != JOB_RUNNER_STACK_MONITOR_OFF){
+        __job_runner_track_stack(runner, current);
+    }
+
+    if(job_state == JOB_RUNNER_IM_DONE){
+
+        __job_runner_record(runner, JOB_RUNNER_RECORD_REMOVE, 0, current->job_id, 0, 0);
+
+        // Unlinking moves the cursor back onto whatever took the job's place in the table
+        __job_runner_unlink_job(runner, current);
+        __job_runner_free_job(runner, current);
+
+    } 
+    else {
+
+        // The calibration run stands in for the first scheduled one, the job stays on the grid its phase set
+        TickType_t base = (runner->calibrating && ! runner->deferred) ? current->next_run : __job_runner_now(runner);
+
+        // A job that picked its next run itself keeps its period for the runs after
+        current->next_run = base + (runner->deferred ? runner->defer_ticks : current->repeat_delay);
+        current->parked = runner->deferred && runner->defer_parked;
+        __job_runner_note_deadline(runner, current);
+
+        current->notif = 0;
+        __job_runner_drop_notif(runner, current);
+
+        __job_runner_hot_sync(runner, current);
+
+    }
+
+    return JR_SUCCESS;
+
+}
+
+static jrerr_t __job_runner_process_offload_done(struct job_runner* runner, struct job_cmd* cmd){
+
+    struct job_runner_job* job = (struct job_runner_job*) cmd->cmd_data;
+
+    // In flight jobs are never migrated or freed, the pointer is still ours on either list
+    job->in_flight = 0;
+
+    __job_runner_release_bytes(runner, job->offload_size);
+    job->offload_size = 0;
+
+    if(job->offload_share != NULL){
+
+        __job_runner_release_share(runner, job->offload_share);
+        job->offload_share = NULL;
+
+    }
+    else if(job->offload_data && job->offload_dtor){
+
+        job->offload_dtor(job->offload_data);
+
+    }
+
+    job->offload_data = NULL;
+    job->offload_dtor = NULL;
+
+    if(cmd->cmd_arg == JOB_RUNNER_IM_DONE){
+
+        struct job_runner_job* paused = NULL;
+        struct job_runner_job* previous = NULL;
+
+        __job_runner_record(runner, JOB_RUNNER_RECORD_REMOVE, 0, job->job_id, 0, 0);
+
+        if(__job_runner_find_paused_job(runner, &paused, &previous, job->job_id) == JR_SUCCESS){
+
+            if(previous == NULL){
+                runner->paused = job->next;
+            }
+            else {
+                previous->next = job->next;
+            }
+
+        }
+        else {
+
+            __job_runner_unlink_job(runner, job);
+
+        }
+
+        __job_runner_free_job(runner, job);
+
+    }
+    else {
+
+        job->next_run = __job_runner_now(runner) + job->repeat_delay;
+        __job_runner_note_deadline(runner, job);
+        __job_runner_hot_sync(runner, job);
+
+    }
+
+    return JR_SUCCESS;
+
+}
+
+// drain is only for a runner that ran, one that never did has no job on a helper and keeps its queued commands
+static void __job_runner_stop_helpers(struct job_runner* runner, int8_t drain){
+
+    struct job_runner_job* stop = NULL;
+    struct job_cmd cmd;
+    uint8_t stopped = 0;
+    uint8_t exited = 0;
+
+    // Wait for every helper so none of them is left holding the queue when the runner is freed. A helper handing a job
+    // back blocks on a full command queue and takes no stop, so the queue is drained while waiting.
+    while(exited < runner->helpers_running){
+
+        if(stopped < runner->helpers_running && xQueueSend(runner->offload_queue, &stop, 0) == pdTRUE){
+            stopped++;
+        }
+        else if(xSemaphoreTake(runner->helpers_exited, 1) == pdTRUE){
+            exited++;
+        }
+
+        while( drain && xQueueReceive(runner->cmd_queue, &cmd, 0) == pdTRUE ){
+
+            if(cmd.type == JR_CMD_TYPE_OFFLOAD_DONE && cmd.cmd_data != NULL){
+                __job_runner_process_offload_done(runner, &cmd);
+            }
+            else {
+                __job_runner_release_cmd(&cmd);
+            }
+
+        }
+
+    }
+
+    runner->helpers_running = 0;
+
+}
+
+static uint16_t __job_runner_first_sub(struct job_runner* runner, job_runner_topic_t topic){
+
+    uint16_t low = 0;
+    uint16_t high = runner->num_subs;
+
+    while(low < high){
+
+        uint16_t mid = low + (high - low) / 2;
+
+        if(runner->subs[mid].topic < topic){
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+
+    }
+
+    return low;
+
+}
+
+static void __job_runner_deliver(struct job_runner* runner, struct job_runner_job* job, void* data, void (*dtor)(void* nd), struct job_runner_share* share, struct job_cmd* cmd, uint32_t dequeued_us){
+
+    if(job->notif){
+        __job_runner_record_latency(runner, job, __job_runner_now_us(runner));
+    }
+
+    if(job->notif_data != NULL){
+        __job_runner_drop_notif(runner, job);
+    }
+
+    job->notif = 1;
+    job->notif_enqueued_us = cmd->enqueued_us;
+    job->notif_dequeued_us = dequeued_us;
+    job->notif_seq = cmd->cmd_seq;
+    job->notif_data = data;
+    job->notif_dtor = dtor;
+    job->notif_share = share;
+
+    __job_runner_hot_sync(runner, job);
+
+}
+
+static jrerr_t __job_runner_process_publish(struct job_runner* runner, struct job_cmd* cmd){
+
+    jrerr_t err = JR_SUCCESS;
+
+    job_runner_topic_t topic = cmd->cmd_arg;
+    uint32_t dequeued_us = __job_runner_now_us(runner);
+    uint16_t first = __job_runner_first_sub(runner, topic);
+    uint16_t count = 0;
+
+    while(first + count < runner->num_subs && runner->subs[first + count].topic == topic){
+        count++;
+    }
+
+    if(count == 1 || cmd->cmd_data == NULL){
+
+        // Nothing to share, every subscriber just gets the pointer
+        for(uint16_t i = 0; i < count; i++){
+            __job_runner_deliver(runner, runner->subs[first + i].job, cmd->cmd_data, (i == 0) ? cmd->cmd_dtor : NULL, NULL, cmd, dequeued_us);
+        }
+
+        if(count > 0){
+            cmd->cmd_data = NULL;
+            cmd->cmd_dtor = NULL;
+        }
+
+    }
+    else if(count > 1){
+
+        struct job_runner_share* share = malloc(sizeof(struct job_runner_share));
+
+        if(share == NULL){
+
+            err = JR_MEMORY_ALLOC_FAIL;
+
+        }
+        else {
+
+            share->refs = count;
+            share->data = cmd->cmd_data;
+            share->dtor = cmd->cmd_dtor;
+
+            __atomic_add_fetch(&runner->notif_bytes, sizeof(struct job_runner_share), __ATOMIC_SEQ_CST);
+            __job_runner_track_peak(runner);
+
+            for(uint16_t i = 0; i < count; i++){
+                __job_runner_deliver(runner, runner->subs[first + i].job, share->data, NULL, share, cmd, dequeued_us);
+            }
+
+            cmd->cmd_data = NULL;
+            cmd->cmd_dtor = NULL;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_subscribe_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_sub_request* req = (struct job_runner_sub_request*) arg;
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+
+    err = __job_runner_find_job(runner, &job, req->job_id);
+    if(err == JR_JOB_NOT_EXIST){
+        err = __job_runner_find_paused_job(runner, &job, &previous, req->job_id);
+    }
+
+    uint16_t index = 0;
+    int8_t found = 0;
+
+    if(err == JR_SUCCESS){
+
+        for(index = __job_runner_first_sub(runner, req->topic); index < runner->num_subs && runner->subs[index].topic == req->topic; index++){
+
+            if(runner->subs[index].job == job){
+                found = 1;
+                break;
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && req->subscribe && ! found){
+
+        // The index counts in 16 bits, once it holds UINT16_MAX entries it cannot take another
+        if(runner->num_subs == UINT16_MAX){
+            err = JR_FAIL;
+        }
+
+        if(err == JR_SUCCESS && runner->num_subs == runner->subs_capacity){
+
+            uint16_t capacity = (runner->subs_capacity > UINT16_MAX - 8) ? UINT16_MAX : runner->subs_capacity + 8;
+
+            struct job_runner_sub* subs = realloc(runner->subs, capacity * sizeof(struct job_runner_sub));
+            if(subs == NULL){
+                err = JR_MEMORY_ALLOC_FAIL;
+            }
+            else {
+
+                runner->subs = subs;
+                runner->job_bytes += (capacity - runner->subs_capacity) * sizeof(struct job_runner_sub);
+                runner->subs_capacity = capacity;
+
+            }
+
+        }
+
+        if(err == JR_SUCCESS){
+
+            // index is the end of the topic's run, later subscribers are delivered to last
+            memmove(&runner->subs[index + 1], &runner->subs[index], (runner->num_subs - index) * sizeof(struct job_runner_sub));
+            runner->subs[index] = (struct job_runner_sub) { .topic = req->topic, .job = job };
+            runner->num_subs++;
+            job->topics++;
+
+        }
+
+    }
+    else if(err == JR_SUCCESS && ! req->subscribe){
+
+        if(found){
+
+            memmove(&runner->subs[index], &runner->subs[index + 1], (runner->num_subs - index - 1) * sizeof(struct job_runner_sub));
+            runner->num_subs--;
+            job->topics--;
+
+        }
+        else {
+
+            err = JR_NOT_SUBSCRIBED;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_process_migration(struct job_runner* runner, struct job_cmd* cmd){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* target = (struct job_runner*) cmd->cmd_data;
+    struct job_runner_job* job = NULL;
+
+    if(target == NULL || target->cmd_queue == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(cmd->job_id >= 0){
+
+            err = __job_runner_find_job(runner, &job, cmd->job_id);
+
+            // The target may have no helpers, offloaded jobs stay where they are. Subscriptions and shared payloads
+            // belong to this runner's topic index.
+            if(err == JR_SUCCESS && (job->notif_slot != NULL || job->offload || job->topics > 0 || job->notif_share != NULL)){
+                err = JR_FAIL;
+            }
+
+        }
+        else {
+
+            // Balancer request, pick the heaviest job that fits in the budget (percent of cpu)
+            uint32_t window_us = (uint32_t) esp_timer_get_time() - runner->load_mark_us;
+            uint32_t best_load = 0;
+            struct job_runner_job* start = runner->jobs;
+
+            while( start != NULL && window_us > 0 ){
+
+                uint32_t load = (uint32_t) (((uint64_t) start->busy_us * 100) / window_us);
+
+                // Jobs with notification settings are tied to this runner's slot table
+                if(load <= cmd->cmd_arg && load >= best_load && start->busy_us > 0 && start->notif_slot == NULL && ! start->offload
+                    && start->topics == 0 && start->notif_share == NULL){
+                    best_load = load;
+                    job = start;
+                }
+
+                start->busy_us = 0;
+                start = start->next;
+
+            }
+
+            runner->load_mark_us = (uint32_t) esp_timer_get_time();
+
+            if(job == NULL){
+                err = JR_JOB_NOT_EXIST;
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Never hand away the last job, a runner without jobs shuts itself down
+        if(runner->jobs == job && job->next == NULL){
+            err = JR_FAIL;
+        }
+
+    }
+
+    // The target the balancer picked may have run out of jobs since, it leaves the balancer before it is freed
+    int8_t locked = (cmd->job_id < 0 && job_runner_balancer_lock != NULL);
+
+    if(locked){
+
+        xSemaphoreTake(job_runner_balancer_lock, portMAX_DELAY);
+
+        if(err == JR_SUCCESS && target->balancer == NULL){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        __job_runner_unlink_job(runner, job);
+
+        struct job_cmd adopt = { .type = JR_CMD_TYPE_ADOPT, .job_id = job->job_id, .cmd_data = job, .cmd_dtor = NULL, .enqueued_us = __job_runner_now_us(target) };
+        BaseType_t sderr = xQueueSend(target->cmd_queue, &adopt, 0);
+        if(sderr != pdTRUE){
+
+            // Target is backed up, keep the job here, its table slot was freed by the unlink
+            __job_runner_link_job(runner, job);
+            err = JR_QUEUE_FULL;
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        __job_runner_record(runner, JOB_RUNNER_RECORD_REMOVE, 0, job->job_id, 0, 0);
+
+        // The adopting runner counts the job from here on
+        runner->job_bytes -= __job_runner_job_bytes(job);
+        __job_runner_release_bytes(runner, job->notif_size);
+
+        // Route future notifications only once the adopt command is queued ahead of them
+        struct job_runner_route* route = __job_runner_balancer_route(runner->balancer, job->job_id);
+        if(route != NULL){
+            route->owner = target;
+        }
+
+        ESP_LOGI("Job Runner","Migrated job %d", (int) job->job_id);
+
+    }
+
+    if(locked){
+        xSemaphoreGive(job_runner_balancer_lock);
+    }
+
+    // A migration that could not happen is not fatal for the runner
+    return JR_SUCCESS;
+
+}
+
+static jrerr_t __job_runner_forward_notification(struct job_runner* runner, struct job_cmd* cmd){
+
+    jrerr_t err = JR_JOB_NOT_EXIST;
+
+    // The job may have been migrated while this notification was in flight
+    struct job_runner_route* route = __job_runner_balancer_route(runner->balancer, cmd->job_id);
+
+    if(route != NULL && route->owner != runner){
+
+        uint32_t size = (cmd->cmd_data != NULL) ? cmd->cmd_arg : 0;
+
+        // Counted on the new owner before it can possibly release it
+        __atomic_add_fetch(&route->owner->notif_bytes, size, __ATOMIC_SEQ_CST);
+
+        // Sequence numbers are per runner, it is ordered among the new owner's notifications from here on
+        cmd->cmd_seq = __job_runner_next_seq(route->owner);
+
+        BaseType_t sderr = xQueueSend(route->owner->cmd_queue, cmd, 0);
+        if(sderr != pdTRUE){
+            __job_runner_release_bytes(route->owner, size);
+        }
+
+        if(sderr == pdTRUE){
+
+            // Ownership went along with the command
+            __job_runner_release_bytes(runner, size);
+            cmd->cmd_data = NULL;
+            cmd->cmd_dtor = NULL;
+            err = JR_SUCCESS;
+
+        }
+        else {
+
+            err = JR_QUEUE_FULL;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+// Hands a notification to its job, or on to the runner the job moved to. A payload nobody took is left in cmd.
+static jrerr_t __job_runner_route_notification(struct job_runner* runner, struct job_cmd* cmd){
+
+    jrerr_t err = __job_runner_process_notification(runner, cmd);
+    if(err == JR_JOB_NOT_EXIST && runner->balancer != NULL){
+        err = __job_runner_forward_notification(runner, cmd);
+    }
+
+    if(err == JR_QUEUE_FULL){
+        ESP_LOGE("Job Runner","Failed to forward notification");
+        err = JR_SUCCESS;
+    }
+
+    if(err == JR_JOB_NOT_EXIST){
+        ESP_LOGE("Job Runner","Job Not Exist");
+
+        // Return Success so job runner does not get shut down. 
+        err = JR_SUCCESS;
+    }
+
+    if(cmd->cmd_data != NULL){
+
+        // Nobody took the payload, it is destroyed by the caller
+        __job_runner_release_bytes(runner, cmd->cmd_arg);
+
+    }
+
+    return err;
+
+}
+
+static int8_t __job_runner_timer_before(struct job_runner_timer* a, struct job_runner_timer* b){
+
+    int32_t diff = (int32_t) (a->due - b->due);
+
+    // Same tick, delivered in the order they were scheduled
+    return (diff < 0) || (diff == 0 && (int32_t) (a->handle - b->handle) < 0);
+
+}
+
+static void __job_runner_timer_sift(struct job_runner* runner, uint16_t index){
+
+    struct job_runner_timer* timers = runner->timers;
+
+    while(index > 0 && __job_runner_timer_before(&timers[index], &timers[(index - 1) / 2])){
+
+        struct job_runner_timer swap = timers[index];
+        timers[index] = timers[(index - 1) / 2];
+        timers[(index - 1) / 2] = swap;
+        index = (index - 1) / 2;
+
+    }
+
+    while(1){
+
+        uint16_t first = index;
+        uint32_t left = 2 * (uint32_t) index + 1;
+
+        if(left < runner->num_timers && __job_runner_timer_before(&timers[left], &timers[first])){
+            first = left;
+        }
+
+        if(left + 1 < runner->num_timers && __job_runner_timer_before(&timers[left + 1], &timers[first])){
+            first = left + 1;
+        }
+
+        if(first == index){
+            break;
+        }
+
+        struct job_runner_timer swap = timers[index];
+        timers[index] = timers[first];
+        timers[first] = swap;
+        index = first;
+
+    }
+
+}
+
+static jrerr_t __job_runner_timer_push(struct job_runner* runner, struct job_runner_timer* timer){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner->num_timers == runner->timers_capacity){
+
+        uint32_t capacity = runner->timers_capacity ? 2 * (uint32_t) runner->timers_capacity : 8;
+        struct job_runner_timer* timers = NULL;
+
+        if(capacity > UINT16_MAX){
+            capacity = UINT16_MAX;
+        }
+
+        if(capacity > runner->timers_capacity){
+            timers = realloc(runner->timers, capacity * sizeof(struct job_runner_timer));
+        }
+
+        if(timers == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+        else {
+
+            runner->job_bytes += (capacity - runner->timers_capacity) * sizeof(struct job_runner_timer);
+            __job_runner_track_peak(runner);
+
+            runner->timers = timers;
+            runner->timers_capacity = capacity;
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->timers[runner->num_timers++] = *timer;
+        __job_runner_timer_sift(runner, runner->num_timers - 1);
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_timer_remove(struct job_runner* runner, uint16_t index){
+
+    runner->num_timers--;
+
+    if(index < runner->num_timers){
+
+        runner->timers[index] = runner->timers[runner->num_timers];
+        __job_runner_timer_sift(runner, index);
+
+    }
+
+}
+
+// Delivered as if job_runner_notify_job was called right now, coalescing and rate limits still apply
+static jrerr_t __job_runner_fire_timer(struct job_runner* runner, struct job_runner_timer* timer){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_notif_slot* slot = __job_runner_find_notif_slot(runner, timer->job_id);
+    int8_t send = 1;
+    int8_t coalesced = (slot != NULL && slot->mode != JOB_RUNNER_COALESCE_NONE);
+
+    struct job_cmd cmd = { .type = JR_CMD_TYPE_NOTIFY, .job_id = timer->job_id, .cmd_data = timer->data, .cmd_dtor = timer->dtor, .cmd_arg = 0,
+        .enqueued_us = __job_runner_now_us(runner), .cmd_seq = __job_runner_next_seq(runner) };
+
+    if(slot != NULL){
+
+        if(__job_runner_coalesce_notification(runner, slot, timer->data, timer->dtor, 0, 0, &send) == JR_SUCCESS){
+
+            if(coalesced){
+
+                // The slot owns the payload now
+                cmd.cmd_data = NULL;
+                cmd.cmd_dtor = NULL;
+
+            }
+
+        }
+        else {
+
+            send = 0;
+
+        }
+
+    }
+
+    if(send){
+
+        __job_runner_record(runner, JOB_RUNNER_RECORD_NOTIFY, 0, timer->job_id, 0, 0);
+
+        err = __job_runner_route_notification(runner, &cmd);
+
+    }
+
+    if(cmd.cmd_data != NULL && cmd.cmd_dtor != NULL){
+        cmd.cmd_dtor(cmd.cmd_data);
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_fire_timers(struct job_runner* runner){
+
+    jrerr_t err = JR_SUCCESS;
+
+    TickType_t now = __job_runner_now(runner);
+
+    uint16_t fired = 0;
+
+    while(err == JR_SUCCESS && runner->num_timers > 0 && (int32_t) (now - runner->timers[0].due) >= 0){
+
+        struct job_runner_timer timer = runner->timers[0];
+        __job_runner_timer_remove(runner, 0);
+
+        err = __job_runner_fire_timer(runner, &timer);
+        fired++;
+
+    }
+
+    if(fired > 0){
+
+        // Scan again from the top so the notified jobs run in this loop and not a whole pass later
+        runner->hot_cursor = 0;
+
+    }
+
+    return err;
+
+}
+
+// Takes the payload out of cmd once the timer is in the heap
+static jrerr_t __job_runner_schedule_timer(struct job_runner* runner, struct job_cmd* cmd){
+
+    struct job_runner_timer timer = { .due = cmd->cmd_arg, .handle = cmd->cmd_handle, .job_id = cmd->job_id, .data = cmd->cmd_data, .dtor = cmd->cmd_dtor };
+
+    jrerr_t err = __job_runner_timer_push(runner, &timer);
+
+    if(err == JR_SUCCESS){
+
+        cmd->cmd_data = NULL;
+        cmd->cmd_dtor = NULL;
+
+    }
+
+    return err;
+
+}
+
+// A shorter period takes effect right away, a longer one after the pending run
+static void __job_runner_apply_period(struct job_runner* runner, struct job_runner_job* job, uint32_t repeat_delay){
+
+    TickType_t now = __job_runner_base(runner);
+
+    job->repeat_delay = repeat_delay;
+
+    if((int32_t) ((now + job->repeat_delay) - job->next_run) < 0){
+        job->next_run = now + job->repeat_delay;
+    }
+
+}
+
+static jrerr_t __job_runner_process_schedule(struct job_runner* runner, struct job_cmd* cmd){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+    int8_t paused = 0;
+
+    err = __job_runner_find_job(runner, &job, cmd->job_id);
+    if(err == JR_JOB_NOT_EXIST){
+
+        err = __job_runner_find_paused_job(runner, &job, &previous, cmd->job_id);
+        paused = (err == JR_SUCCESS);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        TickType_t now = __job_runner_base(runner);
+
+        switch(cmd->type){
+
+            case JR_CMD_TYPE_PAUSE:
+
+                // Paused jobs sit on their own list so the dispatch loop never looks at them
+                if( ! paused && runner->state != JOB_RUNNER_SHUT_DOWN ){
+                    __job_runner_unlink_job(runner, job);
+                    job->next = runner->paused;
+                    runner->paused = job;
+                }
+
+                break;
+
+            case JR_CMD_TYPE_RESUME:
+
+                if(paused){
+
+                    if(previous == NULL){
+                        runner->paused = job->next;
+                    }
+                    else {
+                        previous->next = job->next;
+                    }
+
+                    __job_runner_link_job(runner, job);
+
+                }
+
+                break;
+
+            case JR_CMD_TYPE_SET_PERIOD:
+
+                __job_runner_apply_period(runner, job, cmd->cmd_arg);
+
+                // Only queued while admission control was off, there is no caller left to refuse so it is only reported
+                __job_runner_admit(runner, 0, 0, 0);
+
+                break;
+
+            case JR_CMD_TYPE_SET_DEADLINE:
+
+                job->next_run = now + cmd->cmd_arg;
+
+                break;
+
+            case JR_CMD_TYPE_SET_OFFLOAD:
+
+                // A job already on a helper finishes there, the change applies from its next run
+                job->offload = (int8_t) cmd->cmd_arg;
+
+                break;
+
+            default:
+                err = JR_INVALID_CMD;
+                break;
+
+        }
+
+        __job_runner_hot_sync(runner, job);
+
+    }
+
+    return err;
+
+}
+
+// max_wait bounds how long a sender from another task waits on a full lane
+static jrerr_t __job_runner_send_lane_within(struct job_runner* runner, struct job_cmd* cmd, job_runner_lane_t lane, TickType_t max_wait){
+
+    jrerr_t err = JR_SUCCESS;
+
+    xQueueHandle* queue = (lane == JOB_RUNNER_LANE_CONTROL) ? runner->ctl_queue : runner->cmd_queue;
+
+    if(queue == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS && lane == JOB_RUNNER_LANE_CONTROL && runner->adaptive && uxQueueMessagesWaiting(runner->cmd_queue) == 0){
+
+        // An adaptive runner sleeps on cmd_queue, an empty wake command gets it up for the control lane. A full
+        // cmd_queue keeps it at the floor anyway. Sent first, once the command is in a shutdown may already have freed
+        // the runner. Woken a moment early the runner only sleeps the floor, it has just taken a command.
+        struct job_cmd wake = { .type = JR_CMD_TYPE_WAKE, .job_id = -1, .cmd_data = NULL, .cmd_dtor = NULL };
+        xQueueSend(runner->cmd_queue, &wake, 0);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Only the runner empties its queues, waiting on a full one from its own task or a simulation never ends
+        TickType_t wait = max_wait;
+        if(runner->simulating || (runner->task_hnd != NULL && runner->task_hnd == xTaskGetCurrentTaskHandle())){
+            wait = 0;
+        }
+
+        BaseType_t sderr = xQueueSend(queue, cmd, wait);
+        if(sderr != pdTRUE){
+            err = JR_QUEUE_FULL;
+        }
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_send_lane(struct job_runner* runner, struct job_cmd* cmd, job_runner_lane_t lane){
+
+    return __job_runner_send_lane_within(runner, cmd, lane, portMAX_DELAY);
+
+}
+
+static jrerr_t __job_runner_send_schedule(struct job_runner* runner, enum cmd_type type, int16_t job_id, uint32_t arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->cmd_queue == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        struct job_cmd cmd = { .type = type, .job_id = job_id, .cmd_data = NULL, .cmd_dtor = NULL, .cmd_arg = arg,
+            .enqueued_us = __job_runner_now_us(runner) };
+
+        if(runner->task_hnd == NULL){
+
+            // No runner task yet, nothing else touches the job lists
+            err = __job_runner_process_schedule(runner, &cmd);
+
+        }
+        else {
+
+            // Behind the notifications and migrations the caller sent before, a pause never overtakes them
+            err = __job_runner_send_lane(runner, &cmd, JOB_RUNNER_LANE_NORMAL);
+
+        }
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_lane_taken(struct job_runner* runner, job_runner_lane_t lane, struct job_cmd* cmd){
+
+    struct job_runner_lane* stats = &runner->lanes[lane];
+
+    // The one just taken counts, the lane held it a moment ago
+    uint32_t depth = uxQueueMessagesWaiting((lane == JOB_RUNNER_LANE_CONTROL) ? runner->ctl_queue : runner->cmd_queue) + 1;
+    uint32_t wait_us = __job_runner_now_us(runner) - cmd->enqueued_us;
+
+    if(depth > stats->peak_depth){
+        stats->peak_depth = depth;
+    }
+
+    if(wait_us > stats->max_wait_us){
+        stats->max_wait_us = wait_us;
+    }
+
+    stats->commands++;
+    stats->wait_us += wait_us;
+
+}
+
+static jrerr_t __job_runner_process_command(struct job_runner* runner){
+    
+    if(runner == NULL){
+        return JR_NULL_POINTER;
+    }
+
+    if(runner->cmd_queue == NULL){
+        return JR_NULL_POINTER;
+    }
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_cmd cmd = {0};
+    job_runner_lane_t lane = JOB_RUNNER_LANE_CONTROL;
+
+    BaseType_t rcvd = (runner->ctl_queue != NULL) ? xQueueReceive(runner->ctl_queue, &cmd, 0) : pdFALSE;
+
+    if(rcvd != pdTRUE){
+
+        lane = JOB_RUNNER_LANE_NORMAL;
+        rcvd = xQueueReceive(runner->cmd_queue, &cmd, (runner->adaptive || runner->clock.now != NULL) ? 0 : 1);
+
+    }
+
+    if(rcvd == pdTRUE && cmd.type != JR_CMD_TYPE_WAKE){
+        __job_runner_lane_taken(runner, lane, &cmd);
+    }
+
+    if(rcvd == pdTRUE){
+
+        runner->commands++;
+
+        // Process New Command
+        switch(cmd.type){
+
+            case JR_CMD_TYPE_NOTIFY:
+
+                err = __job_runner_route_notification(runner, &cmd);
+
+                break;
+
+            case JR_CMD_TYPE_TIMER:
+
+                if(__job_runner_schedule_timer(runner, &cmd) != JR_SUCCESS){
+
+                    // The handle was already given out, it simply never fires
+                    ESP_LOGE("Job Runner","Dropped a delayed notification, no memory to keep it");
+
+                    if(cmd.cmd_dtor == NULL){
+                        cmd.cmd_data = NULL;
+                    }
+
+                }
+
+                break;
+
+            case JR_CMD_TYPE_PUBLISH:
+
+                err = __job_runner_process_publish(runner, &cmd);
+                if(err == JR_MEMORY_ALLOC_FAIL){
+                    ESP_LOGE("Job Runner","Dropped a publish, no memory to share it");
+                    err = JR_SUCCESS;
+                }
+
+                if(cmd.cmd_data != NULL && cmd.cmd_dtor == NULL){
+
+                    // Nobody subscribed, a payload without a destructor is simply dropped
+                    cmd.cmd_data = NULL;
+
+                }
+
+                break;
+
+            case JR_CMD_TYPE_MIGRATE:
+
+                err = __job_runner_process_migration(runner, &cmd);
+
+                // The target runner is not owned by the command
+                cmd.cmd_data = NULL;
+
+                break;
+
+            case JR_CMD_TYPE_ADOPT:
+
+                if(cmd.cmd_data != NULL){
+
+                    struct job_runner_job* job = (struct job_runner_job*) cmd.cmd_data;
+
+                    // Grown here between passes, a job that does not fit is still adopted and waits for room
+                    if(__job_runner_hot_reserve(runner, __job_runner_count_jobs(runner) + 1) != JR_SUCCESS){
+                        ESP_LOGW("Job Runner","No room in the hot table for adopted job %d yet", (int) job->job_id);
+                    }
+
+                    // A pending notification was ordered on the old runner, it goes before anything sent here from now on
+                    job->notif_seq = __atomic_load_n(&runner->notif_seq, __ATOMIC_SEQ_CST);
+
+                    __job_runner_link_job(runner, job);
+                    cmd.cmd_data = NULL;
+
+                    runner->job_bytes += __job_runner_job_bytes(job);
+                    __atomic_add_fetch(&runner->notif_bytes, job->notif_size, __ATOMIC_SEQ_CST);
+                    __job_runner_track_peak(runner);
+
+                    __job_runner_record_add(runner, job);
+
+                }
+
+                break;
+
+            case JR_CMD_TYPE_PAUSE:
+            case JR_CMD_TYPE_RESUME:
+            case JR_CMD_TYPE_SET_PERIOD:
+            case JR_CMD_TYPE_SET_DEADLINE:
+            case JR_CMD_TYPE_SET_OFFLOAD:
+
+                err = __job_runner_process_schedule(runner, &cmd);
+                if(err == JR_JOB_NOT_EXIST){
+                    ESP_LOGE("Job Runner","Job Not Exist");
+                    err = JR_SUCCESS;
+                }
+
+                break;
+
+            case JR_CMD_TYPE_CALL:
+
+                if(cmd.cmd_data != NULL){
+
+                    // The caller blocks on the response, the call struct lives on its stack
+                    struct job_runner_call* call = (struct job_runner_call*) cmd.cmd_data;
+                    jrerr_t resp = call->fn(runner, call->arg);
+                    xQueueSend(call->resp, &resp, portMAX_DELAY);
+                    cmd.cmd_data = NULL;
+
+                }
+
+                break;
+
+            case JR_CMD_TYPE_WAKE:
+
+                // Only there to end an adaptive sleep, the control lane is looked at on the next loop
+                break;
+
+            case JR_CMD_TYPE_SHUTDOWN:
+
+                // Acted on at the top of the next loop, like a shutdown from a job
+                runner->shutdown_pending = 1;
+
+                break;
+
+            case JR_CMD_TYPE_OFFLOAD_DONE:
+
+                if(cmd.cmd_data != NULL){
+
+                    err = __job_runner_process_offload_done(runner, &cmd);
+                    cmd.cmd_data = NULL;
+
+                }
+
+                break;
+
+            default:
+                err = JR_INVALID_CMD;
+                break;
+        }
+
+        if(cmd.cmd_data != NULL){
+            if(cmd.cmd_dtor != NULL){
+                cmd.cmd_dtor(cmd.cmd_data);
+            }
+            else {
+                err = JR_INVALID_DESTRUCTOR;
+            }
+        }
+
+    }
+
+    return err;
+}
+
+static jrerr_t __job_runner_check_shutdown(struct job_runner* runner){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner->shutdown_pending && runner->state != JOB_RUNNER_SHUT_DOWN){
+
+        runner->state = JOB_RUNNER_SHUT_DOWN;
+
+        // Paused jobs get their shutdown callback like everyone else
+        while(runner->paused != NULL){
+            struct job_runner_job* job = runner->paused;
+            runner->paused = job->next;
+            job->next = runner->jobs;
+            runner->jobs = job;
+            runner->hot_dirty = 1;
+        }
+
+        // Everything sent before the shutdown is taken now, so notifications reach their jobs with the shutdown call
+        // instead of being destroyed undelivered. Later commands are taken one per loop as usual.
+        UBaseType_t queued = uxQueueMessagesWaiting(runner->ctl_queue) + uxQueueMessagesWaiting(runner->cmd_queue);
+
+        for(UBaseType_t i = 0; err == JR_SUCCESS && i < queued; i++){
+            err = __job_runner_process_command(runner);
+        }
+
+    }
+
+    return err;
+
+}
+
+// Adds the runs of a job starting offset ticks from now to the load map, or returns the busiest slot they would hit
+static uint16_t __job_runner_phase_load(uint16_t* load, uint32_t window, uint32_t offset, TickType_t period, int8_t add){
+
+    uint16_t busiest = 0;
+
+    for(uint32_t tick = offset; tick < window; tick += period){
+
+        if(add){
+            load[tick]++;
+        }
+        else if(load[tick] > busiest){
+            busiest = load[tick];
+        }
+
+    }
+
+    return busiest;
+
+}
+
+static void __job_runner_place_phase(struct job_runner_job* job, uint16_t* load, uint32_t window, TickType_t now){
+
+    uint32_t candidates = (job->repeat_delay < window) ? job->repeat_delay : window;
+    uint32_t best_offset = 0;
+    uint16_t best_load = UINT16_MAX;
+
+    // The first offset whose busiest slot is the least busy, equal periods end up one tick apart
+    for(uint32_t offset = 0; offset < candidates && best_load > 0; offset++){
+
+        uint16_t busiest = __job_runner_phase_load(load, window, offset, job->repeat_delay, 0);
+
+        if(busiest < best_load){
+            best_load = busiest;
+            best_offset = offset;
+        }
+
+    }
+
+    __job_runner_phase_load(load, window, best_offset, job->repeat_delay, 1);
+    job->next_run = now + best_offset;
+
+}
+
+// Spreads the first runs of unpinned periodic jobs so equal and harmonic periods do not all land on one tick.
+// Shortest periods are placed first, they have the fewest offsets to choose from.
+static void __job_runner_stagger(struct job_runner* runner){
+
+    // Runs before the rebase, next_run is still an offset from the start
+    TickType_t now = 0;
+    uint32_t window = 0;
+    uint16_t* load = NULL;
+
+    struct job_runner_job* lists[] = { runner->jobs, runner->paused };
+
+    for(int l = 0; l < 2; l++){
+        for(struct job_runner_job* job = lists[l]; job != NULL; job = job->next){
+            if(job->repeat_delay > window){
+                window = job->repeat_delay;
+            }
+        }
+    }
+
+    if(window > JOB_RUNNER_PHASE_WINDOW){
+        window = JOB_RUNNER_PHASE_WINDOW;
+    }
+
+    if(window == 0){
+        return;
+    }
+
+    load = calloc(window, sizeof(uint16_t));
+    if(load == NULL){
+        ESP_LOGE("Job Runner","No memory to stagger phases, jobs keep their own");
+        return;
+    }
+
+    // Pinned jobs go in as they are, everything else is placed around them
+    for(int l = 0; l < 2; l++){
+        for(struct job_runner_job* job = lists[l]; job != NULL; job = job->next){
+
+            if(job->phase_pinned && job->repeat_delay > 0){
+
+                int32_t offset = (int32_t) (job->next_run - now);
+                __job_runner_phase_load(load, window, (offset > 0) ? (uint32_t) offset : 0, job->repeat_delay, 1);
+
+            }
+
+        }
+    }
+
+    TickType_t period = 0;
+
+    while(period != UINT32_MAX){
+
+        TickType_t next_period = UINT32_MAX;
+
+        for(int l = 0; l < 2; l++){
+            for(struct job_runner_job* job = lists[l]; job != NULL; job = job->next){
+
+                if(job->phase_pinned || job->repeat_delay == 0){
+                    continue;
+                }
+
+                if(job->repeat_delay == period){
+                    __job_runner_place_phase(job, load, window, now);
+                }
+                else if(job->repeat_delay > period && job->repeat_delay < next_period){
+                    next_period = job->repeat_delay;
+                }
+
+            }
+        }
+
+        period = next_period;
+
+    }
+
+    free(load);
+
+    runner->hot_dirty = 1;
+
+}
+
+static jrerr_t __job_runner_calibrate(struct job_runner* runner){
+
+    jrerr_t err = JR_SUCCESS;
+
+    uint32_t passes = runner->hot_passes;
+
+    runner->calibrating = 1;
+    runner->hot_cursor = 0;
+
+    // Run every job exactly once, the pass count moves when the scan runs off the end of the table
+    while(runner->hot_passes == passes){
+
+        err = __job_runner_process_current(runner);
+        if(err != JR_SUCCESS){
+            break;
+        }
+
+    }
+
+    runner->calibrating = 0;
+
+    if(err == JR_SUCCESS){
+
+        struct job_runner_stack_stats stats;
+        job_runner_get_stack_stats(runner, &stats);
+
+        ESP_LOGI("Job Runner","Calibration done, %u of %u bytes used, recommended stack %u bytes (deepest job %d)", 
+            (unsigned int) (stats.stack_size - stats.min_free), (unsigned int) stats.stack_size, (unsigned int) stats.recommended_stack, (int) stats.deepest_job_id);
+
+    }
+
+    return err;
+
+}
+
+// Until the runner starts next_run holds an offset from the start, this anchors every job to the clock
+static void __job_runner_rebase(struct job_runner* runner){
+
+    TickType_t now = __job_runner_now(runner);
+
+    struct job_runner_job* lists[] = { runner->jobs, runner->paused };
+
+    for(int l = 0; l < 2; l++){
+        for(struct job_runner_job* job = lists[l]; job != NULL; job = job->next){
+            job->next_run += now;
+        }
+    }
+
+    runner->anchored = 1;
+    runner->hot_dirty = 1;
+
+}
+
+static jrerr_t __job_runner_begin(struct job_runner* runner){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner->stagger){
+        __job_runner_stagger(runner);
+    }
+
+    __job_runner_rebase(runner);
+
+    if(runner->stack_monitor == JOB_RUNNER_STACK_MONITOR_CALIBRATE){
+
+        err = __job_runner_calibrate(runner);
+        if(err != JR_SUCCESS){
+            ESP_LOGE("__job_runner_task","Error Calibrating, killing runner!!!");
+        }
+
+    }
+
+    runner->hot_cursor = 0;
+    runner->load_mark_us = (uint32_t) esp_timer_get_time();
+    runner->next_due = __job_runner_now(runner);
+    runner->pass_next_due = runner->next_due + JOB_RUNNER_FAR_FUTURE;
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_iterate(struct job_runner* runner){
+
+    jrerr_t err = JR_SUCCESS;
+
+    uint32_t dispatched = runner->dispatched;
+    uint32_t commands = runner->commands;
+
+    err = __job_runner_check_shutdown(runner);
+    if(err != JR_SUCCESS){
+        ESP_LOGE("__job_runner_task","Error Draining Commands, killing runner!!!");
+    }
+
+    if(err == JR_SUCCESS && runner->num_timers > 0){
+
+        err = __job_runner_fire_timers(runner);
+        if(err != JR_SUCCESS){
+            ESP_LOGE("__job_runner_task","Error Firing Timers, killing runner!!!");
+        }
+
+    }
+
+    if(err == JR_SUCCESS && runner->hot_short){
+
+        // Jobs adopted while memory was short are still outside the table, try again to make room before dispatching
+        if(__job_runner_hot_reserve(runner, __job_runner_count_jobs(runner)) == JR_SUCCESS){
+            runner->hot_dirty = 1;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && runner->jobs != NULL){
+
+        err = __job_runner_process_current(runner);
+        if(err != JR_SUCCESS){
+            ESP_LOGE("__job_runner_task","Error Processing Current, killing runner!!!");
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_process_command(runner);
+        if(err != JR_SUCCESS){
+            ESP_LOGE("__job_runner_task","Error Processing Command, killing runner!!!");
+        }
+
+    }
+
+    if(err == JR_SUCCESS && runner->boost_enabled){
+        __job_runner_check_boost(runner);
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->wakeups++;
+        __job_runner_sleep(runner, runner->dispatched != dispatched || runner->commands != commands);
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_end(struct job_runner* runner){
+
+    ESP_LOGI("__job_runner_task","No More Jobs, Shutting Down Runner!!!");
+
+    __job_runner_stop_helpers(runner, 1);
+    __job_runner_balancer_forget(runner);
+
+    if(runner->done_slot >= 0){
+
+        xEventGroupSetBits(__job_runner_done_group(runner->done_slot)->group, 1 << (runner->done_slot % JOB_RUNNER_DONE_BITS));
+    
+    }
+
+    __job_runner_console_forget(runner);
+    __job_runner_free_runner(runner);
+
+}
+
+static void __job_runner_task( void* params ) {
+
+    struct job_runner* runner = (struct job_runner*) params;
+    if(runner == NULL){
+        ESP_LOGE("__job_runner_task","Runner NULL, Abrting!!!");
+        vTaskDelete(NULL);
+    }
+
+    if(runner->held){
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        runner->held = 0;
+    }
+
+    jrerr_t err = __job_runner_begin(runner);
+
+    while(err == JR_SUCCESS && (runner->jobs != NULL || runner->paused != NULL)){
+
+        err = __job_runner_iterate(runner);
+
+    }
+
+    __job_runner_end(runner);
+
+    vTaskDelete(NULL);
+
+}
+
+static jrerr_t __job_runner_notify(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t notif_size, uint8_t inline_len, job_runner_lane_t lane){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+
+        err = JR_NULL_POINTER;
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->cmd_queue == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    int8_t send = 1;
+    struct job_runner_notif_slot* slot = NULL;
+
+    if(notif_data == NULL){
+        notif_size = 0;
+    }
+
+    if(err == JR_SUCCESS && notif_size > 0){
+
+        // Count first and back out when over, two producers cannot both squeeze in under the budget
+        uint32_t total = __atomic_add_fetch(&runner->notif_bytes, notif_size, __ATOMIC_SEQ_CST) + runner->job_bytes;
+
+        if(runner->mem_budget > 0 && total > runner->mem_budget){
+
+            __job_runner_release_bytes(runner, notif_size);
+            __atomic_add_fetch(&runner->mem_rejected, 1, __ATOMIC_SEQ_CST);
+            err = JR_OVER_BUDGET;
+
+        }
+        else {
+
+            __job_runner_track_peak(runner);
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        slot = __job_runner_find_notif_slot(runner, job_id);
+        if(slot != NULL){
+
+            err = __job_runner_coalesce_notification(runner, slot, notif_data, notif_dtor, notif_size, inline_len, &send);
+            if(err != JR_SUCCESS){
+                __job_runner_release_bytes(runner, notif_size);
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && send){
+
+        // A coalesced command carries no payload, the runner collects it from the slot
+        int8_t coalesced = (slot != NULL && slot->mode != JOB_RUNNER_COALESCE_NONE);
+
+        struct job_cmd cmd = { .type = JR_CMD_TYPE_NOTIFY, .job_id = job_id, .cmd_data = coalesced ? NULL : notif_data, .cmd_dtor = coalesced ? NULL : notif_dtor, .cmd_arg = coalesced ? 0 : notif_size,
+            .enqueued_us = __job_runner_now_us(runner), .cmd_seq = __job_runner_next_seq(runner) };
+
+        if( ! coalesced && inline_len > 0 ){
+
+            // The bytes travel inside the queue item, nothing is left for the runner to free
+            memcpy(cmd.inline_data, notif_data, inline_len);
+            cmd.inline_len = inline_len;
+            cmd.cmd_data = NULL;
+
+        }
+        err = __job_runner_send_lane(runner, &cmd, lane);
+        if(err == JR_QUEUE_FULL){
+
+            if(coalesced){
+
+                // Nothing is queued to collect the slot, whatever it holds by now is dropped
+                xSemaphoreTake(runner->notif_lock, portMAX_DELAY);
+
+                void* dropped_data = (slot->data == slot->inline_data) ? NULL : slot->data;
+                void (*dropped_dtor)(void* nd) = slot->dtor;
+                uint32_t dropped_size = slot->size;
+
+                slot->data = NULL;
+                slot->dtor = NULL;
+                slot->size = 0;
+                slot->queued = 0;
+
+                xSemaphoreGive(runner->notif_lock);
+
+                __job_runner_release_bytes(runner, dropped_size);
+
+                if(dropped_data != NULL && dropped_dtor != NULL){
+                    dropped_dtor(dropped_data);
+                }
+
+            }
+            else {
+
+                __job_runner_release_bytes(runner, notif_size);
+
+            }
+
+        }
+    
+    }
+
+    if(err == JR_SUCCESS){
+
+        __job_runner_record(runner, JOB_RUNNER_RECORD_NOTIFY, (inline_len > 0) ? JOB_RUNNER_RECORD_INLINE : 0, job_id, (inline_len > 0) ? inline_len : notif_size, 0);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_notify_job(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd) ){
+
+    return __job_runner_notify(runner, job_id, notif_data, notif_dtor, 0, 0, JOB_RUNNER_LANE_NORMAL);
+
+}
+
+jrerr_t job_runner_notify_job_urgent(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd) ){
+
+    return __job_runner_notify(runner, job_id, notif_data, notif_dtor, 0, 0, JOB_RUNNER_LANE_CONTROL);
+
+}
+
+jrerr_t job_runner_notify_job_sized(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t notif_size){
+
+    return __job_runner_notify(runner, job_id, notif_data, notif_dtor, notif_size, 0, JOB_RUNNER_LANE_NORMAL);
+
+}
+
+jrerr_t job_runner_notify_job_inline(struct job_runner* runner, int16_t job_id, const void* payload, uint8_t len){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(payload == NULL && len > 0){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(len > JOB_RUNNER_INLINE_SIZE){
+            err = JR_BUFFER_TOO_SMALL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // No bytes to copy, the caller's pointer would reach the job without anything behind it
+        err = __job_runner_notify(runner, job_id, (len > 0) ? (void*) payload : NULL, NULL, 0, len, JOB_RUNNER_LANE_NORMAL);
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_init_job(struct job_runner_job* job, const struct job_runner_job_desc* desc){
+
+    job->job_callback = desc->job_callback;
+    job->context = desc->context;
+    job->with_context = (desc->flags & JOB_RUNNER_JOB_CONTEXT) ? 1 : 0;
+    job->next_run = desc->repeat_delay;
+    job->repeat_delay = desc->repeat_delay;
+    job->job_id = -1;
+    job->notif = 0;
+    job->notif_data = NULL;
+    job->notif_dtor = NULL;
+    job->notif_size = 0;
+    job->notif_share = NULL;
+    job->topics = 0;
+    job->notif_enqueued_us = 0;
+    job->notif_dequeued_us = 0;
+    job->latency = NULL;
+    job->stack_used = 0;
+    job->busy_us = 0;
+    job->max_late = 0;
+    job->phase_pinned = (desc->flags & JOB_RUNNER_JOB_PIN_PHASE) ? 1 : 0;
+    job->parked = 0;
+    job->wcet_us = desc->wcet_us;
+    job->wcet_measured_us = 0;
+    job->notif_slot = NULL;
+    job->offload = (desc->flags & JOB_RUNNER_JOB_OFFLOAD) ? 1 : 0;
+    job->in_flight = 0;
+    job->offload_state = JOB_RUNNER_OK;
+    job->offload_data = NULL;
+    job->offload_dtor = NULL;
+    job->offload_size = 0;
+    job->offload_share = NULL;
+    job->pooled = 0;
+    job->block_index = 0;
+    job->hot_index = 0;
+    job->next = NULL;
+
+}
+
+static struct job_runner_job* __job_runner_alloc_job(void* job_callback, uint32_t repeat_delay, uint8_t flags, void* context){
+
+    struct job_runner_job* job = malloc( sizeof(struct job_runner_job) );
+
+    if(job != NULL){
+
+        // The descriptor only lives for the call, the job keeps what it needs
+        struct job_runner_job_desc desc = { .job_callback = job_callback, .repeat_delay = repeat_delay, .phase = 0, .priority = 0, .flags = flags, .wcet_us = 0,
+            .context = context };
+        __job_runner_init_job(job, &desc);
+
+    }
+
+    return job;
+
+}
+
+// Highest id in [first, first + count) in use on the list, -1 when the range is free there
+static int32_t __job_runner_highest_in_range(struct job_runner_job* list, int32_t first, uint16_t count){
+
+    int32_t highest = -1;
+
+    for(struct job_runner_job* job = list; job != NULL; job = job->next){
+        if(job->job_id >= first && job->job_id < first + count && job->job_id > highest){
+            highest = job->job_id;
+        }
+    }
+
+    return highest;
+
+}
+
+// The one place ids come from: the lowest run of count free ids on all of the runners, so a single add reuses the
+// smallest free id as it always has. Runners sharing a balancer pass all of theirs so a job keeps its id wherever it
+// moves.
+static jrerr_t __job_runner_claim_ids(struct job_runner** runners, uint8_t num_runners, uint16_t count, int16_t* base_id){
+
+    jrerr_t err = JR_SUCCESS;
+
+    int32_t next_id = 0;
+    int32_t taken = 0;
+
+    // Every id found taken moves the candidate run past it, so this ends after at most one step per job
+    while(taken >= 0){
+
+        taken = -1;
+
+        for(uint8_t i = 0; i < num_runners; i++){
+
+            int32_t highest = __job_runner_highest_in_range(runners[i]->jobs, next_id, count);
+            taken = (highest > taken) ? highest : taken;
+
+            highest = __job_runner_highest_in_range(runners[i]->paused, next_id, count);
+            taken = (highest > taken) ? highest : taken;
+
+        }
+
+        if(taken >= 0){
+            next_id = taken + 1;
+        }
+
+    }
+
+    if(next_id + count - 1 > INT16_MAX){
+        err = JR_FAIL;
+    }
+    else {
+        *base_id = next_id;
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_add_job(struct job_runner* runner, void* job_callback, uint32_t repeat_delay, uint32_t wcet_us, uint8_t flags, void* context, int16_t fixed_id, int16_t* job_id) {
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_job* new_job = NULL;
+
+    if( runner == NULL || job_callback == NULL ){
+        err = JR_NULL_POINTER;
+    }
+
+    if( err == JR_SUCCESS ){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Without a declared WCET the job only lowers the rate monotonic bound until it has been measured
+        err = __job_runner_admit(runner, 1, __job_runner_utilization(wcet_us, repeat_delay), 1);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = __job_runner_hot_reserve(runner, __job_runner_count_jobs(runner) + 1);
+    }
+
+    if(err == JR_SUCCESS){
+
+        new_job = __job_runner_alloc_job(job_callback, repeat_delay, flags, context);
+        if(new_job == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+        else {
+            new_job->wcet_us = wcet_us;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(fixed_id >= 0){
+            new_job->job_id = fixed_id;
+        }
+        else {
+            err = __job_runner_claim_ids(&runner, 1, 1, &new_job->job_id);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(job_id != NULL){
+            *job_id = new_job->job_id;
+        }
+
+        __job_runner_link_job(runner, new_job);
+
+        runner->job_bytes += __job_runner_job_bytes(new_job);
+        __job_runner_track_peak(runner);
+
+        __job_runner_record_add(runner, new_job);
+
+    }
+
+    if(err != JR_SUCCESS){
+
+        SAFE_FREE(new_job);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_add_job(struct job_runner* runner, void* job_callback, uint32_t repeat_delay, int16_t* job_id) {
+
+    return __job_runner_add_job(runner, job_callback, repeat_delay, 0, 0, NULL, -1, job_id);
+
+}
+
+jrerr_t job_runner_add_job_with_wcet(struct job_runner* runner, void* job_callback, uint32_t repeat_delay, uint32_t wcet_us, int16_t* job_id){
+
+    return __job_runner_add_job(runner, job_callback, repeat_delay, wcet_us, 0, NULL, -1, job_id);
+
+}
+
+jrerr_t job_runner_add_job_with_context(struct job_runner* runner, job_runner_context_callback_t job_callback, void* context, uint32_t repeat_delay, int16_t* job_id){
+
+    return __job_runner_add_job(runner, (void*) job_callback, repeat_delay, 0, JOB_RUNNER_JOB_CONTEXT, context, -1, job_id);
+
+}
+
+jrerr_t job_runner_add_jobs(struct job_runner* runner, const struct job_runner_job_desc* table, uint16_t count, int16_t* first_id){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_job_block* block = NULL;
+    int16_t base_id = 0;
+
+    if(runner == NULL || table == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < count; i++){
+
+        if(table[i].job_callback == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && count > 0){
+
+        // All or nothing, a table is one set of jobs
+        uint16_t extra_jobs = 0;
+        uint64_t extra = 0;
+
+        for(uint16_t i = 0; i < count; i++){
+
+            if( ! (table[i].flags & JOB_RUNNER_JOB_OFFLOAD) || runner->num_helpers == 0 ){
+                extra_jobs++;
+                extra += __job_runner_utilization(table[i].wcet_us, table[i].repeat_delay);
+            }
+
+        }
+
+        err = __job_runner_admit(runner, extra_jobs, extra, 1);
+
+    }
+
+    if(err == JR_SUCCESS && count > 0){
+        err = __job_runner_hot_reserve(runner, __job_runner_count_jobs(runner) + count);
+    }
+
+    if(err == JR_SUCCESS && count > 0){
+
+        // One pass for the ids, every table job gets the next id in line
+        err = __job_runner_claim_ids(&runner, 1, count, &base_id);
+
+    }
+
+    if(err == JR_SUCCESS && count > 0){
+
+        block = malloc( sizeof(struct job_runner_job_block) + count * sizeof(struct job_runner_job) );
+        if(block == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && count > 0){
+
+        struct job_runner_job* head = NULL;
+        struct job_runner_job* tail = NULL;
+
+        block->live = count;
+
+        for(uint16_t i = 0; i < count; i++){
+
+            struct job_runner_job* job = &block->jobs[i];
+
+            __job_runner_init_job(job, &table[i]);
+            job->job_id = base_id + i;
+            job->next_run = table[i].phase;
+            job->pooled = 1;
+            job->block_index = i;
+
+        }
+
+        // Link by descending priority, table order within a priority, so higher priority jobs are visited first
+        int16_t priority = UINT8_MAX;
+
+        while(priority >= 0){
+
+            int16_t next_priority = -1;
+
+            for(uint16_t i = 0; i < count; i++){
+
+                struct job_runner_job* job = &block->jobs[i];
+
+                if(table[i].priority == priority && ! (table[i].flags & JOB_RUNNER_JOB_PAUSED)){
+
+                    if(tail == NULL){
+                        head = job;
+                    }
+                    else {
+                        tail->next = job;
+                    }
+
+                    tail = job;
+
+                }
+                else if(table[i].priority < priority && table[i].priority > next_priority){
+
+                    next_priority = table[i].priority;
+
+                }
+
+            }
+
+            priority = next_priority;
+
+        }
+
+        if(tail != NULL){
+            tail->next = runner->jobs;
+            runner->jobs = head;
+            runner->hot_dirty = 1;
+        }
+
+        for(uint16_t i = 0; i < count; i++){
+
+            if(table[i].flags & JOB_RUNNER_JOB_PAUSED){
+                block->jobs[i].next = runner->paused;
+                runner->paused = &block->jobs[i];
+            }
+
+        }
+
+        runner->job_bytes += count * sizeof(struct job_runner_job);
+        __job_runner_track_peak(runner);
+
+        for(uint16_t i = 0; i < count; i++){
+            __job_runner_record_add(runner, &block->jobs[i]);
+        }
+
+        if(first_id != NULL){
+            *first_id = base_id;
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_phase_staggering(struct job_runner* runner, uint8_t enable){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Phases are placed once, when the runner starts
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->stagger = enable ? 1 : 0;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_job_phase(struct job_runner* runner, int16_t job_id, uint32_t phase){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_find_job(runner, &job, job_id);
+        if(err == JR_JOB_NOT_EXIST){
+            err = __job_runner_find_paused_job(runner, &job, &previous, job_id);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        job->next_run = phase;
+        job->phase_pinned = 1;
+        __job_runner_hot_sync(runner, job);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_pause_job(struct job_runner* runner, int16_t job_id){
+
+    return __job_runner_send_schedule(runner, JR_CMD_TYPE_PAUSE, job_id, 0);
+
+}
+
+jrerr_t job_runner_resume_job(struct job_runner* runner, int16_t job_id){
+
+    return __job_runner_send_schedule(runner, JR_CMD_TYPE_RESUME, job_id, 0);
+
+}
+
+struct job_runner_period_request {
+
+    int16_t job_id;
+    uint32_t repeat_delay;
+
+};
+
+static jrerr_t __job_runner_set_period_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_period_request* req = (struct job_runner_period_request*) arg;
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+
+    err = __job_runner_find_job(runner, &job, req->job_id);
+    if(err == JR_JOB_NOT_EXIST){
+        err = __job_runner_find_paused_job(runner, &job, &previous, req->job_id);
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Checked with the new period in place, put back when refused
+        uint32_t old_delay = job->repeat_delay;
+
+        job->repeat_delay = req->repeat_delay;
+
+        err = __job_runner_admit(runner, 0, 0, 1);
+        job->repeat_delay = old_delay;
+
+        if(err == JR_SUCCESS){
+            __job_runner_apply_period(runner, job, req->repeat_delay);
+            __job_runner_hot_sync(runner, job);
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_job_period(struct job_runner* runner, int16_t job_id, uint32_t repeat_delay){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_period_request req = { .job_id = job_id, .repeat_delay = repeat_delay };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS && runner->admission != JOB_RUNNER_ADMIT_OFF){
+
+        // Checked on the runner task so the caller hears about a refused period
+        err = __job_runner_call(runner, &__job_runner_set_period_call, &req);
+
+    }
+    else if(err == JR_SUCCESS){
+
+        err = __job_runner_send_schedule(runner, JR_CMD_TYPE_SET_PERIOD, job_id, repeat_delay);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_job_deadline(struct job_runner* runner, int16_t job_id, uint32_t ticks_from_now){
+
+    return __job_runner_send_schedule(runner, JR_CMD_TYPE_SET_DEADLINE, job_id, ticks_from_now);
+
+}
+
+jrerr_t job_runner_set_job_offload(struct job_runner* runner, int16_t job_id, uint8_t offload){
+
+    return __job_runner_send_schedule(runner, JR_CMD_TYPE_SET_OFFLOAD, job_id, offload ? 1 : 0);
+
+}
+
+jrerr_t job_runner_defer_job(struct job_runner* runner, uint32_t ticks){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Only the callback on the runner task has a run to defer, helpers and other tasks do not
+        if(runner->running_id < 0 || (runner->task_hnd != NULL && runner->task_hnd != xTaskGetCurrentTaskHandle())){
+            err = JR_JOB_NOT_EXIST;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->deferred = 1;
+        runner->defer_parked = (ticks == portMAX_DELAY);
+        runner->defer_ticks = (ticks > JOB_RUNNER_FAR_FUTURE) ? JOB_RUNNER_FAR_FUTURE : ticks;
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_wake_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_job* job = NULL;
+
+    jrerr_t err = __job_runner_find_job(runner, &job, *(int16_t*) arg);
+
+    if(err == JR_SUCCESS){
+
+        // Due now, without a notification the parked check would only push it out again
+        job->parked = 0;
+        job->next_run = __job_runner_now(runner);
+        __job_runner_note_deadline(runner, job);
+        __job_runner_hot_sync(runner, job);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_wake_job(struct job_runner* runner, int16_t job_id){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+        err = __job_runner_call(runner, &__job_runner_wake_call, &job_id);
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_tick(struct job_runner* runner, uint32_t* tick){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || tick == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+        *tick = __job_runner_now(runner);
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_start(struct job_runner* runner, const char* runner_name, uint32_t runner_stack, unsigned int priority, int core_id, int8_t held){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || runner_name == NULL){
+
+        err = JR_NULL_POINTER;
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && runner->boost_enabled && runner->boost.priority <= priority){
+
+        // A boost that is not above the base would lower the task or do nothing at all
+        ESP_LOGE("Job Runner","Boost priority %u is not above the base priority %u", runner->boost.priority, priority);
+        err = JR_FAIL;
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->started = 1;
+        runner->held = held;
+        runner->stack_size = runner_stack;
+        runner->base_priority = priority;
+
+        BaseType_t core = (core_id == JOB_RUNNER_NO_AFFINITY) ? tskNO_AFFINITY : core_id;
+
+        // Helpers come up first, calibration may already hand them jobs
+        for(uint8_t i = 0; i < runner->num_helpers; i++){
+
+            BaseType_t hlerr = xTaskCreatePinnedToCore(&__job_runner_helper_task, "jr_helper", runner->helper_stack, runner, runner->helper_priority, NULL, tskNO_AFFINITY);
+            if(hlerr != pdPASS){
+
+                // Offloaded jobs fall back to running inline when no helper is left
+                ESP_LOGE("Job Runner","Failed to start helper %u", (unsigned int) i);
+                break;
+
+            }
+
+            runner->helpers_running++;
+
+        }
+
+        BaseType_t crerr = xTaskCreatePinnedToCore(&__job_runner_task, runner_name, runner_stack, runner, priority, &runner->task_hnd, core);
+        if(crerr != pdPASS){
+            __job_runner_stop_helpers(runner, 0);
+            runner->started = 0;
+            err = JR_FAIL;
+        }
+
+    }
+
+    return err;
+
+}
+
+// Only for a runner started held, its task is still waiting and has not touched a job
+static void __job_runner_unstart(struct job_runner* runner){
+
+    vTaskDelete(runner->task_hnd);
+    runner->task_hnd = NULL;
+
+    __job_runner_stop_helpers(runner, 0);
+
+    runner->held = 0;
+    runner->started = 0;
+
+}
+
+jrerr_t job_runner_execute_pinned(struct job_runner* runner, const char* runner_name, uint32_t runner_stack, unsigned int priority, int core_id){
+
+    return __job_runner_start(runner, runner_name, runner_stack, priority, core_id, 0);
+
+}
+
+jrerr_t job_runner_execute(struct job_runner* runner, const char* runner_name, uint32_t runner_stack, unsigned int priority){
+
+    return job_runner_execute_pinned(runner, runner_name, runner_stack, priority, JOB_RUNNER_NO_AFFINITY);
+
+}
+
+jrerr_t job_runner_migrate_job(struct job_runner* runner, int16_t job_id, struct job_runner* target){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || target == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->cmd_queue == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        struct job_cmd cmd = { .type = JR_CMD_TYPE_MIGRATE, .job_id = job_id, .cmd_data = target, .cmd_dtor = NULL, .cmd_arg = 0, .enqueued_us = __job_runner_now_us(runner) };
+        err = __job_runner_send_lane(runner, &cmd, JOB_RUNNER_LANE_NORMAL);
+
+    }
+
+    return err;
+
+}
+
+static struct job_runner_done_group* __job_runner_done_group(int16_t slot){
+
+    struct job_runner_done_group* group = __atomic_load_n(&job_runner_done_groups, __ATOMIC_ACQUIRE);
+
+    while(group != NULL && group->index != slot / JOB_RUNNER_DONE_BITS){
+        group = __atomic_load_n(&group->next, __ATOMIC_ACQUIRE);
+    }
+
+    return group;
+
+}
+
+static jrerr_t __job_runner_add_done_group(void){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_done_group* group = malloc(sizeof(struct job_runner_done_group));
+
+    if(group == NULL){
+        err = JR_MEMORY_ALLOC_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+
+        *group = (struct job_runner_done_group) { .group = xEventGroupCreate(), .claimed = 0, .index = 0, .next = NULL };
+
+        if(group->group == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        struct job_runner_done_group** tail = &job_runner_done_groups;
+
+        // Two tasks may run out of bits at the same time, both groups are kept
+        portENTER_CRITICAL(&job_runner_done_mux);
+
+        while(*tail != NULL){
+            group->index = (*tail)->index + 1;
+            tail = &(*tail)->next;
+        }
+
+        if((int32_t) (group->index + 1) * JOB_RUNNER_DONE_BITS <= INT16_MAX){
+            __atomic_store_n(tail, group, __ATOMIC_RELEASE);
+            group = NULL;
+        }
+        else {
+            err = JR_FAIL;
+        }
+
+        portEXIT_CRITICAL(&job_runner_done_mux);
+
+    }
+
+    if(group != NULL){
+
+        if(group->group != NULL){
+            vEventGroupDelete(group->group);
+        }
+
+        free(group);
+
+    }
+
+    return err;
+
+}
+
+// The first group is made with the first runner, so a runner that was created can always hand out a handle
+static jrerr_t __job_runner_prepare_done_groups(void){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(__atomic_load_n(&job_runner_done_groups, __ATOMIC_ACQUIRE) == NULL){
+        err = __job_runner_add_done_group();
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_claim_done_slot(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel){
+
+    jrerr_t err = JR_SUCCESS;
+
+    // A runner reports to one slot, asking again hands out the handle it already has
+    int16_t slot = runner->done_slot;
+    int8_t claimed = (slot < 0);
+
+    while(err == JR_SUCCESS && slot < 0){
+
+        portENTER_CRITICAL(&job_runner_done_mux);
+
+        for(struct job_runner_done_group* group = job_runner_done_groups; slot < 0 && group != NULL; group = group->next){
+
+            for(int bit = 0; bit < JOB_RUNNER_DONE_BITS; bit++){
+
+                if( ! (group->claimed & (1 << bit)) ){
+                    group->claimed |= (1 << bit);
+                    slot = group->index * JOB_RUNNER_DONE_BITS + bit;
+                    break;
+                }
+
+            }
+
+        }
+
+        portEXIT_CRITICAL(&job_runner_done_mux);
+
+        if(slot < 0){
+            err = __job_runner_add_done_group();
+        }
+
+    }
+
+    if(err == JR_SUCCESS && claimed){
+
+        xEventGroupClearBits(__job_runner_done_group(slot)->group, 1 << (slot % JOB_RUNNER_DONE_BITS));
+        runner->done_slot = slot;
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // The handle is the slot plus one so it is never NULL, it outlives the runner it was taken from
+        *shutdown_resp_channel = (job_runner_shutdown_response_handle_t) (uintptr_t) (slot + 1);
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_release_done_slot(int16_t slot){
+
+    struct job_runner_done_group* group = __job_runner_done_group(slot);
+
+    xEventGroupClearBits(group->group, 1 << (slot % JOB_RUNNER_DONE_BITS));
+
+    portENTER_CRITICAL(&job_runner_done_mux);
+    group->claimed &= ~(1 << (slot % JOB_RUNNER_DONE_BITS));
+    portEXIT_CRITICAL(&job_runner_done_mux);
+
+}
+
+static jrerr_t __job_runner_done_slot(job_runner_shutdown_response_handle_t shutdown_resp_channel, int16_t* slot){
+
+    uintptr_t handle = (uintptr_t) shutdown_resp_channel;
+    struct job_runner_done_group* group = NULL;
+
+    if(handle == 0){
+        return JR_NULL_POINTER;
+    }
+
+    if(handle > INT16_MAX){
+        return JR_INVALID_SHUTDOWN_CODE;
+    }
+
+    *slot = (int16_t) (handle - 1);
+    group = __job_runner_done_group(*slot);
+
+    if(group == NULL || ! (group->claimed & (1 << (*slot % JOB_RUNNER_DONE_BITS))) ){
+        return JR_INVALID_SHUTDOWN_CODE;
+    }
+
+    return JR_SUCCESS;
+
+}
+
+jrerr_t job_runner_shutdown(struct job_runner* runner){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if( ! runner->started ){
+            err = JR_NOT_STARTED;
+        }
+    
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Cleared first, the runner may free itself as soon as it has the command
+        runner->started = 0;
+
+        if(runner->task_hnd == NULL || runner->task_hnd == xTaskGetCurrentTaskHandle()){
+
+            // Simulated, or a job shutting its own runner down, the flag is read at the top of the next loop
+            runner->shutdown_pending = 1;
+
+        }
+        else {
+
+            // The control lane is taken before cmd_queue, a backed up normal lane cannot hold the shutdown back
+            struct job_cmd cmd = { .type = JR_CMD_TYPE_SHUTDOWN, .job_id = -1, .cmd_data = NULL, .cmd_dtor = NULL, .enqueued_us = __job_runner_now_us(runner) };
+            err = __job_runner_send_lane(runner, &cmd, JOB_RUNNER_LANE_CONTROL);
+
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_shutdown_async(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || shutdown_resp_channel == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if( ! runner->started ){
+            err = JR_NOT_STARTED;
+        }
+    
+    }
+
+    int16_t previous = -1;
+
+    if(err == JR_SUCCESS){
+
+        previous = runner->done_slot;
+        err = __job_runner_claim_done_slot(runner, shutdown_resp_channel);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_shutdown(runner);
+
+        // Nobody would ever set a slot claimed for a shutdown that was not sent, one from an earlier call stays
+        if(err != JR_SUCCESS && previous < 0){
+
+            __job_runner_release_done_slot(runner->done_slot);
+            runner->done_slot = -1;
+            *shutdown_resp_channel = NULL;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_await_shutdown(job_runner_shutdown_response_handle_t shutdown_resp_channel, uint32_t ticks_to_wait){
+
+    return job_runner_await_all(&shutdown_resp_channel, 1, ticks_to_wait);
+
+}
+
+jrerr_t job_runner_await_all(job_runner_shutdown_response_handle_t* shutdown_resp_channels, uint16_t count, uint32_t ticks_to_wait){
+
+    jrerr_t err = JR_SUCCESS;
+
+    int16_t slot = 0;
+
+    if(shutdown_resp_channels == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < count; i++){
+
+        err = __job_runner_done_slot(shutdown_resp_channels[i], &slot);
+
+    }
+
+    TickType_t start = xTaskGetTickCount();
+
+    struct job_runner_done_group* group = __atomic_load_n(&job_runner_done_groups, __ATOMIC_ACQUIRE);
+
+    for( ; err == JR_SUCCESS && group != NULL; group = __atomic_load_n(&group->next, __ATOMIC_ACQUIRE)){
+
+        EventBits_t mask = 0;
+
+        for(uint16_t i = 0; i < count; i++){
+
+            __job_runner_done_slot(shutdown_resp_channels[i], &slot);
+
+            if(slot / JOB_RUNNER_DONE_BITS == group->index){
+                mask |= 1 << (slot % JOB_RUNNER_DONE_BITS);
+            }
+
+        }
+
+        if(mask == 0){
+            continue;
+        }
+
+        TickType_t wait = ticks_to_wait;
+
+        if(ticks_to_wait != portMAX_DELAY){
+
+            // One deadline for the whole call, however many groups it spans
+            TickType_t elapsed = xTaskGetTickCount() - start;
+            wait = (elapsed < ticks_to_wait) ? ticks_to_wait - elapsed : 0;
+
+        }
+
+        // Bits are left set so a timed out wait can simply be repeated
+        EventBits_t bits = xEventGroupWaitBits(group->group, mask, pdFALSE, pdTRUE, wait);
+        if((bits & mask) != mask){
+            err = JR_TIMEOUT;
+        }
+
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < count; i++){
+
+        // Every runner is done, the handles are used up
+        __job_runner_done_slot(shutdown_resp_channels[i], &slot);
+        __job_runner_release_done_slot(slot);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_shutdown_response_handle(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || shutdown_resp_channel == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_claim_done_slot(runner, shutdown_resp_channel);
+
+    } 
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_stack_monitor(struct job_runner* runner, job_runner_stack_monitor_t mode){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->stack_monitor = mode;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_stack_stats(struct job_runner* runner, struct job_runner_stack_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        stats->stack_size = runner->stack_size;
+        stats->min_free = runner->stack_min_free;
+        stats->deepest_job_id = runner->stack_deepest_job;
+        stats->recommended_stack = 0;
+
+        if(stats->min_free <= stats->stack_size){
+
+            uint32_t used = stats->stack_size - stats->min_free;
+
+            // Round up to a 16 byte boundary to keep the stack aligned
+            stats->recommended_stack = (used + JOB_RUNNER_STACK_MARGIN + 15) & ~((uint32_t) 15);
+
+        } 
+        else {
+
+            // Nothing measured yet
+            stats->min_free = stats->stack_size;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_get_notif_slot(struct job_runner* runner, int16_t job_id, struct job_runner_notif_slot** slot){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+
+    if(runner->started){
+        err = JR_ALREADY_STARTED;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // A job registered paused or paused before the start takes notifications too
+        err = __job_runner_find_job(runner, &job, job_id);
+        if(err == JR_JOB_NOT_EXIST){
+            err = __job_runner_find_paused_job(runner, &job, &previous, job_id);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        *slot = __job_runner_find_notif_slot(runner, job_id);
+
+        if(*slot == NULL){
+
+            struct job_runner_notif_slot* slots = realloc(runner->notif_slots, (runner->num_notif_slots + 1) * sizeof(struct job_runner_notif_slot));
+            if(slots == NULL){
+                err = JR_MEMORY_ALLOC_FAIL;
+            }
+            else {
+
+                runner->notif_slots = slots;
+                *slot = &slots[runner->num_notif_slots];
+                runner->num_notif_slots++;
+
+                memset(*slot, 0, sizeof(struct job_runner_notif_slot));
+                (*slot)->job_id = job_id;
+                (*slot)->mode = JOB_RUNNER_COALESCE_NONE;
+
+                // realloc may have moved the table, point every job back at its slot, paused ones included
+                for(job = runner->jobs; job != NULL; job = job->next){
+                    job->notif_slot = __job_runner_find_notif_slot(runner, job->job_id);
+                }
+
+                for(job = runner->paused; job != NULL; job = job->next){
+                    job->notif_slot = __job_runner_find_notif_slot(runner, job->job_id);
+                }
+
+            }
+
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_notif_coalescing(struct job_runner* runner, int16_t job_id, job_runner_coalesce_t mode, void* (*merge)(void* pending, void* incoming)){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_notif_slot* slot = NULL;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(mode == JOB_RUNNER_COALESCE_MERGE && merge == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_get_notif_slot(runner, job_id, &slot);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        slot->mode = mode;
+        slot->merge = merge;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_notif_rate(struct job_runner* runner, int16_t job_id, uint32_t per_second, uint32_t burst){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_notif_slot* slot = NULL;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_get_notif_slot(runner, job_id, &slot);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // A rate of 0 turns limiting off, the bucket starts full
+        slot->rate = per_second;
+        slot->capacity = ((burst > 0) ? burst : 1) * configTICK_RATE_HZ;
+        slot->tokens = slot->capacity;
+        slot->refill_tick = __job_runner_now(runner);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_notif_stats(struct job_runner* runner, int16_t job_id, struct job_runner_notif_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_notif_slot* slot = NULL;
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        slot = __job_runner_find_notif_slot(runner, job_id);
+        if(slot == NULL){
+            err = JR_JOB_NOT_EXIST;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        xSemaphoreTake(runner->notif_lock, portMAX_DELAY);
+        *stats = slot->stats;
+        xSemaphoreGive(runner->notif_lock);
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_call(struct job_runner* runner, jrerr_t (*fn)(struct job_runner* runner, void* arg), void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+    jrerr_t resp = JR_FAIL;
+
+    struct job_runner_call call = { .fn = fn, .arg = arg, .resp = NULL };
+
+    if(runner->task_hnd == NULL || runner->task_hnd == xTaskGetCurrentTaskHandle()){
+
+        // Not running yet or called from a job, the lists are ours to touch
+        return fn(runner, arg);
+
+    }
+
+    call.resp = xQueueCreate(1, sizeof(jrerr_t));
+    if(call.resp == NULL){
+        err = JR_MEMORY_ALLOC_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // The caller is blocked until it is answered, it does not wait behind queued notifications
+        struct job_cmd cmd = { .type = JR_CMD_TYPE_CALL, .cmd_data = &call, .cmd_dtor = NULL, .enqueued_us = __job_runner_now_us(runner) };
+        err = __job_runner_send_lane(runner, &cmd, JOB_RUNNER_LANE_CONTROL);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Always answered, a runner that shuts down first answers with JR_NOT_STARTED
+        xQueueReceive(call.resp, &resp, portMAX_DELAY);
+        err = resp;
+
+    }
+
+    if(call.resp != NULL){
+        vQueueDelete(call.resp);
+    }
+
+    return err;
+
+}
+
+job_runner_topic_t job_runner_topic(const char* name){
+
+    uint32_t hash = 2166136261u;
+
+    for( ; name != NULL && *name != '\0'; name++){
+        hash = (hash ^ (uint8_t) *name) * 16777619u;
+    }
+
+    return hash | JOB_RUNNER_TOPIC_NAMED;
+
+}
+
+jrerr_t job_runner_subscribe(struct job_runner* runner, int16_t job_id, job_runner_topic_t topic){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_sub_request req = { .job_id = job_id, .topic = topic, .subscribe = 1 };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_subscribe_call, &req);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_unsubscribe(struct job_runner* runner, int16_t job_id, job_runner_topic_t topic){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_sub_request req = { .job_id = job_id, .topic = topic, .subscribe = 0 };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_subscribe_call, &req);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_publish(struct job_runner* runner, job_runner_topic_t topic, void* data, void (*dtor)(void* data)){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->cmd_queue == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // One command however many subscribers, the runner fans it out from its index
+        struct job_cmd cmd = { .type = JR_CMD_TYPE_PUBLISH, .job_id = -1, .cmd_data = data, .cmd_dtor = dtor, .cmd_arg = topic, .enqueued_us = __job_runner_now_us(runner),
+            .cmd_seq = __job_runner_next_seq(runner) };
+
+        err = __job_runner_send_lane(runner, &cmd, JOB_RUNNER_LANE_NORMAL);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_notify_job_at(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t tick, job_runner_timer_t* handle){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_cmd cmd = { .type = JR_CMD_TYPE_TIMER, .job_id = job_id, .cmd_data = notif_data, .cmd_dtor = notif_dtor, .cmd_arg = tick, .cmd_handle = 0,
+        .enqueued_us = 0 };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->cmd_queue == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Stamped once the runner is known to exist, the clock lives in it
+        cmd.enqueued_us = __job_runner_now_us(runner);
+
+        // Handed out before the runner has seen the timer, 0 is never used so callers can keep it as "none"
+        do {
+            cmd.cmd_handle = __atomic_add_fetch(&runner->next_timer_handle, 1, __ATOMIC_SEQ_CST);
+        } while(cmd.cmd_handle == 0);
+
+        if(runner->task_hnd == NULL || runner->task_hnd == xTaskGetCurrentTaskHandle()){
+
+            // Not running yet or called from a job, straight into the heap
+            err = __job_runner_schedule_timer(runner, &cmd);
+
+        }
+        else {
+
+            // The control lane, where the cancel call goes, a cancel cannot overtake its own timer
+            err = __job_runner_send_lane(runner, &cmd, JOB_RUNNER_LANE_CONTROL);
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && handle != NULL){
+        *handle = cmd.cmd_handle;
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_notify_job_delayed(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t delay, job_runner_timer_t* handle){
+
+    if(runner == NULL){
+        return JR_NULL_POINTER;
+    }
+
+    return job_runner_notify_job_at(runner, job_id, notif_data, notif_dtor, __job_runner_now(runner) + delay, handle);
+
+}
+
+static jrerr_t __job_runner_cancel_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_NOT_PENDING;
+
+    job_runner_timer_t handle = *(job_runner_timer_t*) arg;
+
+    for(uint16_t i = 0; i < runner->num_timers; i++){
+
+        if(runner->timers[i].handle == handle){
+
+            struct job_runner_timer timer = runner->timers[i];
+            __job_runner_timer_remove(runner, i);
+
+            if(timer.data && timer.dtor){
+                timer.dtor(timer.data);
+            }
+
+            err = JR_SUCCESS;
+            break;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_cancel_notification(struct job_runner* runner, job_runner_timer_t handle){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Timers and calls share the control lane, a handle just handed out is already in the heap
+        err = __job_runner_call(runner, &__job_runner_cancel_call, &handle);
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_latency_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_latency_request* req = (struct job_runner_latency_request*) arg;
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+
+    if(req->job_id < 0){
+
+        if(req->reset){
+
+            memset(&runner->latency, 0, sizeof(runner->latency));
+
+            // The job histograms stay allocated, their jobs will most likely be notified again
+            for(job = runner->jobs; job != NULL; job = job->next){
+                if(job->latency){
+                    memset(job->latency, 0, sizeof(struct job_runner_latency_stats));
+                }
+            }
+
+            for(job = runner->paused; job != NULL; job = job->next){
+                if(job->latency){
+                    memset(job->latency, 0, sizeof(struct job_runner_latency_stats));
+                }
+            }
+
+        }
+        else {
+
+            *req->stats = runner->latency;
+
+        }
+
+        return err;
+
+    }
+
+    err = __job_runner_find_job(runner, &job, req->job_id);
+    if(err == JR_JOB_NOT_EXIST){
+        err = __job_runner_find_paused_job(runner, &job, &previous, req->job_id);
+    }
+
+    if(err == JR_SUCCESS && req->reset){
+
+        if(job->latency){
+            memset(job->latency, 0, sizeof(struct job_runner_latency_stats));
+        }
+
+    }
+    else if(err == JR_SUCCESS){
+
+        if(job->latency){
+            *req->stats = *job->latency;
+        }
+        else {
+            memset(req->stats, 0, sizeof(struct job_runner_latency_stats));
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_latency(struct job_runner* runner, int16_t job_id, struct job_runner_latency_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_latency_request req = { .job_id = job_id, .stats = stats, .reset = 0 };
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Copied on the runner task, the three histograms always come from the same set of samples
+        err = __job_runner_call(runner, &__job_runner_latency_call, &req);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_reset_latency(struct job_runner* runner, int16_t job_id){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_latency_request req = { .job_id = job_id, .stats = NULL, .reset = 1 };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_latency_call, &req);
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_track_latency_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_track_request* req = (struct job_runner_track_request*) arg;
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+    struct job_runner_latency_stats* spare = req->stats;
+
+    err = __job_runner_find_job(runner, &job, req->job_id);
+    if(err == JR_JOB_NOT_EXIST){
+        err = __job_runner_find_paused_job(runner, &job, &previous, req->job_id);
+    }
+
+    if(err == JR_SUCCESS && req->enable && job->latency == NULL){
+
+        job->latency = spare;
+        spare = NULL;
+
+        runner->job_bytes += sizeof(struct job_runner_latency_stats);
+        __job_runner_track_peak(runner);
+
+    }
+    else if(err == JR_SUCCESS && ! req->enable && job->latency != NULL){
+
+        spare = job->latency;
+        job->latency = NULL;
+
+        runner->job_bytes -= sizeof(struct job_runner_latency_stats);
+
+    }
+
+    // Whatever the job did not take is freed by the caller, off the runner task
+    req->stats = spare;
+
+    return err;
+
+}
+
+jrerr_t job_runner_track_latency(struct job_runner* runner, int16_t job_id, int8_t enable){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_track_request req = { .job_id = job_id, .stats = NULL, .enable = enable };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS && enable){
+
+        req.stats = calloc(1, sizeof(struct job_runner_latency_stats));
+
+        if(req.stats == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_track_latency_call, &req);
+
+    }
+
+    if(req.stats != NULL){
+        free(req.stats);
+    }
+
+    return err;
+
+}
+
+static void __job_runner_inspect_list(struct job_runner_job* job, uint8_t flags, TickType_t now, struct job_runner_inspect_request* req){
+
+    for( ; job != NULL; job = job->next){
+
+        if(flags & JOB_RUNNER_INFO_PAUSED){
+            req->info->num_paused++;
+        }
+        else {
+            req->info->num_jobs++;
+        }
+
+        if(job->notif){
+            req->info->pending_notifs++;
+        }
+
+        if(req->filled < req->max_jobs){
+
+            req->jobs[req->filled++] = (struct job_runner_job_info) {
+                .job_id = job->job_id,
+                .flags = flags | (job->offload ? JOB_RUNNER_INFO_OFFLOAD : 0) | (job->in_flight ? JOB_RUNNER_INFO_IN_FLIGHT : 0) | (job->notif ? JOB_RUNNER_INFO_NOTIFIED : 0),
+                .topics = job->topics,
+                .repeat_delay = job->repeat_delay,
+                .next_in = (flags & JOB_RUNNER_INFO_PAUSED) ? 0 : (int32_t) (job->next_run - now),
+                .max_late = job->max_late,
+                .busy_us = job->busy_us,
+                .wcet_us = __job_runner_job_wcet(job)
+            };
+
+        }
+
+    }
+
+}
+
+static jrerr_t __job_runner_inspect_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_inspect_request* req = (struct job_runner_inspect_request*) arg;
+    struct job_runner_info* info = req->info;
+
+    memset(info, 0, sizeof(struct job_runner_info));
+
+    info->state = runner->state;
+    info->started = runner->started;
+    info->queue_used = uxQueueMessagesWaiting(runner->cmd_queue);
+    info->queue_size = JOB_RUNNER_CMD_QUEUE_LEN;
+    info->window_us = (uint32_t) esp_timer_get_time() - runner->load_mark_us;
+    info->busy_us = runner->busy_us;
+    info->dispatched = runner->dispatched;
+    info->wakeups = runner->wakeups;
+    info->effective_delay = runner->effective_delay;
+    info->job_bytes = runner->job_bytes;
+    info->notif_bytes = __atomic_load_n(&runner->notif_bytes, __ATOMIC_SEQ_CST);
+    info->pending_timers = runner->num_timers;
+
+    struct job_runner_sched_stats sched;
+    __job_runner_sched_stats(runner, 0, 0, &sched);
+
+    info->utilization = sched.utilization;
+    info->headroom = sched.headroom;
+
+    TickType_t now = __job_runner_base(runner);
+
+    __job_runner_inspect_list(runner->jobs, 0, now, req);
+    __job_runner_inspect_list(runner->paused, JOB_RUNNER_INFO_PAUSED, now, req);
+
+    return JR_SUCCESS;
+
+}
+
+jrerr_t job_runner_inspect(struct job_runner* runner, struct job_runner_info* info, struct job_runner_job_info* jobs, uint16_t max_jobs, uint16_t* num_filled){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_inspect_request req = { .info = info, .jobs = jobs, .max_jobs = (jobs != NULL) ? max_jobs : 0, .filled = 0 };
+
+    if(runner == NULL || info == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Taken between two loop iterations, every job is seen in the same pass and the runner only pauses for the copy
+        err = __job_runner_call(runner, &__job_runner_inspect_call, &req);
+
+    }
+
+    if(num_filled != NULL){
+        *num_filled = req.filled;
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_dump(struct job_runner* runner, FILE* out){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_info info;
+    struct job_runner_job_info* jobs = NULL;
+    uint16_t filled = 0;
+
+    if(runner == NULL || out == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Sized from a first look, jobs added in between are left out of the table
+        err = job_runner_inspect(runner, &info, NULL, 0, NULL);
+
+    }
+
+    if(err == JR_SUCCESS && info.num_jobs + info.num_paused > 0){
+
+        jobs = malloc((info.num_jobs + info.num_paused) * sizeof(struct job_runner_job_info));
+        if(jobs == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && jobs != NULL){
+
+        err = job_runner_inspect(runner, &info, jobs, info.num_jobs + info.num_paused, &filled);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        const char* states[] = { "keep alive", "done", "running", "shutting down" };
+
+        fprintf(out, "runner %p: %s, %u jobs, %u paused, %u notifications pending, %u delayed, queue %u/%u, cpu %u%%, wcet load %u.%u%% (headroom %d.%u%%), delay %u, %u wakeups, %u dispatched, %u+%u bytes\n",
+            (void*) runner, info.started ? states[info.state] : "not started", (unsigned int) info.num_jobs, (unsigned int) info.num_paused,
+            (unsigned int) info.pending_notifs, (unsigned int) info.pending_timers, (unsigned int) info.queue_used, (unsigned int) info.queue_size,
+            (unsigned int) (info.window_us ? ((uint64_t) info.busy_us * 100) / info.window_us : 0),
+            (unsigned int) (info.utilization / 10), (unsigned int) (info.utilization % 10), (int) (info.headroom / 10),
+            (unsigned int) ((info.headroom < 0 ? -info.headroom : info.headroom) % 10), (unsigned int) info.effective_delay,
+            (unsigned int) info.wakeups, (unsigned int) info.dispatched, (unsigned int) info.job_bytes, (unsigned int) info.notif_bytes);
+
+        fprintf(out, "  %6s %10s %10s %8s %5s %8s %5s %6s\n", "id", "period", "next in", "max late", "cpu%", "wcet us", "flags", "topics");
+
+        for(uint16_t i = 0; i < filled; i++){
+
+            struct job_runner_job_info* job = &jobs[i];
+
+            fprintf(out, "  %6d %10u %10d %8u %5u %8u  %c%c%c%c %6u\n", (int) job->job_id, (unsigned int) job->repeat_delay, (int) job->next_in,
+                (unsigned int) job->max_late, (unsigned int) (info.window_us ? ((uint64_t) job->busy_us * 100) / info.window_us : 0), (unsigned int) job->wcet_us,
+                (job->flags & JOB_RUNNER_INFO_PAUSED) ? 'P' : '-', (job->flags & JOB_RUNNER_INFO_OFFLOAD) ? 'O' : '-',
+                (job->flags & JOB_RUNNER_INFO_IN_FLIGHT) ? 'F' : '-', (job->flags & JOB_RUNNER_INFO_NOTIFIED) ? 'N' : '-', (unsigned int) job->topics);
+
+        }
+
+    }
+
+    SAFE_FREE(jobs);
+
+    return err;
+
+}
+
+// The console's own copy of the runners it dumps. A runner clears its entry under the lock before it is freed, so the
+// command never touches a runner that is gone.
+static struct job_runner** job_runner_console_runners = NULL;
+static uint8_t job_runner_console_num_runners = 0;
+static SemaphoreHandle_t job_runner_console_lock = NULL;
+
+static int __job_runner_console_cmd(int argc, char** argv){
+
+    xSemaphoreTake(job_runner_console_lock, portMAX_DELAY);
+
+    for(uint8_t i = 0; i < job_runner_console_num_runners; i++){
+
+        if(job_runner_console_runners[i] == NULL){
+            printf("runner %u: shut down\n", (unsigned int) i);
+            continue;
+        }
+
+        jrerr_t err = job_runner_dump(job_runner_console_runners[i], stdout);
+        if(err != JR_SUCCESS){
+            printf("runner %u: inspect failed code %d\n", (unsigned int) i, (int) err);
+        }
+
+    }
+
+    xSemaphoreGive(job_runner_console_lock);
+
+    return 0;
+
+}
+
+static void __job_runner_console_forget(struct job_runner* runner){
+
+    if(job_runner_console_lock == NULL){
+        return;
+    }
+
+    // The command may hold the lock while it waits on a call to this runner, keep answering until it lets go
+    while(xSemaphoreTake(job_runner_console_lock, 1) != pdTRUE){
+
+        if(runner->ctl_queue){
+            __job_runner_release_cmds(runner->ctl_queue);
+        }
+
+    }
+
+    for(uint8_t i = 0; i < job_runner_console_num_runners; i++){
+
+        if(job_runner_console_runners[i] == runner){
+            job_runner_console_runners[i] = NULL;
+        }
+
+    }
+
+    xSemaphoreGive(job_runner_console_lock);
+
+}
+
+jrerr_t job_runner_console_register(struct job_runner** runners, uint8_t num_runners){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner** copy = NULL;
+
+    if(runners == NULL && num_runners > 0){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS && job_runner_console_lock == NULL){
+
+        job_runner_console_lock = xSemaphoreCreateMutex();
+        if(job_runner_console_lock == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && num_runners > 0){
+
+        copy = malloc(num_runners * sizeof(struct job_runner*));
+        if(copy == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+        else {
+            memcpy(copy, runners, num_runners * sizeof(struct job_runner*));
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        xSemaphoreTake(job_runner_console_lock, portMAX_DELAY);
+
+        SAFE_FREE(job_runner_console_runners);
+        job_runner_console_runners = copy;
+        job_runner_console_num_runners = num_runners;
+
+        xSemaphoreGive(job_runner_console_lock);
+
+        const esp_console_cmd_t cmd = {
+            .command = "jobs",
+            .help = "Dump every job runner: jobs, periods, deadlines, lateness, queue occupancy and cpu share",
+            .hint = NULL,
+            .func = &__job_runner_console_cmd,
+        };
+
+        if(esp_console_cmd_register(&cmd) != ESP_OK){
+            err = JR_FAIL;
+        }
+
+    }
+
+    return err;
+
+}
+
+static void __job_runner_snapshot_list(struct job_runner_job* job, uint8_t flags, TickType_t now, uint8_t** out){
+
+    for( ; job != NULL; job = job->next){
+
+        int32_t next_in = (int32_t) (job->next_run - now);
+
+        struct job_runner_snapshot_entry entry = {
+            .job_id = job->job_id,
+            .flags = flags | (job->offload ? JOB_RUNNER_SNAPSHOT_OFFLOAD : 0) | (job->with_context ? JOB_RUNNER_SNAPSHOT_CONTEXT : 0)
+                | (job->phase_pinned ? JOB_RUNNER_SNAPSHOT_PIN_PHASE : 0),
+            .reserved = 0,
+            .repeat_delay = job->repeat_delay,
+            .next_in = (next_in > 0) ? (uint32_t) next_in : 0
+        };
+
+        memcpy(*out, &entry, sizeof(entry));
+        *out += sizeof(entry);
+
+    }
+
+}
+
+static jrerr_t __job_runner_snapshot_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_snapshot_request* req = (struct job_runner_snapshot_request*) arg;
+    struct job_runner_snapshot_header header = { .magic = JOB_RUNNER_SNAPSHOT_MAGIC, .version = JOB_RUNNER_SNAPSHOT_VERSION, .count = 0 };
+
+    for(struct job_runner_job* job = runner->jobs; job != NULL; job = job->next){
+        header.count++;
+    }
+
+    for(struct job_runner_job* job = runner->paused; job != NULL; job = job->next){
+        header.count++;
+    }
+
+    req->used = sizeof(header) + header.count * sizeof(struct job_runner_snapshot_entry);
+
+    if(req->buffer == NULL){
+
+        // Sized on the runner task so the table cannot change between measuring and filling
+        req->buffer = malloc(req->used);
+        req->size = req->used;
+
+        if(req->buffer == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+    else if(req->size < req->used){
+
+        err = JR_BUFFER_TOO_SMALL;
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        TickType_t now = __job_runner_base(runner);
+        uint8_t* out = req->buffer;
+
+        memcpy(out, &header, sizeof(header));
+        out += sizeof(header);
+
+        __job_runner_snapshot_list(runner->jobs, 0, now, &out);
+        __job_runner_snapshot_list(runner->paused, JOB_RUNNER_SNAPSHOT_PAUSED, now, &out);
+
+    }
+
+    return err;
+
+}
+
+static const struct job_runner_restore_entry* __job_runner_restore_lookup(const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks, int16_t job_id){
+
+    for(uint16_t i = 0; i < num_callbacks; i++){
+
+        if(callbacks[i].job_id == job_id && callbacks[i].job_callback != NULL){
+            return &callbacks[i];
+        }
+
+    }
+
+    return NULL;
+
+}
+
+jrerr_t job_runner_snapshot(struct job_runner* runner, void* buffer, size_t size, size_t* used){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_snapshot_request req = { .buffer = buffer, .size = size, .used = 0 };
+
+    if(runner == NULL || buffer == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_snapshot_call, &req);
+
+    }
+
+    if(used != NULL){
+        *used = req.used;
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_restore(struct job_runner* runner, const void* buffer, size_t size, const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_snapshot_header header = {0};
+    struct job_runner_snapshot_entry entry;
+    struct job_runner_job** jobs = NULL;
+    const uint8_t* entries = NULL;
+
+    if(runner == NULL || buffer == NULL || callbacks == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(size < sizeof(header)){
+            err = JR_INVALID_SNAPSHOT;
+        }
+        else {
+            memcpy(&header, buffer, sizeof(header));
+            entries = (const uint8_t*) buffer + sizeof(header);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(header.magic != JOB_RUNNER_SNAPSHOT_MAGIC || header.version != JOB_RUNNER_SNAPSHOT_VERSION || size < sizeof(header) + header.count * sizeof(entry)){
+            err = JR_INVALID_SNAPSHOT;
+        }
+
+    }
+
+    // Validate everything first so the runner is either fully restored or left untouched
+    for(uint16_t i = 0; err == JR_SUCCESS && i < header.count; i++){
+
+        memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+
+        if(entry.job_id < 0){
+            err = JR_INVALID_SNAPSHOT;
+        }
+        else if(__job_runner_contains_job(runner, entry.job_id)){
+            err = JR_FAIL;
+        }
+        else if(__job_runner_restore_lookup(callbacks, num_callbacks, entry.job_id) == NULL){
+            err = JR_JOB_NOT_EXIST;
+        }
+
+        // A snapshot never holds an id twice, one that does was not written by job_runner_snapshot
+        for(uint16_t j = 0; err == JR_SUCCESS && j < i; j++){
+
+            struct job_runner_snapshot_entry earlier;
+            memcpy(&earlier, entries + j * sizeof(earlier), sizeof(earlier));
+
+            if(earlier.job_id == entry.job_id){
+                err = JR_INVALID_SNAPSHOT;
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && header.count > 0){
+
+        // Like a table, the restored set is admitted as a whole. A snapshot holds no declared WCETs.
+        uint16_t extra_jobs = 0;
+
+        for(uint16_t i = 0; i < header.count; i++){
+
+            memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+
+            if( ! (entry.flags & JOB_RUNNER_SNAPSHOT_OFFLOAD) || runner->num_helpers == 0 ){
+                extra_jobs++;
+            }
+
+        }
+
+        err = __job_runner_admit(runner, extra_jobs, 0, 1);
+
+    }
+
+    if(err == JR_SUCCESS && header.count > 0){
+
+        jobs = calloc(header.count, sizeof(struct job_runner_job*));
+        if(jobs == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && header.count > 0){
+        err = __job_runner_hot_reserve(runner, __job_runner_count_jobs(runner) + header.count);
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < header.count; i++){
+
+        memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+
+        const struct job_runner_restore_entry* restore = __job_runner_restore_lookup(callbacks, num_callbacks, entry.job_id);
+        uint8_t flags = ((entry.flags & JOB_RUNNER_SNAPSHOT_CONTEXT) ? JOB_RUNNER_JOB_CONTEXT : 0) | ((entry.flags & JOB_RUNNER_SNAPSHOT_PIN_PHASE) ? JOB_RUNNER_JOB_PIN_PHASE : 0);
+
+        jobs[i] = __job_runner_alloc_job(restore->job_callback, entry.repeat_delay, flags, restore->context);
+        if(jobs[i] == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Appended in snapshot order so the restored jobs are visited in the order they were saved
+        struct job_runner_job** active_tail = &runner->jobs;
+        struct job_runner_job** paused_tail = &runner->paused;
+
+        while(*active_tail != NULL){
+            active_tail = &(*active_tail)->next;
+        }
+
+        while(*paused_tail != NULL){
+            paused_tail = &(*paused_tail)->next;
+        }
+
+        // Deadlines are relative in the snapshot, they are anchored when the runner starts like every other job
+        for(uint16_t i = 0; i < header.count; i++){
+
+            memcpy(&entry, entries + i * sizeof(entry), sizeof(entry));
+
+            jobs[i]->job_id = entry.job_id;
+            jobs[i]->next_run = entry.next_in;
+            jobs[i]->offload = (entry.flags & JOB_RUNNER_SNAPSHOT_OFFLOAD) ? 1 : 0;
+
+            if(entry.flags & JOB_RUNNER_SNAPSHOT_PAUSED){
+                *paused_tail = jobs[i];
+                paused_tail = &jobs[i]->next;
+            }
+            else {
+                *active_tail = jobs[i];
+                active_tail = &jobs[i]->next;
+            }
+
+            runner->job_bytes += __job_runner_job_bytes(jobs[i]);
+            __job_runner_record_add(runner, jobs[i]);
+
+        }
+
+        runner->hot_dirty = 1;
+        __job_runner_track_peak(runner);
+
+    }
+    else if(jobs != NULL){
+
+        for(uint16_t i = 0; i < header.count; i++){
+            SAFE_FREE(jobs[i]);
+        }
+
+    }
+
+    SAFE_FREE(jobs);
+
+    return err;
+
+}
+
+jrerr_t job_runner_snapshot_save_nvs(struct job_runner* runner, const char* nvs_namespace, const char* key){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_snapshot_request req = { .buffer = NULL, .size = 0, .used = 0 };
+    nvs_handle nvs = 0;
+
+    if(runner == NULL || nvs_namespace == NULL || key == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_snapshot_call, &req);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(nvs_open(nvs_namespace, NVS_READWRITE, &nvs) != ESP_OK){
+            err = JR_FAIL;
+        }
+        else {
+
+            if(nvs_set_blob(nvs, key, req.buffer, req.used) != ESP_OK || nvs_commit(nvs) != ESP_OK){
+                err = JR_FAIL;
+            }
+
+            nvs_close(nvs);
+
+        }
+
+    }
+
+    SAFE_FREE(req.buffer);
+
+    return err;
+
+}
+
+jrerr_t job_runner_snapshot_load_nvs(struct job_runner* runner, const char* nvs_namespace, const char* key, const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks){
+
+    jrerr_t err = JR_SUCCESS;
+
+    nvs_handle nvs = 0;
+    uint8_t* buffer = NULL;
+    size_t size = 0;
+
+    if(runner == NULL || nvs_namespace == NULL || key == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(nvs_open(nvs_namespace, NVS_READONLY, &nvs) != ESP_OK){
+            err = JR_FAIL;
+        }
+        else {
+
+            if(nvs_get_blob(nvs, key, NULL, &size) != ESP_OK){
+                err = JR_FAIL;
+            }
+
+            if(err == JR_SUCCESS){
+
+                buffer = malloc(size);
+                if(buffer == NULL){
+                    err = JR_MEMORY_ALLOC_FAIL;
+                }
+
+            }
+
+            if(err == JR_SUCCESS){
+
+                if(nvs_get_blob(nvs, key, buffer, &size) != ESP_OK){
+                    err = JR_FAIL;
+                }
+
+            }
+
+            nvs_close(nvs);
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_restore(runner, buffer, size, callbacks, num_callbacks);
+
+    }
+
+    SAFE_FREE(buffer);
+
+    return err;
+
+}
+
+jrerr_t job_runner_snapshot_save_file(struct job_runner* runner, const char* path){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_snapshot_request req = { .buffer = NULL, .size = 0, .used = 0 };
+    FILE* file = NULL;
+
+    if(runner == NULL || path == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_snapshot_call, &req);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        file = fopen(path, "wb");
+        if(file == NULL){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(fwrite(req.buffer, 1, req.used, file) != req.used){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(file != NULL){
+        fclose(file);
+    }
+
+    SAFE_FREE(req.buffer);
+
+    return err;
+
+}
+
+jrerr_t job_runner_snapshot_load_file(struct job_runner* runner, const char* path, const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks){
+
+    jrerr_t err = JR_SUCCESS;
+
+    FILE* file = NULL;
+    uint8_t* buffer = NULL;
+    long size = 0;
+
+    if(runner == NULL || path == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        file = fopen(path, "rb");
+        if(file == NULL){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) <= 0 || fseek(file, 0, SEEK_SET) != 0){
+            err = JR_INVALID_SNAPSHOT;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        buffer = malloc(size);
+        if(buffer == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(fread(buffer, 1, size, file) != (size_t) size){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(file != NULL){
+        fclose(file);
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_restore(runner, buffer, size, callbacks, num_callbacks);
+
+    }
+
+    SAFE_FREE(buffer);
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_adaptive_delay(struct job_runner* runner, uint32_t floor, uint32_t ceiling){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // A floor of 0 would never block once commands stop, keep at least one tick
+        runner->adaptive = 1;
+        runner->delay_floor = (floor > 0) ? floor : 1;
+        runner->delay_ceiling = (ceiling > runner->delay_floor) ? ceiling : runner->delay_floor;
+        runner->effective_delay = runner->delay_floor;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_loop_stats(struct job_runner* runner, struct job_runner_loop_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        stats->effective_delay = runner->effective_delay;
+        stats->wakeups = runner->wakeups;
+        stats->dispatched = runner->dispatched;
+        stats->commands = runner->commands;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_lane_stats(struct job_runner* runner, job_runner_lane_t lane, struct job_runner_lane_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(lane >= JOB_RUNNER_NUM_LANES){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        xQueueHandle* queue = (lane == JOB_RUNNER_LANE_CONTROL) ? runner->ctl_queue : runner->cmd_queue;
+        struct job_runner_lane* lane_stats = &runner->lanes[lane];
+
+        stats->depth = (queue != NULL) ? uxQueueMessagesWaiting(queue) : 0;
+        stats->size = (lane == JOB_RUNNER_LANE_CONTROL) ? JOB_RUNNER_CTL_QUEUE_LEN : JOB_RUNNER_CMD_QUEUE_LEN;
+        stats->peak_depth = lane_stats->peak_depth;
+        stats->commands = lane_stats->commands;
+        stats->mean_wait_us = (lane_stats->commands > 0) ? (uint32_t) (lane_stats->wait_us / lane_stats->commands) : 0;
+        stats->max_wait_us = lane_stats->max_wait_us;
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_set_boost_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    const struct job_runner_boost* boost = (const struct job_runner_boost*) arg;
+
+    // The base is only known once job_runner_execute started the task, before that it is checked there
+    if(boost != NULL && runner->task_hnd != NULL && boost->priority <= runner->base_priority){
+
+        ESP_LOGE("Job Runner","Boost priority %u is not above the base priority %u", boost->priority, runner->base_priority);
+        err = JR_FAIL;
+
+    }
+
+    if(err == JR_SUCCESS && runner->boosted){
+
+        // The current boost ends here, the new levels decide from the next loop on
+        runner->boosted = 0;
+        runner->boosted_ticks += __job_runner_now(runner) - runner->boost_since;
+
+        if(runner->task_hnd != NULL){
+            vTaskPrioritySet(runner->task_hnd, runner->base_priority);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->boost_enabled = (boost != NULL);
+
+        if(boost != NULL){
+            runner->boost = *boost;
+        }
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_priority_boost(struct job_runner* runner, const struct job_runner_boost* boost){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS && boost != NULL){
+
+        // Off levels above the on levels would leave the runner boosted for good
+        if(boost->priority >= configMAX_PRIORITIES || (boost->late_on == 0 && boost->queue_on == 0) ||
+            boost->late_off > boost->late_on || boost->queue_off > boost->queue_on){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_set_boost_call, (void*) boost);
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_boost_stats_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_boost_stats* stats = (struct job_runner_boost_stats*) arg;
+
+    stats->boosted = runner->boosted;
+    stats->boosts = runner->boosts;
+    stats->boosted_ticks = runner->boosted_ticks + (runner->boosted ? __job_runner_now(runner) - runner->boost_since : 0);
+    stats->backlog_late = runner->backlog_late;
+
+    return JR_SUCCESS;
+
+}
+
+jrerr_t job_runner_get_boost_stats(struct job_runner* runner, struct job_runner_boost_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Read on the runner task, boosted_ticks and boost_since always belong to the same boost
+        err = __job_runner_call(runner, &__job_runner_boost_stats_call, stats);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_mem_budget(struct job_runner* runner, uint32_t max_bytes){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Only notify reads the budget, it can change while the runner is live
+        runner->mem_budget = max_bytes;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_mem_stats(struct job_runner* runner, struct job_runner_mem_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        stats->job_bytes = runner->job_bytes;
+        stats->notif_bytes = __atomic_load_n(&runner->notif_bytes, __ATOMIC_SEQ_CST);
+        stats->peak_bytes = runner->peak_bytes;
+        stats->budget = runner->mem_budget;
+        stats->rejected = __atomic_load_n(&runner->mem_rejected, __ATOMIC_SEQ_CST);
+
+    }
+
+    return err;
+
+}
+
+struct job_runner_wcet_request {
+
+    int16_t job_id;
+    uint32_t value;
+    struct job_runner_sched_stats* stats;
+
+};
+
+static jrerr_t __job_runner_set_wcet_call(struct job_runner* runner, void* arg){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_wcet_request* req = (struct job_runner_wcet_request*) arg;
+    struct job_runner_job* job = NULL;
+    struct job_runner_job* previous = NULL;
+
+    err = __job_runner_find_job(runner, &job, req->job_id);
+    if(err == JR_JOB_NOT_EXIST){
+        err = __job_runner_find_paused_job(runner, &job, &previous, req->job_id);
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Checked with the new value in place, put back when refused
+        uint32_t old_wcet = job->wcet_us;
+
+        job->wcet_us = req->value;
+
+        err = __job_runner_admit(runner, 0, 0, 1);
+        if(err != JR_SUCCESS){
+            job->wcet_us = old_wcet;
+        }
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_calibrate_wcet_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_wcet_request* req = (struct job_runner_wcet_request*) arg;
+
+    for(struct job_runner_job* job = runner->jobs; job != NULL; job = job->next){
+        job->wcet_measured_us = 0;
+    }
+
+    for(struct job_runner_job* job = runner->paused; job != NULL; job = job->next){
+        job->wcet_measured_us = 0;
+    }
+
+    runner->wcet_window_end = __job_runner_now(runner) + req->value;
+    runner->wcet_calibrating = 1;
+
+    return JR_SUCCESS;
+
+}
+
+static jrerr_t __job_runner_sched_stats_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_wcet_request* req = (struct job_runner_wcet_request*) arg;
+
+    __job_runner_sched_stats(runner, 0, 0, req->stats);
+
+    return JR_SUCCESS;
+
+}
+
+jrerr_t job_runner_set_admission(struct job_runner* runner, job_runner_admission_t mode, job_runner_bound_t bound){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(mode > JOB_RUNNER_ADMIT_REJECT || bound > JOB_RUNNER_BOUND_EDF){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Only read on the runner task and by callers that add jobs before it starts
+        runner->admission = mode;
+        runner->bound = bound;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_job_wcet(struct job_runner* runner, int16_t job_id, uint32_t wcet_us){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_wcet_request req = { .job_id = job_id, .value = wcet_us, .stats = NULL };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_set_wcet_call, &req);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_calibrate_wcet(struct job_runner* runner, uint32_t ticks){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_wcet_request req = { .job_id = -1, .value = ticks, .stats = NULL };
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_calibrate_wcet_call, &req);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_get_sched_stats(struct job_runner* runner, struct job_runner_sched_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_wcet_request req = { .job_id = -1, .value = 0, .stats = stats };
+
+    if(runner == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_sched_stats_call, &req);
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_clock(struct job_runner* runner, const struct job_runner_clock* clock){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || clock == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(clock->now == NULL || clock->sleep == NULL){
+            err = JR_NULL_POINTER;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->clock = *clock;
+
+    }
+
+    return err;
+
+}
+
+static uint32_t __job_runner_virtual_now(void* ctx){
+
+    return ((struct job_runner_virtual_clock*) ctx)->now;
+
+}
+
+static void __job_runner_virtual_sleep(void* ctx, uint32_t ticks){
+
+    // Every loop costs at least a tick, otherwise a zero loop delay would stop time
+    ((struct job_runner_virtual_clock*) ctx)->now += (ticks > 0) ? ticks : 1;
+
+}
+
+jrerr_t job_runner_virtual_clock_init(struct job_runner_virtual_clock* vclock, struct job_runner_clock* clock, uint32_t start){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(vclock == NULL || clock == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        vclock->now = start;
+
+        clock->now = &__job_runner_virtual_now;
+        clock->sleep = &__job_runner_virtual_sleep;
+        clock->ctx = vclock;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_simulate(struct job_runner* runner, uint32_t ticks, int8_t* finished){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || finished == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // A runner either has its own task or is driven from here, never both
+        if(runner->task_hnd != NULL || runner->clock.now == NULL){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && ! runner->simulating){
+
+        runner->simulating = 1;
+        runner->started = 1;
+        err = __job_runner_begin(runner);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        TickType_t end = __job_runner_now(runner) + ticks;
+
+        *finished = 0;
+
+        while(err == JR_SUCCESS && (runner->jobs != NULL || runner->paused != NULL) && (int32_t) (__job_runner_now(runner) - end) < 0){
+
+            err = __job_runner_iterate(runner);
+
+        }
+
+        if(err != JR_SUCCESS || (runner->jobs == NULL && runner->paused == NULL)){
+
+            // Same ending as the runner task, the runner is gone after this
+            __job_runner_end(runner);
+            *finished = 1;
+
+        }
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_record_start_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_record_header* header = (struct job_runner_record_header*) arg;
+
+    runner->rec_next = 0;
+    runner->rec_dropped = 0;
+    runner->rec_capacity = header->count;
+    __atomic_store_n(&runner->rec_buffer, (uint8_t*) header, __ATOMIC_SEQ_CST);
+
+    header->count = 0;
+    header->start_tick = __job_runner_now(runner);
+
+    // Jobs registered before the recording started, a replay needs every job it will see
+    for(struct job_runner_job* job = runner->jobs; job != NULL; job = job->next){
+        __job_runner_record_add(runner, job);
+    }
+
+    for(struct job_runner_job* job = runner->paused; job != NULL; job = job->next){
+        __job_runner_record_add(runner, job);
+    }
+
+    return JR_SUCCESS;
+
+}
+
+jrerr_t job_runner_record_start(struct job_runner* runner, void* buffer, size_t size){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL || buffer == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->rec_buffer != NULL){
+            err = JR_ALREADY_STARTED;
+        }
+        else if(size < sizeof(struct job_runner_record_header) + sizeof(struct job_runner_record_entry)){
+            err = JR_BUFFER_TOO_SMALL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        struct job_runner_record_header header = {
+            .magic = JOB_RUNNER_RECORD_MAGIC,
+            .version = JOB_RUNNER_RECORD_VERSION,
+            .tick_rate_hz = configTICK_RATE_HZ,
+            .start_tick = 0,
+            .count = (size - sizeof(struct job_runner_record_header)) / sizeof(struct job_runner_record_entry)
+        };
+
+        // The capacity travels in count until the runner takes it over
+        memcpy(buffer, &header, sizeof(header));
+
+        err = __job_runner_call(runner, &__job_runner_record_start_call, buffer);
+
+    }
+
+    return err;
+
+}
+
+static jrerr_t __job_runner_record_stop_call(struct job_runner* runner, void* arg){
+
+    struct job_runner_record_header* header = (struct job_runner_record_header*) runner->rec_buffer;
+
+    if(header == NULL){
+        return JR_NOT_STARTED;
+    }
+
+    // Producers that already saw the buffer finish their entry first, nothing is written to it once we return and
+    // every counted entry is in it
+    __atomic_store_n(&runner->rec_buffer, NULL, __ATOMIC_SEQ_CST);
+
+    while(__atomic_load_n(&runner->rec_writers, __ATOMIC_SEQ_CST) > 0){
+        vTaskDelay(1);
+    }
+
+    uint32_t reserved = __atomic_load_n(&runner->rec_next, __ATOMIC_SEQ_CST);
+    header->count = (reserved < runner->rec_capacity) ? reserved : runner->rec_capacity;
+
+    *((uint32_t*) arg) = header->count;
+
+    return JR_SUCCESS;
+
+}
+
+jrerr_t job_runner_record_stop(struct job_runner* runner, size_t* used, uint32_t* dropped){
+
+    jrerr_t err = JR_SUCCESS;
+
+    uint32_t count = 0;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = __job_runner_call(runner, &__job_runner_record_stop_call, &count);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(used != NULL){
+            *used = sizeof(struct job_runner_record_header) + count * sizeof(struct job_runner_record_entry);
+        }
+
+        if(dropped != NULL){
+            *dropped = __atomic_load_n(&runner->rec_dropped, __ATOMIC_SEQ_CST);
+        }
+
+    }
+
+    return err;
+
+}
+
+static job_runner_state_t __job_runner_replay_job(job_runner_state_t state, void* data, void* context){
+
+    struct job_runner_replay_job* job = (struct job_runner_replay_job*) context;
+    struct job_runner_replay* replay = job->replay;
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    // Busy for as long as the recorded callback took on average
+    int64_t until = esp_timer_get_time() + job->mean_us;
+
+    while(esp_timer_get_time() < until){
+    }
+
+    return ((int32_t) (replay->vclock.now - job->remove_tick) >= 0) ? JOB_RUNNER_IM_DONE : JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static jrerr_t __job_runner_replay_notify(struct job_runner* runner, int16_t job_id, const struct job_runner_record_entry* entry){
+
+    jrerr_t err = JR_SUCCESS;
+
+    // Nobody else drains the queue while replaying, make room so the send cannot block
+    while(uxQueueSpacesAvailable(runner->cmd_queue) == 0 && err == JR_SUCCESS){
+        err = __job_runner_process_command(runner);
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(entry->flags & JOB_RUNNER_RECORD_INLINE){
+
+            uint8_t payload[JOB_RUNNER_INLINE_SIZE] = {0};
+            err = job_runner_notify_job_inline(runner, job_id, payload, (entry->arg < JOB_RUNNER_INLINE_SIZE) ? entry->arg : JOB_RUNNER_INLINE_SIZE);
+
+        }
+        else if(entry->arg > 0){
+
+            // Same size as the original so the allocator does the same work
+            void* payload = malloc(entry->arg);
+
+            if(payload == NULL){
+                err = JR_MEMORY_ALLOC_FAIL;
+            }
+            else {
+
+                err = job_runner_notify_job_sized(runner, job_id, payload, &free, entry->arg);
+                if(err != JR_SUCCESS){
+                    free(payload);
+                }
+
+            }
+
+        }
+        else {
+
+            err = job_runner_notify_job(runner, job_id, NULL, NULL);
+
+        }
+
+    }
+
+    // A rejected notification is part of the result, not a replay failure
+    if(err == JR_OVER_BUDGET || err == JR_RATE_LIMITED){
+        err = JR_SUCCESS;
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_replay(const void* recording, size_t size, uint32_t loop_delay, struct job_runner_replay_stats* stats){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_record_header header = {0};
+    const struct job_runner_record_entry* entries = NULL;
+    struct job_runner_replay replay = { .runner = NULL, .jobs = NULL, .first_id = 0 };
+    struct job_runner_clock clock;
+    struct job_runner_job_desc* table = NULL;
+    int16_t* live = NULL;
+    uint16_t num_jobs = 0;
+    int16_t max_id = -1;
+    int8_t finished = 0;
+
+    if(recording == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(size >= sizeof(header)){
+            memcpy(&header, recording, sizeof(header));
+        }
+
+        if(header.magic != JOB_RUNNER_RECORD_MAGIC || header.version != JOB_RUNNER_RECORD_VERSION
+            || size < sizeof(header) + (size_t) header.count * sizeof(struct job_runner_record_entry)){
+            err = JR_INVALID_RECORDING;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        memset(stats, 0, sizeof(struct job_runner_replay_stats));
+        entries = (const struct job_runner_record_entry*) ((const uint8_t*) recording + sizeof(header));
+
+        for(uint32_t i = 0; i < header.count; i++){
+
+            if(entries[i].job_id > max_id){
+                max_id = entries[i].job_id;
+            }
+
+            if(entries[i].type == JOB_RUNNER_RECORD_ADD){
+                num_jobs++;
+            }
+
+        }
+
+        replay.jobs = calloc(num_jobs + 1, sizeof(struct job_runner_replay_job));
+        table = calloc(num_jobs + 1, sizeof(struct job_runner_job_desc));
+        live = malloc((max_id + 2) * sizeof(int16_t));
+
+        if(replay.jobs == NULL || table == NULL || live == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // First pass, ids are reused once a job is gone so every entry maps to the job added last under its id
+        uint16_t added = 0;
+
+        for(int16_t id = 0; id <= max_id; id++){
+            live[id] = -1;
+        }
+
+        for(uint32_t i = 0; i < header.count; i++){
+
+            const struct job_runner_record_entry* entry = &entries[i];
+            uint32_t tick = entry->tick - header.start_tick;
+            int16_t index = (entry->job_id >= 0) ? live[entry->job_id] : -1;
+
+            if(entry->type == JOB_RUNNER_RECORD_ADD && entry->job_id >= 0){
+
+                replay.jobs[added] = (struct job_runner_replay_job) { .replay = &replay, .phase = tick + entry->arg2, .period = entry->arg, .remove_tick = JOB_RUNNER_FAR_FUTURE };
+                table[added] = (struct job_runner_job_desc) { .job_callback = (void*) __job_runner_replay_job, .repeat_delay = entry->arg, .phase = tick + entry->arg2,
+                    .priority = 0, .flags = JOB_RUNNER_JOB_CONTEXT, .context = &replay.jobs[added] };
+                live[entry->job_id] = added++;
+
+            }
+            else if(entry->type == JOB_RUNNER_RECORD_REMOVE && index >= 0){
+
+                replay.jobs[index].remove_tick = tick;
+                live[entry->job_id] = -1;
+
+            }
+            else if(entry->type == JOB_RUNNER_RECORD_RUN && index >= 0){
+
+                replay.jobs[index].busy_us += entry->arg;
+                replay.jobs[index].runs++;
+
+            }
+
+            stats->ticks = tick;
+
+        }
+
+        for(uint16_t i = 0; i < num_jobs; i++){
+            replay.jobs[i].mean_us = replay.jobs[i].runs ? replay.jobs[i].busy_us / replay.jobs[i].runs : 0;
+        }
+
+        stats->jobs = num_jobs;
+
+        job_runner_virtual_clock_init(&replay.vclock, &clock, 0);
+        err = job_runner_create(&replay.runner, loop_delay);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(replay.runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_jobs(replay.runner, table, num_jobs, &replay.first_id);
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    if(err == JR_SUCCESS){
+
+        uint16_t added = 0;
+
+        for(int16_t id = 0; id <= max_id; id++){
+            live[id] = -1;
+        }
+
+        // Second pass drives the runner, virtual time jumps from one notification to the next
+        for(uint32_t i = 0; err == JR_SUCCESS && ! finished && i < header.count; i++){
+
+            const struct job_runner_record_entry* entry = &entries[i];
+            uint32_t tick = entry->tick - header.start_tick;
+
+            if(entry->job_id < 0){
+                continue;
+            }
+
+            if(entry->type == JOB_RUNNER_RECORD_ADD){
+
+                live[entry->job_id] = added++;
+
+            }
+            else if(entry->type == JOB_RUNNER_RECORD_REMOVE){
+
+                live[entry->job_id] = -1;
+
+            }
+            else if(entry->type == JOB_RUNNER_RECORD_NOTIFY && live[entry->job_id] >= 0){
+
+                // Entries from different tasks can be slightly out of order, time never goes back
+                if((int32_t) (tick - replay.vclock.now) > 0){
+                    err = job_runner_simulate(replay.runner, tick - replay.vclock.now, &finished);
+                }
+
+                if(err == JR_SUCCESS && ! finished){
+
+                    err = __job_runner_replay_notify(replay.runner, replay.first_id + live[entry->job_id], entry);
+                    stats->notifications++;
+
+                }
+
+            }
+
+        }
+
+        if(err == JR_SUCCESS && ! finished && (int32_t) (stats->ticks - replay.vclock.now) > 0){
+            err = job_runner_simulate(replay.runner, stats->ticks - replay.vclock.now, &finished);
+        }
+
+    }
+
+    stats->wall_us = (uint32_t) (esp_timer_get_time() - start_us);
+
+    if(replay.runner != NULL && ! finished){
+
+        struct job_runner_loop_stats loop = {0};
+        struct job_runner_info info;
+        struct job_runner_job_info* jobs = malloc((num_jobs + 1) * sizeof(struct job_runner_job_info));
+        uint16_t filled = 0;
+
+        job_runner_get_loop_stats(replay.runner, &loop);
+        job_runner_get_latency(replay.runner, -1, &stats->latency);
+        stats->dispatched = loop.dispatched;
+
+        if(jobs != NULL && job_runner_inspect(replay.runner, &info, jobs, num_jobs, &filled) == JR_SUCCESS){
+
+            for(uint16_t i = 0; i < filled; i++){
+                if(jobs[i].max_late > stats->max_late){
+                    stats->max_late = jobs[i].max_late;
+                }
+            }
+
+        }
+
+        SAFE_FREE(jobs);
+
+        // Every replay job says done on shutdown, the runner frees itself once it runs out
+        job_runner_shutdown(replay.runner);
+
+        while( ! finished && job_runner_simulate(replay.runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    SAFE_FREE(table);
+    SAFE_FREE(replay.jobs);
+    SAFE_FREE(live);
+
+    return err;
+
+}
+
+jrerr_t job_runner_set_helpers(struct job_runner* runner, uint8_t num_helpers, uint32_t helper_stack, unsigned int priority){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if(runner == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(runner->started){
+            err = JR_ALREADY_STARTED;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && num_helpers > 0 && runner->offload_queue == NULL){
+
+        runner->offload_queue = xQueueCreate(JOB_RUNNER_OFFLOAD_QUEUE_LEN, sizeof(struct job_runner_job*));
+        if(runner->offload_queue == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && num_helpers > 0 && runner->helpers_exited == NULL){
+
+        runner->helpers_exited = xSemaphoreCreateCounting(UINT8_MAX, 0);
+        if(runner->helpers_exited == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->num_helpers = num_helpers;
+        runner->helper_stack = helper_stack;
+        runner->helper_priority = priority;
+
+    }
+
+    return err;
+
+}
+
+jrerr_t job_runner_create( struct job_runner** new_runner, uint32_t loop_delay ){
+    
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+
+    // Allocated once, shutting runners down later allocates nothing
+    err = __job_runner_prepare_done_groups();
+
+    if(err == JR_SUCCESS){
+
+        runner = malloc( sizeof(struct job_runner) );
+        if(runner == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        runner->task_hnd = NULL;
+        runner->jobs = NULL;
+        runner->paused = NULL;
+        runner->loop_delay = loop_delay;
+        runner->state = JOB_RUNNER_OK;
+        runner->started = 0;
+        runner->anchored = 0;
+        runner->simulating = 0;
+        runner->held = 0;
+        runner->stagger = 0;
+
+        runner->hot_next_run = NULL;
+        runner->hot_state = NULL;
+        runner->hot_jobs = NULL;
+        runner->hot_count = 0;
+        runner->hot_capacity = 0;
+        runner->hot_cursor = 0;
+        runner->hot_passes = 0;
+        runner->hot_dirty = 1;
+        runner->hot_short = 0;
+
+        runner->cmd_queue = xQueueCreate(JOB_RUNNER_CMD_QUEUE_LEN, sizeof(struct job_cmd));
+        runner->ctl_queue = xQueueCreate(JOB_RUNNER_CTL_QUEUE_LEN, sizeof(struct job_cmd));
+        memset(runner->lanes, 0, sizeof(runner->lanes));
+        runner->done_slot = -1;
+        runner->shutdown_pending = 0;
+        runner->clock = (struct job_runner_clock) { .now = NULL, .sleep = NULL, .ctx = NULL };
+
+        runner->stack_monitor = JOB_RUNNER_STACK_MONITOR_OFF;
+        runner->calibrating = 0;
+        runner->stack_size = 0;
+        runner->stack_min_free = UINT32_MAX;
+        runner->stack_deepest_job = -1;
+
+        runner->busy_us = 0;
+        runner->load_mark_us = 0;
+        runner->balancer = NULL;
+
+        runner->adaptive = 0;
+        runner->delay_floor = loop_delay;
+        runner->delay_ceiling = loop_delay;
+        runner->effective_delay = loop_delay;
+        runner->next_due = 0;
+        runner->pass_next_due = 0;
+        runner->dispatched = 0;
+        runner->commands = 0;
+        runner->wakeups = 0;
+
+        runner->boost_enabled = 0;
+        runner->boost = (struct job_runner_boost) { .priority = 0, .late_on = 0, .late_off = 0, .queue_on = 0, .queue_off = 0 };
+        runner->boosted = 0;
+        runner->base_priority = 0;
+        runner->backlog_late = 0;
+        runner->pass_late = 0;
+        runner->pass_ran = 0;
+        runner->boost_since = 0;
+        runner->boosts = 0;
+        runner->boosted_ticks = 0;
+
+        runner->notif_slots = NULL;
+        runner->num_notif_slots = 0;
+        runner->notif_lock = xSemaphoreCreateMutex();
+
+        runner->subs = NULL;
+        runner->num_subs = 0;
+        runner->subs_capacity = 0;
+
+        runner->timers = NULL;
+        runner->num_timers = 0;
+        runner->timers_capacity = 0;
+        runner->next_timer_handle = 0;
+
+        runner->job_bytes = 0;
+        runner->notif_bytes = 0;
+        runner->peak_bytes = 0;
+        runner->mem_budget = 0;
+        runner->mem_rejected = 0;
+        runner->notif_seq = 0;
+
+        memset(&runner->latency, 0, sizeof(runner->latency));
+
+        runner->admission = JOB_RUNNER_ADMIT_OFF;
+        runner->bound = JOB_RUNNER_BOUND_RM;
+        runner->wcet_calibrating = 0;
+        runner->wcet_window_end = 0;
+
+        runner->rec_buffer = NULL;
+        runner->rec_capacity = 0;
+        runner->rec_next = 0;
+        runner->rec_dropped = 0;
+        runner->rec_writers = 0;
+        runner->running_id = -1;
+        runner->deferred = 0;
+        runner->defer_parked = 0;
+        runner->defer_ticks = 0;
+
+        runner->num_helpers = 0;
+        runner->helpers_running = 0;
+        runner->helper_stack = 0;
+        runner->helper_priority = 0;
+        runner->offload_queue = NULL;
+        runner->helpers_exited = NULL;
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        *new_runner = runner;
+
+    }
+
+    if(err != JR_SUCCESS){
+
+        SAFE_FREE(runner);
+
+    }    
+
+    return err;
+
+}
+
+static struct job_runner_route* __job_runner_balancer_route(struct job_runner_balancer* balancer, int16_t job_id){
+
+    if(balancer == NULL){
+        return NULL;
+    }
+
+    for(uint16_t i = 0; i < balancer->num_routes; i++){
+
+        if(balancer->routes[i].job_id == job_id){
+            return &balancer->routes[i];
+        }
+
+    }
+
+    return NULL;
+
+}
+
+static void __job_runner_balance(struct job_runner_balancer* balancer){
+
+    uint32_t window_us = balancer->period * portTICK_PERIOD_MS * 1000;
+    int16_t busiest = -1;
+    int16_t idlest = -1;
+
+    // Runners leave the balancer under the lock when they run out of jobs, one still on it is not freed meanwhile
+    xSemaphoreTake(job_runner_balancer_lock, portMAX_DELAY);
+
+    for(uint8_t i = 0; i < balancer->num_runners; i++){
+
+        if(balancer->runners[i] == NULL){
+            continue;
+        }
+
+        uint32_t busy_us = balancer->runners[i]->busy_us;
+        uint32_t delta_us = busy_us - balancer->last_busy_us[i];
+        balancer->last_busy_us[i] = busy_us;
+
+        uint32_t utilization = (uint32_t) (((uint64_t) delta_us * 100) / window_us);
+        balancer->utilization[i] = (utilization > 100) ? 100 : utilization;
+
+        if(busiest < 0 || balancer->utilization[i] > balancer->utilization[busiest]){
+            busiest = i;
+        }
+
+        if(idlest < 0 || balancer->utilization[i] < balancer->utilization[idlest]){
+            idlest = i;
+        }
+
+    }
+
+    uint8_t imbalance = (busiest >= 0) ? balancer->utilization[busiest] - balancer->utilization[idlest] : 0;
+
+    if(imbalance > balancer->threshold){
+
+        // Moving half the gap evens the two runners out. A backed up runner is skipped this round, the balancer must
+        // not sit on the lock waiting for it.
+        struct job_cmd cmd = { .type = JR_CMD_TYPE_MIGRATE, .job_id = -1, .cmd_data = balancer->runners[idlest], .cmd_dtor = NULL, .cmd_arg = imbalance / 2,
+            .enqueued_us = __job_runner_now_us(balancer->runners[busiest]) };
+
+        if(__job_runner_send_lane_within(balancer->runners[busiest], &cmd, JOB_RUNNER_LANE_NORMAL, 0) != JR_SUCCESS){
+            ESP_LOGW("Job Runner","Balancer could not reach runner %d", (int) busiest);
+        }
+
+    }
+
+    xSemaphoreGive(job_runner_balancer_lock);
+
+}
+
+static void __job_runner_balancer_task( void* params ){
+
+    struct job_runner_balancer* balancer = (struct job_runner_balancer*) params;
+
+    while( ! balancer->stop ){
+
+        vTaskDelay(balancer->period);
+
+        if( ! balancer->stop ){
+            __job_runner_balance(balancer);
+        }
+
+    }
+
+    const int resp = JOB_RUNNER_SHUTDOWN_COMPLETE;
+    xQueueSend(balancer->done, &resp, portMAX_DELAY);
+
+    vTaskDelete(NULL);
+
+}
+
+// A runner that ran out of jobs takes itself off its balancer before it is freed
+static void __job_runner_balancer_forget(struct job_runner* runner){
+
+    if(job_runner_balancer_lock == NULL){
+        return;
+    }
+
+    xSemaphoreTake(job_runner_balancer_lock, portMAX_DELAY);
+
+    struct job_runner_balancer* balancer = runner->balancer;
+
+    for(uint8_t i = 0; balancer != NULL && i < balancer->num_runners; i++){
+
+        if(balancer->runners[i] == runner){
+            balancer->runners[i] = NULL;
+            balancer->utilization[i] = 0;
+        }
+
+    }
+
+    runner->balancer = NULL;
+
+    xSemaphoreGive(job_runner_balancer_lock);
+
+}
+
+static void __job_runner_free_balancer(struct job_runner_balancer* balancer){
+
+    if(balancer){
+
+        // Only the runners still on the balancer are alive to be told
+        if(job_runner_balancer_lock != NULL){
+
+            xSemaphoreTake(job_runner_balancer_lock, portMAX_DELAY);
+
+            for(uint8_t i = 0; i < balancer->num_runners; i++){
+                if(balancer->runners && balancer->runners[i]){
+                    balancer->runners[i]->balancer = NULL;
+                }
+            }
+
+            xSemaphoreGive(job_runner_balancer_lock);
+
+        }
+
+        SAFE_FREE(balancer->runners);
+        SAFE_FREE(balancer->last_busy_us);
+        SAFE_FREE(balancer->utilization);
+        SAFE_FREE(balancer->routes);
+
+        if(balancer->done){
+            vQueueDelete(balancer->done);
+        }
+
+    }
+
+    SAFE_FREE(balancer);
+
+}
+
+jrerr_t job_runner_balancer_create(struct job_runner_balancer** new_balancer, struct job_runner** runners, uint8_t num_runners, uint8_t threshold, uint32_t period){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_balancer* balancer = NULL;
+
+    if(new_balancer == NULL || runners == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        for(uint8_t i = 0; i < num_runners; i++){
+
+            if(runners[i] == NULL){
+                err = JR_NULL_POINTER;
+            }
+            else if(runners[i]->started || runners[i]->balancer != NULL){
+                err = JR_ALREADY_STARTED;
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && job_runner_balancer_lock == NULL){
+
+        job_runner_balancer_lock = xSemaphoreCreateMutex();
+        if(job_runner_balancer_lock == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        balancer = calloc(1, sizeof(struct job_runner_balancer));
+        if(balancer == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        balancer->runners = calloc(num_runners, sizeof(struct job_runner*));
+        balancer->last_busy_us = calloc(num_runners, sizeof(uint32_t));
+        balancer->utilization = calloc(num_runners, sizeof(uint8_t));
+        balancer->done = xQueueCreate(1, sizeof(int));
+
+        if(balancer->runners == NULL || balancer->last_busy_us == NULL || balancer->utilization == NULL || balancer->done == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        balancer->num_runners = num_runners;
+        balancer->threshold = threshold;
+        balancer->period = (period > 0) ? period : 1;
+
+        for(uint8_t i = 0; i < num_runners; i++){
+            balancer->runners[i] = runners[i];
+            runners[i]->balancer = balancer;
+        }
+
+        *new_balancer = balancer;
+
+    }
+
+    if(err != JR_SUCCESS){
+
+        __job_runner_free_balancer(balancer);
 
-    if(runner->cmd_queue == NULL){
-        return JR_NULL_POINTER;
     }
 
+    return err;
+
+}
+
+jrerr_t job_runner_balancer_add_job(struct job_runner_balancer* balancer, void* job_callback, uint32_t repeat_delay, int16_t* job_id){
+
     jrerr_t err = JR_SUCCESS;
 
-    struct job_cmd cmd = {0};
-    BaseType_t rcvd = xQueueReceive(runner->cmd_queue, &cmd, 1);
+    struct job_runner* runner = NULL;
+    struct job_runner_route* routes = NULL;
+    int16_t id = 0;
 
-    if(rcvd == pdTRUE){
-        // Process New Command
-        switch(cmd.type){
+    if(balancer == NULL || job_callback == NULL){
+        err = JR_NULL_POINTER;
+    }
 
-            case JR_CMD_TYPE_SHUTDOWN:
+    if(err == JR_SUCCESS){
 
-                runner->state = JOB_RUNNER_SHUT_DOWN;
-                
-                if(cmd.cmd_data != NULL){
-                    // A special case where the caller can provide a queue to be notified on when the shutdown is complete
-                    runner->shutdown_resp_channel = cmd.cmd_data;
-                    cmd.cmd_data = NULL;
-                }
+        if(balancer->started){
+            err = JR_ALREADY_STARTED;
+        }
 
-                break;
-            
-            case JR_CMD_TYPE_NOTIFY:
+    }
 
-                err = __job_runner_process_notification(runner, &cmd);
-                if(err == JR_JOB_NOT_EXIST){
-                    ESP_LOGE("Job Runner","Job Not Exist");
+    if(err == JR_SUCCESS){
 
-                    // Return Success so job runner does not get shut down. 
-                    err = JR_SUCCESS;
-                }
+        // Initial placement is by job count, the balancer corrects it once loads are measured
+        uint16_t fewest = UINT16_MAX;
 
-                break;
+        for(uint8_t i = 0; i < balancer->num_runners; i++){
 
-            default:
-                err = JR_INVALID_CMD;
-                break;
-        }
+            uint16_t count = 0;
+            struct job_runner_job* start = balancer->runners[i]->jobs;
 
-        if(cmd.cmd_data != NULL){
-            if(cmd.cmd_dtor != NULL){
-                cmd.cmd_dtor(cmd.cmd_data);
+            while( start != NULL ){
+                count++;
+                start = start->next;
             }
-            else {
-                err = JR_INVALID_DESTRUCTOR;
+
+            if(count < fewest){
+                fewest = count;
+                runner = balancer->runners[i];
             }
+
+        }
+
+        if(runner == NULL){
+            err = JR_NULL_POINTER;
         }
 
     }
 
-    return err;
-}
+    if(err == JR_SUCCESS){
 
-static void __job_runner_task( void* params ) {
+        routes = realloc(balancer->routes, (balancer->num_routes + 1) * sizeof(struct job_runner_route));
+        if(routes == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+        else {
+            balancer->routes = routes;
+        }
 
-    struct job_runner* runner = (struct job_runner*) params;
-    if(runner == NULL){
-        ESP_LOGE("__job_runner_task","Runner NULL, Abrting!!!");
-        vTaskDelete(NULL);
     }
 
-    jrerr_t err = JR_SUCCESS;
-
-    struct job_runner_job* previous = NULL;
-    struct job_runner_job* current = runner->jobs;
+    if(err == JR_SUCCESS){
 
-    while(runner->jobs != NULL){
+        // Ids are claimed across every runner so they stay unique when jobs move between runners
+        err = __job_runner_claim_ids(balancer->runners, balancer->num_runners, 1, &id);
 
-        err = __job_runner_process_current(runner, &current, &previous);
-        if(err != JR_SUCCESS){
-            ESP_LOGE("__job_runner_task","Error Processing Current, killing runner!!!");
-            break;
-        }
+    }
 
-        err = __job_runner_process_command(runner);
-        if(err != JR_SUCCESS){
-            ESP_LOGE("__job_runner_task","Error Processing Command, killing runner!!!");
-            break;
-        }
+    if(err == JR_SUCCESS){
 
-        vTaskDelay(runner->loop_delay);
+        err = __job_runner_add_job(runner, job_callback, repeat_delay, 0, 0, NULL, id, job_id);
 
     }
 
-    ESP_LOGI("__job_runner_task","No More Jobs, Shutting Down Runner!!!");
+    if(err == JR_SUCCESS){
 
-    if(runner->shutdown_resp_channel != NULL){
+        balancer->routes[balancer->num_routes].job_id = id;
+        balancer->routes[balancer->num_routes].owner = runner;
+        balancer->num_routes++;
 
-        const int resp = JOB_RUNNER_SHUTDOWN_COMPLETE;
-        xQueueSend(runner->shutdown_resp_channel, &resp, portMAX_DELAY);
-    
     }
 
-    __job_runner_free_runner(runner);
-
-    vTaskDelete(NULL);
+    return err;
 
 }
 
-jrerr_t job_runner_notify_job(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd) ){
+jrerr_t job_runner_balancer_notify_job(struct job_runner_balancer* balancer, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd)){
 
     jrerr_t err = JR_SUCCESS;
 
-    if(runner == NULL){
+    struct job_runner_route* route = NULL;
 
+    if(balancer == NULL){
         err = JR_NULL_POINTER;
-
     }
 
     if(err == JR_SUCCESS){
 
-        if(runner->cmd_queue == NULL){
-            err = JR_NULL_POINTER;
+        route = __job_runner_balancer_route(balancer, job_id);
+        if(route == NULL){
+            err = JR_JOB_NOT_EXIST;
         }
 
     }
 
     if(err == JR_SUCCESS){
 
-        struct job_cmd cmd = { .type = JR_CMD_TYPE_NOTIFY, .job_id = job_id, .cmd_data = notif_data, .cmd_dtor = notif_dtor };
-        BaseType_t sderr = xQueueSend(runner->cmd_queue, &cmd, portMAX_DELAY);
-        if(sderr != pdTRUE){
-            err = JR_QUEUE_FULL;
-        }
-    
+        err = job_runner_notify_job(route->owner, job_id, notif_data, notif_dtor);
+
     }
 
     return err;
 
 }
 
-jrerr_t job_runner_add_job(struct job_runner* runner, void* job_callback, uint32_t repeat_delay, int16_t* job_id) {
+jrerr_t job_runner_balancer_execute(struct job_runner_balancer* balancer, const char* runner_name, uint32_t runner_stack, unsigned int priority){
 
     jrerr_t err = JR_SUCCESS;
 
-    struct job_runner_job* new_job = NULL;
-
-    if( runner == NULL || job_callback == NULL ){
+    if(balancer == NULL || runner_name == NULL){
         err = JR_NULL_POINTER;
     }
 
-    if( err == JR_SUCCESS ){
+    if(err == JR_SUCCESS){
 
-        if(runner->started){
+        if(balancer->started){
             err = JR_ALREADY_STARTED;
         }
 
     }
 
-    if(err == JR_SUCCESS){
+    uint8_t started = 0;
 
-        new_job = malloc( sizeof(struct job_runner_job) );
-        if(new_job == NULL){
-            err = JR_MEMORY_ALLOC_FAIL;
+    // Every runner comes up held, none runs a job until all of them and the balancer task exist
+    for(uint8_t i = 0; err == JR_SUCCESS && i < balancer->num_runners; i++){
+
+        // Spread the runners over the cores, the balancer then moves work between them
+        err = __job_runner_start(balancer->runners[i], runner_name, runner_stack, priority, i % portNUM_PROCESSORS, 1);
+        if(err == JR_SUCCESS){
+            started++;
         }
 
     }
 
     if(err == JR_SUCCESS){
 
-        new_job->job_callback = job_callback;
-        new_job->last_run = 0;
-        new_job->repeat_delay = repeat_delay;
-        new_job->notif = 0;
-        new_job->notif_data = NULL;
-        new_job->notif_dtor = NULL;
+        balancer->started = 1;
 
-        err = __job_runner_assign_job_id(runner, new_job);
+        BaseType_t crerr = xTaskCreate(&__job_runner_balancer_task, "jr_balancer", 2048, balancer, priority, &balancer->task_hnd);
+        if(crerr != pdPASS){
+            balancer->started = 0;
+            err = JR_FAIL;
+        }
 
     }
 
     if(err == JR_SUCCESS){
 
-        if(job_id != NULL){
-            *job_id = new_job->job_id;
+        for(uint8_t i = 0; i < balancer->num_runners; i++){
+            xTaskNotifyGive(balancer->runners[i]->task_hnd);
         }
 
-        new_job->next = runner->jobs;
-        runner->jobs = new_job;
-
     }
+    else {
 
-    if(err != JR_SUCCESS){
+        // All or nothing, the runners already up go back to where they were
+        ESP_LOGE("Job Runner","Balancer failed to start, stopping the %u runners it started", (unsigned int) started);
 
-        SAFE_FREE(new_job);
+        for(uint8_t i = 0; i < started; i++){
+            __job_runner_unstart(balancer->runners[i]);
+        }
 
     }
 
@@ -498,33 +7549,25 @@ jrerr_t job_runner_add_job(struct job_runner* runner, void* job_callback, uint32
 
 }
 
-jrerr_t job_runner_execute(struct job_runner* runner, const char* runner_name, uint32_t runner_stack, unsigned int priority){
+jrerr_t job_runner_balancer_get_utilization(struct job_runner_balancer* balancer, uint8_t runner_index, uint8_t* utilization){
 
     jrerr_t err = JR_SUCCESS;
 
-    if(runner == NULL || runner_name == NULL){
-
+    if(balancer == NULL || utilization == NULL){
         err = JR_NULL_POINTER;
-
     }
 
     if(err == JR_SUCCESS){
 
-        if(runner->started){
-            err = JR_ALREADY_STARTED;
+        if(runner_index >= balancer->num_runners){
+            err = JR_FAIL;
         }
 
     }
 
     if(err == JR_SUCCESS){
 
-        runner->started = 1;
-
-        BaseType_t crerr = xTaskCreate(&__job_runner_task, runner_name, runner_stack, runner, priority, &runner->task_hnd);
-        if(crerr != pdPASS){
-            runner->started = 0;
-            err = JR_FAIL;
-        }
+        *utilization = balancer->utilization[runner_index];
 
     }
 
@@ -532,43 +7575,26 @@ jrerr_t job_runner_execute(struct job_runner* runner, const char* runner_name, u
 
 }
 
-jrerr_t job_runner_shutdown(struct job_runner* runner){
+jrerr_t job_runner_balancer_destroy(struct job_runner_balancer* balancer){
 
     jrerr_t err = JR_SUCCESS;
 
-    if(runner == NULL){
+    if(balancer == NULL){
         err = JR_NULL_POINTER;
     }
 
     if(err == JR_SUCCESS){
 
-        if( ! runner->started ){
-            err = JR_NOT_STARTED;
-        }
-    
-    }
-
-    if(err == JR_SUCCESS){
-
-        if(runner->cmd_queue == NULL){
-            err = JR_NULL_POINTER;
-        }
+        if(balancer->started){
 
-    }
+            int resp = 0;
 
-    if(err == JR_SUCCESS){
+            balancer->stop = 1;
+            xQueueReceive(balancer->done, &resp, portMAX_DELAY);
 
-        struct job_cmd cmd = { .type = JR_CMD_TYPE_SHUTDOWN, .cmd_data = NULL, .cmd_dtor = NULL };
-        BaseType_t sderr = xQueueSend(runner->cmd_queue, &cmd, portMAX_DELAY);
-        if(sderr != pdTRUE){
-            err = JR_QUEUE_FULL;
         }
-    
-    }
-
-    if( err == JR_SUCCESS ){
 
-        runner->started = 0;
+        __job_runner_free_balancer(balancer);
 
     }
 
@@ -576,58 +7602,58 @@ jrerr_t job_runner_shutdown(struct job_runner* runner){
 
 }
 
-jrerr_t job_runner_shutdown_async(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel){
+jrerr_t job_runner_stream_create(struct job_runner_stream** new_stream, uint16_t slot_size, uint16_t num_slots){
 
     jrerr_t err = JR_SUCCESS;
-    xQueueHandle* sd_resp_hnd = NULL;
 
-    if(runner == NULL){
+    struct job_runner_stream* stream = NULL;
+
+    if(new_stream == NULL){
         err = JR_NULL_POINTER;
     }
 
     if(err == JR_SUCCESS){
 
-        if( ! runner->started ){
-            err = JR_NOT_STARTED;
+        // The mask needs a power of two
+        if(slot_size == 0 || num_slots == 0 || (num_slots & (num_slots - 1)) != 0){
+            err = JR_FAIL;
         }
-    
+
     }
 
     if(err == JR_SUCCESS){
 
-        if(runner->cmd_queue == NULL){
-            err = JR_NULL_POINTER;
+        stream = calloc(1, sizeof(struct job_runner_stream));
+        if(stream == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
         }
 
     }
 
     if(err == JR_SUCCESS){
 
-        sd_resp_hnd = xQueueCreate(1, sizeof(int));
-        if(sd_resp_hnd == NULL){
-            err = JR_NULL_POINTER;
+        // Slots stay 8 byte aligned so a reserved slot can hold any struct
+        stream->slot_size = (slot_size + 7) & ~7;
+        stream->mask = num_slots - 1;
+        stream->slots = malloc(stream->slot_size * num_slots);
+        stream->lengths = malloc(num_slots * sizeof(uint16_t));
+
+        if(stream->slots == NULL || stream->lengths == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
         }
 
     }
 
     if(err == JR_SUCCESS){
 
-        struct job_cmd cmd = { .type = JR_CMD_TYPE_SHUTDOWN, .cmd_data = sd_resp_hnd, .cmd_dtor = NULL };
-        BaseType_t sderr = xQueueSend(runner->cmd_queue, &cmd, portMAX_DELAY);
-        if(sderr != pdTRUE){
-            err = JR_QUEUE_FULL;
-        }
-    
+        *new_stream = stream;
+
     }
+    else if(stream != NULL){
 
-    if(err != JR_SUCCESS){
-        if(sd_resp_hnd){
-            vQueueDelete(sd_resp_hnd);
-        }
-    } 
-    else {
-        *shutdown_resp_channel = sd_resp_hnd;
-        runner->started = 0;
+        SAFE_FREE(stream->slots);
+        SAFE_FREE(stream->lengths);
+        free(stream);
 
     }
 
@@ -635,104 +7661,177 @@ jrerr_t job_runner_shutdown_async(struct job_runner* runner, job_runner_shutdown
 
 }
 
-jrerr_t job_runner_await_shutdown(job_runner_shutdown_response_handle_t shutdown_resp_channel, uint32_t ticks_to_wait){
+jrerr_t job_runner_stream_bind_consumer(struct job_runner_stream* stream, uint32_t notify_bits){
 
     jrerr_t err = JR_SUCCESS;
 
-    int resp = 0;
+    if(stream == NULL){
+        err = JR_NULL_POINTER;
+    }
+
+    if(err == JR_SUCCESS){
+
+        stream->notify_bits = notify_bits;
+        __atomic_store_n(&stream->consumer, xTaskGetCurrentTaskHandle(), __ATOMIC_SEQ_CST);
+
+    }
+
+    return err;
+
+}
+
+void* job_runner_stream_reserve(struct job_runner_stream* stream){
+
+    if(stream == NULL){
+        return NULL;
+    }
+
+    uint32_t head = stream->head;
+
+    if(head - __atomic_load_n(&stream->tail, __ATOMIC_SEQ_CST) > stream->mask){
+
+        stream->stats.dropped++;
+        return NULL;
+
+    }
+
+    return stream->slots + (head & stream->mask) * stream->slot_size;
+
+}
+
+jrerr_t job_runner_stream_commit(struct job_runner_stream* stream, uint16_t len){
+
+    jrerr_t err = JR_SUCCESS;
 
-    if(shutdown_resp_channel == NULL){
+    if(stream == NULL){
         err = JR_NULL_POINTER;
     }
 
     if(err == JR_SUCCESS){
 
-        BaseType_t resp_err = xQueueReceive(shutdown_resp_channel, &resp, ticks_to_wait);
-        if(resp_err != pdPASS){
-            err = JR_TIMEOUT;
+        if(len > stream->slot_size){
+            err = JR_BUFFER_TOO_SMALL;
+        }
+        else if(stream->head - __atomic_load_n(&stream->tail, __ATOMIC_SEQ_CST) > stream->mask){
+
+            // Nothing was reserved, publishing would hand the consumer's oldest slot over a second time
+            stream->stats.dropped++;
+            err = JR_QUEUE_FULL;
+
         }
 
     }
 
     if(err == JR_SUCCESS){
 
-        if(resp != JOB_RUNNER_SHUTDOWN_COMPLETE){
-            err = JR_INVALID_SHUTDOWN_CODE;
+        uint32_t head = stream->head;
+
+        stream->lengths[head & stream->mask] = len;
+        __atomic_store_n(&stream->head, head + 1, __ATOMIC_SEQ_CST);
+
+        // Read after publishing, either this sees the consumer caught up or the consumer sees the new slot
+        uint32_t depth = head + 1 - __atomic_load_n(&stream->tail, __ATOMIC_SEQ_CST);
+
+        stream->stats.committed++;
+        if(depth > stream->stats.high_water){
+            stream->stats.high_water = depth;
+        }
+
+        TaskHandle_t consumer = __atomic_load_n(&stream->consumer, __ATOMIC_SEQ_CST);
+
+        if(depth == 1 && consumer != NULL){
+
+            stream->stats.wakeups++;
+            xTaskNotify(consumer, stream->notify_bits, eSetBits);
+
         }
-    }
 
-    if(shutdown_resp_channel != NULL){
-        vQueueDelete(shutdown_resp_channel);
     }
 
     return err;
 
 }
 
-jrerr_t job_runner_get_shutdown_response_handle(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel){
+const void* job_runner_stream_peek(struct job_runner_stream* stream, uint16_t* len){
+
+    if(stream == NULL){
+        return NULL;
+    }
+
+    uint32_t tail = stream->tail;
+
+    if(__atomic_load_n(&stream->head, __ATOMIC_SEQ_CST) == tail){
+        return NULL;
+    }
+
+    if(len != NULL){
+        *len = stream->lengths[tail & stream->mask];
+    }
+
+    return stream->slots + (tail & stream->mask) * stream->slot_size;
+
+}
+
+jrerr_t job_runner_stream_release(struct job_runner_stream* stream){
 
     jrerr_t err = JR_SUCCESS;
-    xQueueHandle* sd_resp_hnd = NULL;
 
-    if(runner == NULL){
+    if(stream == NULL){
         err = JR_NULL_POINTER;
     }
 
     if(err == JR_SUCCESS){
 
-        sd_resp_hnd = xQueueCreate(1, sizeof(int));
-        if(sd_resp_hnd == NULL){
-            err = JR_NULL_POINTER;
+        if(__atomic_load_n(&stream->head, __ATOMIC_SEQ_CST) == stream->tail){
+            err = JR_FAIL;
         }
 
-    } 
+    }
 
     if(err == JR_SUCCESS){
 
-        runner->shutdown_resp_channel = sd_resp_hnd;
-        *shutdown_resp_channel = sd_resp_hnd;
-        
+        __atomic_store_n(&stream->tail, stream->tail + 1, __ATOMIC_SEQ_CST);
+
     }
 
     return err;
 
 }
 
-jrerr_t job_runner_create( struct job_runner** new_runner, uint32_t loop_delay ){
-    
-    jrerr_t err = JR_SUCCESS;
+jrerr_t job_runner_stream_get_stats(struct job_runner_stream* stream, struct job_runner_stream_stats* stats){
 
-    struct job_runner* runner = NULL;
+    jrerr_t err = JR_SUCCESS;
 
-    runner = malloc( sizeof(struct job_runner) );
-    if(runner == NULL){
-        err = JR_MEMORY_ALLOC_FAIL;
+    if(stream == NULL || stats == NULL){
+        err = JR_NULL_POINTER;
     }
 
     if(err == JR_SUCCESS){
 
-        runner->task_hnd = NULL;
-        runner->jobs = NULL;
-        runner->loop_delay = loop_delay;
-        runner->state = JOB_RUNNER_OK;
-        runner->started = 0;
-
-        runner->cmd_queue = xQueueCreate(5, sizeof(struct job_cmd));
-        runner->shutdown_resp_channel = NULL;
+        // Written by the producer only, a copy taken meanwhile may be one sample behind
+        *stats = stream->stats;
 
     }
 
-    if(err == JR_SUCCESS){
+    return err;
 
-        *new_runner = runner;
+}
+
+jrerr_t job_runner_stream_destroy(struct job_runner_stream* stream){
 
+    jrerr_t err = JR_SUCCESS;
+
+    if(stream == NULL){
+        err = JR_NULL_POINTER;
     }
 
-    if(err != JR_SUCCESS){
+    if(err == JR_SUCCESS){
 
-        SAFE_FREE(runner);
+        SAFE_FREE(stream->slots);
+        SAFE_FREE(stream->lengths);
+        free(stream);
 
-    }    
+    }
 
     return err;
 
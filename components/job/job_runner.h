@@ -28,11 +28,38 @@
 
 #include "stdint.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 
 #define JOB_RUNNER_SHUTDOWN_COMPLETE 1
 
+#define JOB_RUNNER_NO_AFFINITY -1
+
+// Extra bytes added on top of the measured stack usage when recommending a stack size
+#ifndef JOB_RUNNER_STACK_MARGIN
+#define JOB_RUNNER_STACK_MARGIN 512
+#endif
+
+#include "stddef.h"
+#include "stdio.h"
+
+// Largest payload job_runner_notify_job_inline copies into the command queue, every job and queue item carries this much
+#ifndef JOB_RUNNER_INLINE_SIZE
+#define JOB_RUNNER_INLINE_SIZE 16
+#endif
+
 typedef enum {
 
+    JR_NOT_SUBSCRIBED          =  -19,
+    JR_NOT_PENDING             =  -18,
+    JR_UNSCHEDULABLE           =  -17,
+    JR_INVALID_RECORDING       =  -16,
+    JR_OVER_BUDGET             =  -15,
+    JR_INVALID_SNAPSHOT        =  -14,
+    JR_BUFFER_TOO_SMALL        =  -13,
+    JR_RATE_LIMITED            =  -12,
     JR_JOB_NOT_EXIST           =  -11,
     JR_NOT_STARTED             =  -10,
     JR_ALREADY_STARTED         =   -9,
@@ -57,24 +84,546 @@ typedef enum {
 
 } job_runner_state_t;
 
+typedef enum {
+
+    JOB_RUNNER_STACK_MONITOR_OFF,
+    JOB_RUNNER_STACK_MONITOR_ON,
+    JOB_RUNNER_STACK_MONITOR_CALIBRATE,
+
+} job_runner_stack_monitor_t;
+
+struct job_runner_stack_stats {
+
+    uint32_t stack_size;            // Stack given to job_runner_execute, in bytes
+    uint32_t min_free;              // Lowest free stack seen after a callback, in bytes
+    int16_t deepest_job_id;         // Job that pushed the watermark to min_free, -1 if none
+    uint32_t recommended_stack;     // Measured usage plus JOB_RUNNER_STACK_MARGIN, 0 if nothing measured yet
+
+};
+
+typedef enum {
+
+    JOB_RUNNER_COALESCE_NONE,       // Every notification is queued and delivered
+    JOB_RUNNER_COALESCE_LATEST,     // A pending payload is replaced by the newest one, the old one is destroyed
+    JOB_RUNNER_COALESCE_MERGE,      // A pending payload is combined with the newest one by the merge function
+
+} job_runner_coalesce_t;
+
+struct job_runner_notif_stats {
+
+    uint32_t coalesced;             // Payloads replaced by a newer one before the job ran
+    uint32_t merged;                // Payloads folded into the pending one by the merge function
+    uint32_t dropped;               // Notifications refused with JR_RATE_LIMITED
+
+};
+
+// Descriptor flags
+#define JOB_RUNNER_JOB_PAUSED 0x01      // Registered paused, start it with job_runner_resume_job
+#define JOB_RUNNER_JOB_OFFLOAD 0x02     // Runs on a helper task, see job_runner_set_helpers
+#define JOB_RUNNER_JOB_PIN_PHASE 0x04   // Keeps phase when the runner staggers phases
+#define JOB_RUNNER_JOB_CONTEXT 0x08     // job_callback is a job_runner_context_callback_t and gets context
+
+// Callback of a job registered with a context pointer, job_callback of every other job is called without it
+typedef job_runner_state_t (*job_runner_context_callback_t)(job_runner_state_t state, void* data, void* context);
+
+struct job_runner_job_desc {
+
+    void* job_callback;
+    uint32_t repeat_delay;
+    uint32_t phase;                 // Ticks after the runner starts until the first run
+    uint8_t priority;               // Higher priority jobs are visited first in every pass
+    uint8_t flags;
+    uint32_t wcet_us;               // Worst case callback time for admission control, 0 to use the measured one
+    void* context;                  // Passed to the callback of a JOB_RUNNER_JOB_CONTEXT job
+
+};
+
+struct job_runner_restore_entry {
+
+    int16_t job_id;
+    void* job_callback;
+    void* context;                  // Passed again to a job that was saved as a JOB_RUNNER_JOB_CONTEXT job
+
+};
+
+struct job_runner_loop_stats {
+
+    uint32_t effective_delay;       // Ticks the runner currently sleeps between loops
+    uint32_t wakeups;               // Loop iterations since the runner started
+    uint32_t dispatched;            // Callbacks run
+    uint32_t commands;              // Commands taken off the queue
+
+};
+
+struct job_runner_boost {
+
+    unsigned int priority;          // Runner task priority while boosted, above the one it was started with
+    uint32_t late_on;               // Boost once a job runs this many ticks late, 0 ignores lateness
+    uint32_t late_off;              // Back to the base priority once lateness is down to late_off and the queue to queue_off
+    uint16_t queue_on;              // Boost once this many commands wait in the queues, both lanes counted, 0 ignores them
+    uint16_t queue_off;
+
+};
+
+struct job_runner_boost_stats {
+
+    int8_t boosted;
+    uint32_t boosts;                // Times the priority was raised
+    uint32_t boosted_ticks;         // Time spent raised, the current boost included
+    uint32_t backlog_late;          // Worst lateness over the last pass that ran jobs, raised right away, lowered when a pass ends
+
+};
+
+struct job_runner_mem_stats {
+
+    uint32_t job_bytes;             // Job structs held by the runner
+    uint32_t notif_bytes;           // Declared payload bytes queued or waiting for their job
+    uint32_t peak_bytes;            // Highest job_bytes + notif_bytes seen
+    uint32_t budget;                // 0 when unlimited
+    uint32_t rejected;              // Notifications refused with JR_OVER_BUDGET
+
+};
+
+// Latency histograms, bucket i counts samples of [2^i, 2^(i+1)) us, bucket 0 starts at 0 and the last one is open ended
+#define JOB_RUNNER_LATENCY_BUCKETS 20
+
+struct job_runner_latency_hist {
+
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t total_us;
+    uint32_t buckets[JOB_RUNNER_LATENCY_BUCKETS];
+
+};
+
+struct job_runner_latency_stats {
+
+    struct job_runner_latency_hist queue;       // Notify call until the runner took the command off the queue
+    struct job_runner_latency_hist dispatch;    // Off the queue until the callback was entered (or handed to a helper)
+    struct job_runner_latency_hist total;       // Notify call until the callback was entered
+
+};
+
+// Introspection flags
+#define JOB_RUNNER_INFO_PAUSED 0x01
+#define JOB_RUNNER_INFO_OFFLOAD 0x02
+#define JOB_RUNNER_INFO_IN_FLIGHT 0x04     // Running on a helper right now
+#define JOB_RUNNER_INFO_NOTIFIED 0x08      // A notification is waiting for the next run
+
+struct job_runner_info {
+
+    job_runner_state_t state;
+    int8_t started;
+    uint16_t num_jobs;
+    uint16_t num_paused;
+    uint16_t pending_notifs;
+    uint16_t pending_timers;        // Delayed notifications not due yet
+    uint16_t queue_used;            // Commands waiting in the queue
+    uint16_t queue_size;
+    uint32_t window_us;             // Time busy_us was collected over, cpu share is busy_us / window_us
+    uint32_t busy_us;
+    uint32_t dispatched;
+    uint32_t wakeups;
+    uint32_t effective_delay;
+    uint32_t job_bytes;
+    uint32_t notif_bytes;
+    uint32_t utilization;           // WCET load in 1/1000, see job_runner_get_sched_stats
+    int32_t headroom;
+
+};
+
+struct job_runner_job_info {
+
+    int16_t job_id;
+    uint8_t flags;
+    uint16_t topics;
+    uint32_t repeat_delay;
+    int32_t next_in;                // Ticks to the next deadline, negative when overdue, 0 while paused
+    uint32_t max_late;              // Worst lateness of a periodic run, in ticks
+    uint32_t busy_us;               // Callback time over the runner's window_us
+    uint32_t wcet_us;               // Declared WCET, or the longest callback measured when none was declared
+
+};
+
+// Admission control, checked when jobs are added or their WCET is declared
+typedef enum {
+
+    JOB_RUNNER_ADMIT_OFF,           // Accept everything
+    JOB_RUNNER_ADMIT_WARN,          // Accept, but log when the job set fails the bound
+    JOB_RUNNER_ADMIT_REJECT,        // Refuse the change with JR_UNSCHEDULABLE
+
+} job_runner_admission_t;
+
+typedef enum {
+
+    JOB_RUNNER_BOUND_RM,            // Rate monotonic, n(2^(1/n) - 1) for n periodic jobs
+    JOB_RUNNER_BOUND_EDF,           // Earliest deadline first, 100%
+
+} job_runner_bound_t;
+
+// Utilizations are in 1/1000 of the runner task. Callbacks are never preempted, so a set within the bound can still
+// see a job delayed by the longest callback of the others.
+struct job_runner_sched_stats {
+
+    uint16_t periodic_jobs;         // Jobs counted, offloaded jobs run on helpers and are left out while helpers exist
+    uint16_t unknown_jobs;          // Counted jobs with neither a declared nor a measured WCET yet
+    uint32_t utilization;           // Sum of wcet / period
+    uint32_t bound;                 // Highest utilization the selected test accepts
+    int32_t headroom;               // bound - utilization, negative when deadlines can be missed
+    int8_t calibrating;             // A calibration window is still measuring
+
+};
+
+struct job_runner_replay_stats {
+
+    uint32_t jobs;                  // Jobs registered in the recording
+    uint32_t notifications;         // Notifications sent by the replay
+    uint32_t ticks;                 // Length of the recording in ticks
+    uint32_t dispatched;            // Callbacks run by the replayed runner
+    uint32_t wall_us;               // Real time the replay took, dispatched / wall_us is the throughput
+    uint32_t max_late;              // Worst lateness of a periodic run, in ticks
+    struct job_runner_latency_stats latency;    // On the recorded timeline, the replay's virtual clock
+
+};
+
+// Commands reach the runner on two queues, it only takes from the normal lane while the control lane is empty.
+// Ordering rules:
+//  - Commands on one lane are taken in the order they were sent.
+//  - A control command overtakes normal commands sent before it. A synchronous call sees the runner before any
+//    notification, publish or schedule change still waiting on the normal lane.
+//  - Delayed notifications go on the control lane, cancelling a handle right after it was handed out always finds it.
+//  - Schedule changes stay on the normal lane, behind the notifications and migrations sent before them.
+//  - Of two notifications waiting for one job the one sent last is kept, whichever lane got it to the runner first.
+//    The other is destroyed, or simply let go when it came without a destructor.
+typedef enum {
+
+    JOB_RUNNER_LANE_CONTROL,        // Synchronous calls, delayed notifications, urgent notifications
+    JOB_RUNNER_LANE_NORMAL,         // Notifications, publishes, pause, resume and the other schedule changes, offload results, migrations
+    JOB_RUNNER_NUM_LANES
+
+} job_runner_lane_t;
+
+struct job_runner_lane_stats {
+
+    uint16_t depth;                 // Commands waiting right now
+    uint16_t size;
+    uint16_t peak_depth;            // Most commands seen waiting when the runner took one
+    uint32_t commands;              // Commands taken off the lane
+    uint32_t mean_wait_us;          // Time from the send to the runner taking the command
+    uint32_t max_wait_us;
+
+};
+
+struct job_runner_clock {
+
+    uint32_t (*now)(void* ctx);                 // Current time in ticks
+    void (*sleep)(void* ctx, uint32_t ticks);   // Block the runner for ticks
+    void* ctx;
+
+};
+
+struct job_runner_virtual_clock {
+
+    uint32_t now;                   // Only moves when the runner sleeps, or when the caller sets it
+
+};
+
 typedef void* job_runner_shutdown_response_handle_t;
 
+// Topics are plain integers below JOB_RUNNER_TOPIC_NAMED, job_runner_topic maps names above it
+typedef uint32_t job_runner_topic_t;
+
+// Handle of a delayed notification, never 0
+typedef uint32_t job_runner_timer_t;
+
+#define JOB_RUNNER_TOPIC_NAMED 0x80000000
+
 struct job_runner;
 
+struct job_runner_balancer;
+
+struct job_runner_stream;
+
+struct job_runner_stream_stats {
+
+    uint32_t committed;             // Slots handed to the consumer
+    uint32_t dropped;               // Reserves refused because the ring was full
+    uint32_t high_water;            // Most slots waiting at once
+    uint32_t wakeups;               // Empty to non-empty transitions that notified the consumer
+
+};
+
+// Waits for room in a full queue, except from a job of the same runner or while simulating. Nothing else empties the queue
+// then, the call returns JR_QUEUE_FULL right away and the caller keeps the payload.
 jrerr_t job_runner_notify_job(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd) );
 
+// notif_size is what the payload holds on the heap, it counts against the runner's budget until the payload is destroyed.
+// Over budget the call returns JR_OVER_BUDGET and the caller keeps the payload.
+jrerr_t job_runner_notify_job_sized(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t notif_size);
+
+// Copies up to JOB_RUNNER_INLINE_SIZE bytes into the queue, no allocation and no destructor. The callback gets a pointer to
+// the job's copy (8 byte aligned), valid until the callback returns. With len 0 the callback gets NULL, whatever payload is.
+jrerr_t job_runner_notify_job_inline(struct job_runner* runner, int16_t job_id, const void* payload, uint8_t len);
+
+// Same as job_runner_notify_job on the control lane, it overtakes every notification still waiting on the normal lane.
+// An older notification for the same job taken after it is dropped, not delivered over it.
+jrerr_t job_runner_notify_job_urgent(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd));
+
+// Hash of a topic name, two names can collide so keep them distinct within a runner
+job_runner_topic_t job_runner_topic(const char* name);
+
+// Subscribed jobs stay on their runner, they are not migrated or balanced. A runner holds up to UINT16_MAX subscriptions,
+// past that subscribing returns JR_FAIL.
+jrerr_t job_runner_subscribe(struct job_runner* runner, int16_t job_id, job_runner_topic_t topic);
+
+// JR_NOT_SUBSCRIBED when the job exists but is not subscribed to topic
+jrerr_t job_runner_unsubscribe(struct job_runner* runner, int16_t job_id, job_runner_topic_t topic);
+
+// One command for all subscribers, each gets the same pointer as a notification. The destructor runs once, after the
+// last subscriber ran. A payload nobody subscribed to is destroyed right away.
+// The payload is shared, not copied: subscribers run one after another on the runner task, and whatever one of them
+// writes into it is what the later ones see. Treat it as read only unless the subscribers agree otherwise.
+jrerr_t job_runner_publish(struct job_runner* runner, job_runner_topic_t topic, void* data, void (*dtor)(void* data));
+
+// Notifies the job once tick (runner clock) is reached, the runner wakes for it without a helper job. A tick already
+// passed is delivered on the next loop. handle may be NULL.
+jrerr_t job_runner_notify_job_at(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t tick, job_runner_timer_t* handle);
+
+// Same as job_runner_notify_job_at, delay ticks from now
+jrerr_t job_runner_notify_job_delayed(struct job_runner* runner, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd), uint32_t delay, job_runner_timer_t* handle);
+
+// Destroys the payload of a delayed notification that is not due yet, JR_NOT_PENDING once delivered or cancelled
+jrerr_t job_runner_cancel_notification(struct job_runner* runner, job_runner_timer_t handle);
+
+// The first run comes one repeat_delay after the runner starts, as it always has. A job_runner_add_jobs row runs first
+// at its phase instead, so a row with phase 0 runs at the start; job_runner_set_job_phase gives a single job the same.
 jrerr_t job_runner_add_job(struct job_runner* runner, void* job_callback, uint32_t repeat_delay, int16_t* job_id);
 
-jrerr_t job_runner_execute();
+// Same as job_runner_add_job with a declared WCET, admission control counts the job's load from the start
+jrerr_t job_runner_add_job_with_wcet(struct job_runner* runner, void* job_callback, uint32_t repeat_delay, uint32_t wcet_us, int16_t* job_id);
+
+// Same as job_runner_add_job, every call of job_callback also gets context. The runner never touches what it points at.
+jrerr_t job_runner_add_job_with_context(struct job_runner* runner, job_runner_context_callback_t job_callback, void* context, uint32_t repeat_delay, int16_t* job_id);
+
+// Registers a whole table in one allocation. Each job keeps its callback and context and nothing else of the descriptor,
+// the table can be a const one in flash or go right after the call. Ids are contiguous, starting at first_id in table
+// order, the lowest run of count free ids. A single add takes the smallest free id the same way.
+jrerr_t job_runner_add_jobs(struct job_runner* runner, const struct job_runner_job_desc* table, uint16_t count, int16_t* first_id);
+
+// Before the runner starts. Jobs without a pinned phase get their first run spread across their period when the runner
+// starts, so jobs with equal or harmonic periods do not all run on the same tick.
+jrerr_t job_runner_set_phase_staggering(struct job_runner* runner, uint8_t enable);
+
+// Before the runner starts. Pins the first run phase ticks after the runner starts, staggering leaves the job alone.
+jrerr_t job_runner_set_job_phase(struct job_runner* runner, int16_t job_id, uint32_t phase);
+
+jrerr_t job_runner_pause_job(struct job_runner* runner, int16_t job_id);
+
+jrerr_t job_runner_resume_job(struct job_runner* runner, int16_t job_id);
+
+// With admission control on the change is checked on the runner task, in reject mode an unschedulable period
+// returns JR_UNSCHEDULABLE and the job keeps its old one. Otherwise it is queued and applied by the runner.
+jrerr_t job_runner_set_job_period(struct job_runner* runner, int16_t job_id, uint32_t repeat_delay);
+
+jrerr_t job_runner_set_job_deadline(struct job_runner* runner, int16_t job_id, uint32_t ticks_from_now);
+
+jrerr_t job_runner_set_job_offload(struct job_runner* runner, int16_t job_id, uint8_t offload);
+
+// Only from inside a job callback on the runner task. Its next run is ticks from now instead of one period, the period
+// stays for the runs after. portMAX_DELAY parks the job until it is notified or the runner shuts down.
+jrerr_t job_runner_defer_job(struct job_runner* runner, uint32_t ticks);
+
+// Runs a job on the next pass without a notification, parked or not. Called from a job on the runner task it never
+// waits on a queue, so one job can wake another.
+jrerr_t job_runner_wake_job(struct job_runner* runner, int16_t job_id);
+
+// Runner clock in ticks, the virtual clock once one is set
+jrerr_t job_runner_get_tick(struct job_runner* runner, uint32_t* tick);
+
+jrerr_t job_runner_execute(struct job_runner* runner, const char* runner_name, uint32_t runner_stack, unsigned int priority);
+
+jrerr_t job_runner_execute_pinned(struct job_runner* runner, const char* runner_name, uint32_t runner_stack, unsigned int priority, int core_id);
+
+jrerr_t job_runner_migrate_job(struct job_runner* runner, int16_t job_id, struct job_runner* target);
 
 jrerr_t job_runner_shutdown(struct job_runner* runner);
 
 jrerr_t job_runner_shutdown_async(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel);
 
+// On JR_TIMEOUT the handle stays valid and can be awaited again
 jrerr_t job_runner_await_shutdown(job_runner_shutdown_response_handle_t shutdown_resp_channel, uint32_t ticks_to_wait);
 
+// Waits for every runner behind the handles to finish its shutdown, without allocating. Handles are only used up when
+// all of them completed in time.
+jrerr_t job_runner_await_all(job_runner_shutdown_response_handle_t* shutdown_resp_channels, uint16_t count, uint32_t ticks_to_wait);
+
+// A runner has one handle, asking again (here or through job_runner_shutdown_async) returns the same one
 jrerr_t job_runner_get_shutdown_response_handle(struct job_runner* runner, job_runner_shutdown_response_handle_t* shutdown_resp_channel);
 
+// JOB_RUNNER_STACK_MONITOR_CALIBRATE runs every active job once as the runner starts. That run is the job's first one, brought
+// forward: later runs keep the job's phase, and a job returning JOB_RUNNER_IM_DONE from it is removed as after any run.
+jrerr_t job_runner_set_stack_monitor(struct job_runner* runner, job_runner_stack_monitor_t mode);
+
+jrerr_t job_runner_get_stack_stats(struct job_runner* runner, struct job_runner_stack_stats* stats);
+
+// Coalescing happens before a queue slot is used, a burst only ever holds one command in the queue. If that command does
+// not fit, the pending payload is destroyed and the notification returns JR_QUEUE_FULL.
+// merge returns the payload to keep, each input it did not return is destroyed with its destructor. A new result takes
+// over the pending payload's destructor.
+jrerr_t job_runner_set_notif_coalescing(struct job_runner* runner, int16_t job_id, job_runner_coalesce_t mode, void* (*merge)(void* pending, void* incoming));
+
+// Token bucket, a notification over the rate returns JR_RATE_LIMITED and the caller keeps the payload
+jrerr_t job_runner_set_notif_rate(struct job_runner* runner, int16_t job_id, uint32_t per_second, uint32_t burst);
+
+jrerr_t job_runner_get_notif_stats(struct job_runner* runner, int16_t job_id, struct job_runner_notif_stats* stats);
+
+// Snapshots hold ids, periods, flags and the time left to each deadline. Restoring rebuilds the jobs in one go, before
+// job_runner_execute, with their original phases; callbacks maps every id in the snapshot to its callback, and to its
+// context for a JOB_RUNNER_JOB_CONTEXT job since pointers are never saved. The jobs are appended in snapshot order and
+// admitted as one set like job_runner_add_jobs. A snapshot holding an id twice is refused with JR_INVALID_SNAPSHOT
+// before any job is added.
+jrerr_t job_runner_snapshot(struct job_runner* runner, void* buffer, size_t size, size_t* used);
+
+jrerr_t job_runner_restore(struct job_runner* runner, const void* buffer, size_t size, const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks);
+
+jrerr_t job_runner_snapshot_save_nvs(struct job_runner* runner, const char* nvs_namespace, const char* key);
+
+jrerr_t job_runner_snapshot_load_nvs(struct job_runner* runner, const char* nvs_namespace, const char* key, const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks);
+
+jrerr_t job_runner_snapshot_save_file(struct job_runner* runner, const char* path);
+
+jrerr_t job_runner_snapshot_load_file(struct job_runner* runner, const char* path, const struct job_runner_restore_entry* callbacks, uint16_t num_callbacks);
+
+// Sleep at floor while jobs are due or commands arrive, back off towards ceiling when idle. Replaces loop_delay.
+jrerr_t job_runner_set_adaptive_delay(struct job_runner* runner, uint32_t floor, uint32_t ceiling);
+
+jrerr_t job_runner_get_loop_stats(struct job_runner* runner, struct job_runner_loop_stats* stats);
+
+jrerr_t job_runner_get_lane_stats(struct job_runner* runner, job_runner_lane_t lane, struct job_runner_lane_stats* stats);
+
+// Raises the runner task to boost->priority while it falls behind and puts it back once both triggers are down to their
+// off levels. NULL turns boosting off, a change while boosted ends that boost first. A priority not above the one the
+// task runs at is refused with JR_FAIL, here once the runner started and by job_runner_execute before that. Without a
+// runner task only the stats move.
+jrerr_t job_runner_set_priority_boost(struct job_runner* runner, const struct job_runner_boost* boost);
+
+jrerr_t job_runner_get_boost_stats(struct job_runner* runner, struct job_runner_boost_stats* stats);
+
+// Caps job_bytes + notif_bytes, 0 for no limit
+jrerr_t job_runner_set_mem_budget(struct job_runner* runner, uint32_t max_bytes);
+
+jrerr_t job_runner_get_mem_stats(struct job_runner* runner, struct job_runner_mem_stats* stats);
+
+// Turns admission control on, bound selects the schedulability test
+jrerr_t job_runner_set_admission(struct job_runner* runner, job_runner_admission_t mode, job_runner_bound_t bound);
+
+// Declares the worst case callback time of a job, 0 goes back to the measured one. Rejected with JR_UNSCHEDULABLE
+// when admission control refuses the new set.
+jrerr_t job_runner_set_job_wcet(struct job_runner* runner, int16_t job_id, uint32_t wcet_us);
+
+// Forgets the measured WCETs and measures again for ticks, the set is checked against the bound when the window closes.
+// Jobs already running are never removed, an unschedulable set is only logged.
+jrerr_t job_runner_calibrate_wcet(struct job_runner* runner, uint32_t ticks);
+
+jrerr_t job_runner_get_sched_stats(struct job_runner* runner, struct job_runner_sched_stats* stats);
+
+// Notification latency of one job, or of the whole runner with job_id -1. Notifications folded together by coalescing
+// count once, from the oldest of them, one replaced before its job ran is counted when it is replaced. With
+// job_runner_set_clock the samples are taken on that clock, in whole ticks. A job not tracked reads all zeros.
+jrerr_t job_runner_get_latency(struct job_runner* runner, int16_t job_id, struct job_runner_latency_stats* stats);
+
+// Gives a job its own histograms (allocated here, on the caller) or takes them away. The runner's always count.
+jrerr_t job_runner_track_latency(struct job_runner* runner, int16_t job_id, int8_t enable);
+
+// job_id -1 resets the runner and every job on it
+jrerr_t job_runner_reset_latency(struct job_runner* runner, int16_t job_id);
+
+// Consistent snapshot taken on the runner task between two loop iterations, scheduling carries on right after.
+// Fills up to max_jobs entries (active jobs first, then paused ones), info always has the full counts.
+jrerr_t job_runner_inspect(struct job_runner* runner, struct job_runner_info* info, struct job_runner_job_info* jobs, uint16_t max_jobs, uint16_t* num_filled);
+
+// Human readable table of job_runner_inspect, for a console or a log
+jrerr_t job_runner_dump(struct job_runner* runner, FILE* out);
+
+// Appends job registrations, notifications (with payload size) and callback times to buffer until it is full or the
+// recording is stopped. Entries are 16 bytes, jobs already on the runner are recorded when recording starts.
+jrerr_t job_runner_record_start(struct job_runner* runner, void* buffer, size_t size);
+
+// used is the size of the finished recording in buffer, dropped the entries that did not fit. Entries other tasks were
+// still writing are complete when it returns, nothing is written to buffer after.
+jrerr_t job_runner_record_stop(struct job_runner* runner, size_t* used, uint32_t* dropped);
+
+// Drives a fresh runner on a virtual clock with the recorded sequence. Each job busy waits its recorded average
+// callback time and is done when the original was, notifications are resent at their recorded tick. Pause, resume,
+// period changes and publishes are not recorded.
+jrerr_t job_runner_replay(const void* recording, size_t size, uint32_t loop_delay, struct job_runner_replay_stats* stats);
+
+// Registers the "jobs" console command dumping these runners, the array is copied. A runner that shut down is reported
+// as such, it is never touched once freed. Calling again replaces the list. Call after esp_console_init.
+jrerr_t job_runner_console_register(struct job_runner** runners, uint8_t num_runners);
+
+// Replaces xTaskGetTickCount and the loop sleep for everything the runner schedules. Set before the runner starts.
+jrerr_t job_runner_set_clock(struct job_runner* runner, const struct job_runner_clock* clock);
+
+// Fills clock with a virtual time source starting at start, time only moves when the runner sleeps
+jrerr_t job_runner_virtual_clock_init(struct job_runner_virtual_clock* vclock, struct job_runner_clock* clock, uint32_t start);
+
+// Drives a runner with a replaced clock from the calling task instead of job_runner_execute, for ticks of its clock.
+// Nothing runs concurrently so a seeded workload replays identically. Helpers are not started, offloaded jobs run inline.
+// finished is set once the runner ran out of jobs and was freed. Queued commands are only taken while simulating.
+jrerr_t job_runner_simulate(struct job_runner* runner, uint32_t ticks, int8_t* finished);
+
+// Helper tasks started with the runner. An offloaded job is handed to a helper when due and is not run again until it
+// returns, so a slow callback no longer holds up the other jobs. Without helpers offloaded jobs run on the runner task.
+jrerr_t job_runner_set_helpers(struct job_runner* runner, uint8_t num_helpers, uint32_t helper_stack, unsigned int priority);
+
 jrerr_t job_runner_create( struct job_runner** new_runner, uint32_t loop_delay );
 
+// Balancer, moves periodic jobs from the busiest to the idlest runner once their utilization (percent) differs by more than threshold.
+// Runners must not be started yet and should only get jobs through the balancer. Destroy the balancer before shutting the runners down.
+// A runner that runs out of jobs leaves the balancer before it frees itself and reads 0% from then on.
+jrerr_t job_runner_balancer_create(struct job_runner_balancer** new_balancer, struct job_runner** runners, uint8_t num_runners, uint8_t threshold, uint32_t period);
+
+jrerr_t job_runner_balancer_add_job(struct job_runner_balancer* balancer, void* job_callback, uint32_t repeat_delay, int16_t* job_id);
+
+jrerr_t job_runner_balancer_notify_job(struct job_runner_balancer* balancer, int16_t job_id, void* notif_data, void (*notif_dtor)(void* nd));
+
+// Starts every runner or none. Runners wait until all of them are up, on a failure those already started are stopped
+// again before they ran a job and can be started later.
+jrerr_t job_runner_balancer_execute(struct job_runner_balancer* balancer, const char* runner_name, uint32_t runner_stack, unsigned int priority);
+
+jrerr_t job_runner_balancer_get_utilization(struct job_runner_balancer* balancer, uint8_t runner_index, uint8_t* utilization);
+
+jrerr_t job_runner_balancer_destroy(struct job_runner_balancer* balancer);
+
+// Output stream of one producer (usually a job) to one consumer task, lock free and without copies. num_slots must
+// be a power of two, slots are slot_size bytes rounded up to 8.
+jrerr_t job_runner_stream_create(struct job_runner_stream** new_stream, uint16_t slot_size, uint16_t num_slots);
+
+// The calling task becomes the consumer, it gets notify_bits (eSetBits) whenever the stream goes from empty to non-empty
+jrerr_t job_runner_stream_bind_consumer(struct job_runner_stream* stream, uint32_t notify_bits);
+
+// Producer side. reserve returns the next free slot to write in place, NULL while full; commit hands it over with
+// len bytes used, JR_QUEUE_FULL when the ring is full and nothing was reserved. Reserving again before a commit returns
+// the same slot.
+void* job_runner_stream_reserve(struct job_runner_stream* stream);
+
+jrerr_t job_runner_stream_commit(struct job_runner_stream* stream, uint16_t len);
+
+// Consumer side. peek returns the oldest committed slot, NULL when empty; the slot stays valid until release.
+// Drain until peek returns NULL before waiting for the next notification. A job consuming a stream is not bound, it
+// polls with peek from its callback: commit never blocks, and waking a job would need a slot in its runner's queue.
+const void* job_runner_stream_peek(struct job_runner_stream* stream, uint16_t* len);
+
+jrerr_t job_runner_stream_release(struct job_runner_stream* stream);
+
+jrerr_t job_runner_stream_get_stats(struct job_runner_stream* stream, struct job_runner_stream_stats* stats);
+
+// Neither side may use the stream any more
+jrerr_t job_runner_stream_destroy(struct job_runner_stream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif // __JOB_RUNNER__
\ No newline at end of file
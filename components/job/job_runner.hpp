@@ -0,0 +1,304 @@
+/*
+ * Job Runner
+ *
+ * Copyright (c) 2018 Brandon Bemister. All rights reserved.
+ * https://github.com/bjbemister19/job-runner
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Brandon Bemister
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+#ifndef __JOB_RUNNER_HPP__
+#define __JOB_RUNNER_HPP__
+
+// Header only C++ front end, nothing in here allocates. Needs C++17.
+#if __cplusplus < 201703L
+#error "job_runner.hpp needs C++17"
+#endif
+
+#include "job_runner.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace jr {
+
+using callback_t = job_runner_state_t (*)(job_runner_state_t state, void* data);
+
+// The runner calls this with the job's slot as context, F is called directly and can be inlined into it
+template <typename F>
+job_runner_state_t invoke_slot(job_runner_state_t state, void* data, void* context){
+
+    return (*std::launder(static_cast<F*>(context)))(state, data);
+
+}
+
+// Fixed size storage for one callable, anything that does not fit fails to compile instead of going to the heap
+template <std::size_t Size>
+class callable_slot {
+
+public:
+
+    callable_slot() = default;
+    callable_slot(const callable_slot&) = delete;
+    callable_slot& operator=(const callable_slot&) = delete;
+
+    ~callable_slot(){
+        reset();
+    }
+
+    template <typename F>
+    std::decay_t<F>* emplace(F&& f){
+
+        using T = std::decay_t<F>;
+
+        static_assert(sizeof(T) <= Size, "callable does not fit the job slot, raise SlotSize");
+        static_assert(alignof(T) <= alignof(std::max_align_t), "callable is over aligned for a job slot");
+        static_assert(std::is_invocable_r_v<job_runner_state_t, T&, job_runner_state_t, void*>,
+            "job callables take (job_runner_state_t state, void* data) and return job_runner_state_t");
+
+        reset();
+
+        T* callable = new (storage_) T(std::forward<F>(f));
+        destroy_ = [](void* storage){ std::launder(static_cast<T*>(storage))->~T(); };
+
+        return callable;
+
+    }
+
+    void reset(){
+
+        if(destroy_ != nullptr){
+            destroy_(storage_);
+            destroy_ = nullptr;
+        }
+
+    }
+
+private:
+
+    alignas(std::max_align_t) unsigned char storage_[Size];
+    void (*destroy_)(void* storage) = nullptr;
+
+};
+
+// One row of a job table, built with periodic() so a bad row fails the build
+struct job_spec {
+
+    callback_t callback;
+    uint32_t repeat_delay;
+    uint32_t phase;
+    uint8_t priority;
+    uint8_t flags;
+    uint32_t wcet_us;
+
+};
+
+// Deliberately not constexpr, reaching it while a table is built is a compile error pointing at the broken rule. ESP-IDF
+// builds with -fno-exceptions, so this stands in for a throw. Outside a constant expression it stops the program.
+[[noreturn]] inline void table_error(const char* why){
+
+    (void) why;
+    std::abort();
+
+}
+
+// Checked during constant evaluation, so a bad row costs nothing at run time
+constexpr job_spec periodic(callback_t callback, uint32_t repeat_delay, uint32_t phase = 0, uint8_t priority = 0, uint8_t flags = 0, uint32_t wcet_us = 0){
+
+    if(callback == nullptr){
+        table_error("job table row without a callback");
+    }
+
+    if(flags & ~(JOB_RUNNER_JOB_PAUSED | JOB_RUNNER_JOB_OFFLOAD | JOB_RUNNER_JOB_PIN_PHASE)){
+        table_error("job table rows take PAUSED, OFFLOAD and PIN_PHASE only, context jobs go through runner::add_job");
+    }
+
+    if(repeat_delay > 0 && phase > repeat_delay){
+        table_error("phase is longer than the period");
+    }
+
+    if(repeat_delay > 0 && wcet_us >= (uint64_t) repeat_delay * portTICK_PERIOD_MS * 1000){
+        table_error("wcet does not fit in the period");
+    }
+
+    return job_spec{ callback, repeat_delay, phase, priority, flags, wcet_us };
+
+}
+
+template <typename... Specs>
+constexpr std::array<job_spec, sizeof...(Specs)> make_table(const Specs&... specs){
+
+    static_assert(sizeof...(Specs) > 0, "empty job table");
+    static_assert((std::is_same_v<Specs, job_spec> && ...), "job tables are made of periodic() rows");
+
+    std::array<job_spec, sizeof...(Specs)> table{ specs... };
+    uint64_t utilization = 0;
+
+    // Same sum as admission control, in 1/1000000 of the runner
+    for(const job_spec& spec : table){
+        if(spec.repeat_delay > 0){
+            utilization += ((uint64_t) spec.wcet_us * 1000000) / ((uint64_t) spec.repeat_delay * portTICK_PERIOD_MS * 1000);
+        }
+    }
+
+    if(utilization > 1000000){
+        table_error("declared wcets overload the runner");
+    }
+
+    return table;
+
+}
+
+// The C descriptors point at the callbacks, a cast no constant expression may contain, so they are filled in once on
+// first use and kept for every later call. add_jobs copies what each job needs, nothing points into them afterwards.
+template <const auto& Table>
+const job_runner_job_desc* descriptors(){
+
+    static const auto descs = [](){
+
+        std::array<job_runner_job_desc, Table.size()> out{};
+
+        for(std::size_t i = 0; i < out.size(); i++){
+            out[i] = job_runner_job_desc{ reinterpret_cast<void*>(Table[i].callback), Table[i].repeat_delay, Table[i].phase,
+                Table[i].priority, Table[i].flags, Table[i].wcet_us, nullptr };
+        }
+
+        return out;
+
+    }();
+
+    return descs.data();
+
+}
+
+// Owns a C runner and the callables of its jobs. Jobs are held in MaxJobs slots of SlotSize bytes, so the object has to
+// stay where it is until the runner is gone, after job_runner_await_shutdown or a finished job_runner_simulate.
+template <std::size_t MaxJobs = 16, std::size_t SlotSize = 32>
+class runner {
+
+public:
+
+    runner() = default;
+    runner(const runner&) = delete;
+    runner& operator=(const runner&) = delete;
+
+    jrerr_t create(uint32_t loop_delay){
+
+        return job_runner_create(&handle_, loop_delay);
+
+    }
+
+    // Plain functions and captureless lambdas go straight to the C runner, anything with state takes a slot
+    template <typename F>
+    jrerr_t add_job(F&& f, uint32_t repeat_delay, int16_t* job_id = nullptr){
+
+        using T = std::decay_t<F>;
+
+        if constexpr (std::is_convertible_v<T, callback_t>){
+
+            callback_t callback = f;
+            return job_runner_add_job(handle_, reinterpret_cast<void*>(callback), repeat_delay, job_id);
+
+        }
+        else {
+
+            if(used_ == MaxJobs){
+                return JR_MEMORY_ALLOC_FAIL;
+            }
+
+            T* callable = slots_[used_].emplace(std::forward<F>(f));
+
+            jrerr_t err = job_runner_add_job_with_context(handle_, &invoke_slot<T>, callable, repeat_delay, job_id);
+
+            if(err == JR_SUCCESS){
+                used_++;
+            }
+            else {
+                slots_[used_].reset();
+            }
+
+            return err;
+
+        }
+
+    }
+
+    template <const auto& Table>
+    jrerr_t add_jobs(int16_t* first_id = nullptr){
+
+        return job_runner_add_jobs(handle_, descriptors<Table>(), (uint16_t) Table.size(), first_id);
+
+    }
+
+    // The runner takes the object over and deletes it once the job ran, or right away when the notification is refused
+    template <typename T>
+    jrerr_t notify(int16_t job_id, std::unique_ptr<T> data){
+
+        jrerr_t err = job_runner_notify_job(handle_, job_id, data.get(), [](void* p){ delete static_cast<T*>(p); });
+
+        if(err == JR_SUCCESS){
+            data.release();
+        }
+
+        return err;
+
+    }
+
+    jrerr_t notify(int16_t job_id){
+
+        return job_runner_notify_job(handle_, job_id, nullptr, nullptr);
+
+    }
+
+    jrerr_t execute(const char* name, uint32_t stack, unsigned int priority){
+
+        return job_runner_execute(handle_, name, stack, priority);
+
+    }
+
+    jrerr_t shutdown(){
+
+        return job_runner_shutdown(handle_);
+
+    }
+
+    struct job_runner* get() const {
+
+        return handle_;
+
+    }
+
+private:
+
+    struct job_runner* handle_ = nullptr;
+    std::array<callable_slot<SlotSize>, MaxJobs> slots_;
+    std::size_t used_ = 0;
+
+};
+
+} // namespace jr
+
+#endif // __JOB_RUNNER_HPP__
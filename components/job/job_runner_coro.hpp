@@ -0,0 +1,487 @@
+/*
+ * Job Runner
+ *
+ * Copyright (c) 2018 Brandon Bemister. All rights reserved.
+ * https://github.com/bjbemister19/job-runner
+ *
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2018 Brandon Bemister
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated
+ * documentation files (the "Software"), to deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all copies or substantial portions of the
+ * Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE
+ * WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS
+ * OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR
+ * OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ *
+ */
+
+
+#ifndef __JOB_RUNNER_CORO_HPP__
+#define __JOB_RUNNER_CORO_HPP__
+
+// Jobs written as C++20 coroutines, header only. Frames come from an arena inside co_runner, never from the heap.
+#if __cplusplus < 202002L
+#error "job_runner_coro.hpp needs C++20"
+#endif
+
+#include "job_runner.h"
+
+#include "freertos/FreeRTOS.h"
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <utility>
+
+namespace jr {
+
+// Bump allocator over a buffer it does not own. Jobs are only added before the runner starts, so frames are never
+// handed out again one by one, the arena is empty again once the last frame is gone.
+class co_arena {
+
+public:
+
+    static constexpr std::size_t header = alignof(std::max_align_t);
+
+    co_arena(void* buffer, std::size_t size) : base_(static_cast<unsigned char*>(buffer)), size_(size) {}
+    co_arena(const co_arena&) = delete;
+    co_arena& operator=(const co_arena&) = delete;
+
+    void* allocate(std::size_t size) noexcept {
+
+        std::size_t need = (size + header + header - 1) & ~(header - 1);
+
+        if(size_ - used_ < need){
+            return nullptr;
+        }
+
+        // The frame remembers its arena, the coroutine's operator delete gets nothing else
+        unsigned char* block = base_ + used_;
+        *reinterpret_cast<co_arena**>(block) = this;
+
+        used_ += need;
+        live_++;
+
+        if(used_ > peak_){
+            peak_ = used_;
+        }
+
+        return block + header;
+
+    }
+
+    static void release(void* frame) noexcept {
+
+        co_arena* arena = *reinterpret_cast<co_arena**>(static_cast<unsigned char*>(frame) - header);
+
+        if(--arena->live_ == 0){
+            arena->used_ = 0;
+        }
+
+    }
+
+    std::size_t used() const {
+        return used_;
+    }
+
+    std::size_t peak() const {
+        return peak_;
+    }
+
+private:
+
+    unsigned char* base_;
+    std::size_t size_;
+    std::size_t used_ = 0;
+    std::size_t peak_ = 0;
+    std::size_t live_ = 0;
+
+};
+
+class co_context;
+
+// Return type of a coroutine job. Its first parameter has to be the co_context& it is spawned with, that is where the
+// frame is allocated from, and a coroutine with any other first parameter does not compile.
+class job {
+
+public:
+
+    struct promise_type {
+
+        template <typename... Args>
+        static void* operator new(std::size_t size, co_context& ctx, Args&...) noexcept;
+
+        static void operator delete(void* frame, std::size_t) noexcept {
+            co_arena::release(frame);
+        }
+
+        static job get_return_object_on_allocation_failure() noexcept {
+            return job();
+        }
+
+        job get_return_object() noexcept {
+            return job(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        // The body starts on the job's first run, on the runner task
+        std::suspend_always initial_suspend() noexcept {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept {
+            return {};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept {
+            std::terminate();
+        }
+
+    };
+
+    job() = default;
+    job(const job&) = delete;
+    job& operator=(const job&) = delete;
+
+    job(job&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+    ~job(){
+
+        if(handle_){
+            handle_.destroy();
+        }
+
+    }
+
+    std::coroutine_handle<> release(){
+        return std::exchange(handle_, nullptr);
+    }
+
+    explicit operator bool() const {
+        return static_cast<bool>(handle_);
+    }
+
+private:
+
+    explicit job(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+
+};
+
+// One per coroutine job. Every resume happens inside the job's own callback, the runner decides when that is: a sleep
+// is a deferred next run, a wait is a parked job that the notification runs.
+class co_context {
+
+public:
+
+    co_context() = default;
+    co_context(const co_context&) = delete;
+    co_context& operator=(const co_context&) = delete;
+
+    struct sleep_awaiter {
+
+        co_context& ctx;
+        uint32_t ticks;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<>) noexcept {
+
+            uint32_t now = 0;
+            job_runner_get_tick(ctx.runner_, &now);
+
+            ctx.wait_ = wait::sleep;
+            ctx.wake_ = now + ticks;
+            job_runner_defer_job(ctx.runner_, ticks);
+
+        }
+
+        void await_resume() const noexcept {}
+
+    };
+
+    struct notification_awaiter {
+
+        co_context& ctx;
+
+        bool await_ready() const noexcept {
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<>) noexcept {
+
+            ctx.wait_ = wait::notification;
+            job_runner_defer_job(ctx.runner_, portMAX_DELAY);
+
+        }
+
+        void* await_resume() const noexcept {
+            return ctx.data_;
+        }
+
+    };
+
+    struct completion_awaiter {
+
+        co_context& ctx;
+        int16_t job_id;
+
+        bool await_ready() const noexcept {
+            return ! ctx.running(job_id);
+        }
+
+        void await_suspend(std::coroutine_handle<>) noexcept {
+
+            ctx.wait_ = wait::completion;
+            ctx.awaited_ = job_id;
+            job_runner_defer_job(ctx.runner_, portMAX_DELAY);
+
+        }
+
+        void await_resume() const noexcept {}
+
+    };
+
+    // Resumes ticks from now, 0 lets the other jobs run and resumes on the next pass. A notification that arrives in
+    // the meantime is dropped.
+    sleep_awaiter sleep(uint32_t ticks){
+        return sleep_awaiter{ *this, ticks };
+    }
+
+    // Resumes with the payload of the next notification, NULL for one without. The payload is the runner's, it is
+    // destroyed at the next co_await.
+    notification_awaiter notification(){
+        return notification_awaiter{ *this };
+    }
+
+    // Resumes once the coroutine job job_id of the same co_runner returned, right away when it is not running. Plain C
+    // jobs are never waited for.
+    completion_awaiter completion(int16_t job_id){
+        return completion_awaiter{ *this, job_id };
+    }
+
+    struct job_runner* runner() const {
+        return runner_;
+    }
+
+    int16_t job_id() const {
+        return id_;
+    }
+
+    // What the runner calls for every coroutine job, context is the job's co_context
+    static job_runner_state_t dispatch(job_runner_state_t state, void* data, void* context){
+
+        co_context* ctx = static_cast<co_context*>(context);
+
+        if(state == JOB_RUNNER_SHUT_DOWN){
+
+            // Destroying a suspended frame runs the destructors of everything alive in it
+            ctx->finish(false);
+            return JOB_RUNNER_IM_DONE;
+
+        }
+
+        if( ! ctx->ready() ){
+            return JOB_RUNNER_KEEP_ALIVE;
+        }
+
+        ctx->data_ = data;
+        ctx->handle_.resume();
+        ctx->data_ = nullptr;
+
+        if(ctx->handle_.done()){
+
+            ctx->finish(true);
+            return JOB_RUNNER_IM_DONE;
+
+        }
+
+        return JOB_RUNNER_KEEP_ALIVE;
+
+    }
+
+private:
+
+    template <std::size_t, std::size_t>
+    friend class co_runner;
+    friend struct job::promise_type;
+
+    enum class wait : uint8_t { start, sleep, notification, completion };
+
+    bool running(int16_t job_id) const {
+
+        for(std::size_t i = 0; i < num_peers_; i++){
+            if(peers_[i].handle_ && peers_[i].id_ == job_id){
+                return true;
+            }
+        }
+
+        return false;
+
+    }
+
+    // Runs that come too early, a notification during a sleep or someone else's during a completion wait, go back to
+    // the runner without resuming
+    bool ready(){
+
+        if(wait_ == wait::sleep){
+
+            uint32_t now = 0;
+            job_runner_get_tick(runner_, &now);
+
+            int32_t left = (int32_t) (wake_ - now);
+
+            if(left > 0){
+                job_runner_defer_job(runner_, (uint32_t) left);
+                return false;
+            }
+
+        }
+        else if(wait_ == wait::completion && running(awaited_)){
+
+            job_runner_defer_job(runner_, portMAX_DELAY);
+            return false;
+
+        }
+
+        return true;
+
+    }
+
+    void finish(bool wake){
+
+        handle_.destroy();
+        handle_ = nullptr;
+
+        for(std::size_t i = 0; wake && i < num_peers_; i++){
+
+            co_context& peer = peers_[i];
+
+            // On the runner task, so the waiter is marked due right here instead of through the runner's own queue
+            if(peer.handle_ && peer.wait_ == wait::completion && peer.awaited_ == id_){
+                job_runner_wake_job(runner_, peer.id_);
+            }
+
+        }
+
+    }
+
+    struct job_runner* runner_ = nullptr;
+    co_arena* arena_ = nullptr;
+    co_context* peers_ = nullptr;
+    std::size_t num_peers_ = 0;
+
+    std::coroutine_handle<> handle_;
+    int16_t id_ = -1;
+    wait wait_ = wait::start;
+    uint32_t wake_ = 0;
+    int16_t awaited_ = -1;
+    void* data_ = nullptr;
+
+};
+
+template <typename... Args>
+void* job::promise_type::operator new(std::size_t size, co_context& ctx, Args&...) noexcept {
+
+    return ctx.arena_->allocate(size);
+
+}
+
+// Coroutine jobs of one runner, their contexts and the arena their frames live in. It has to outlive the runner,
+// until job_runner_await_shutdown or a finished job_runner_simulate.
+template <std::size_t ArenaSize = 2048, std::size_t MaxJobs = 8>
+class co_runner {
+
+public:
+
+    explicit co_runner(struct job_runner* runner) : runner_(runner), arena_(storage_, ArenaSize) {}
+    co_runner(const co_runner&) = delete;
+    co_runner& operator=(const co_runner&) = delete;
+
+    // Before the runner starts, like any other job. fn(ctx, args...) only creates the frame, the body starts on the
+    // job's first run.
+    template <typename Fn, typename... Args>
+    jrerr_t spawn(int16_t* job_id, Fn&& fn, Args&&... args){
+
+        co_context* ctx = nullptr;
+
+        for(std::size_t i = 0; ctx == nullptr && i < MaxJobs; i++){
+            ctx = contexts_[i].handle_ ? nullptr : &contexts_[i];
+        }
+
+        if(ctx == nullptr){
+            return JR_MEMORY_ALLOC_FAIL;
+        }
+
+        ctx->runner_ = runner_;
+        ctx->arena_ = &arena_;
+        ctx->peers_ = contexts_.data();
+        ctx->num_peers_ = MaxJobs;
+        ctx->wait_ = co_context::wait::start;
+
+        job frame = std::invoke(std::forward<Fn>(fn), *ctx, std::forward<Args>(args)...);
+
+        // The arena is full
+        if( ! frame ){
+            return JR_MEMORY_ALLOC_FAIL;
+        }
+
+        // Every run is picked by the awaits, the period is only what admission control charges the job. The first
+        // run is pinned to the start, in the same call that registers the job so a failure leaves nothing behind.
+        job_runner_job_desc desc{ reinterpret_cast<void*>(&co_context::dispatch), idle_period, 0, 0,
+            JOB_RUNNER_JOB_CONTEXT | JOB_RUNNER_JOB_PIN_PHASE, 0, ctx };
+
+        jrerr_t err = job_runner_add_jobs(runner_, &desc, 1, &ctx->id_);
+
+        if(err == JR_SUCCESS){
+
+            ctx->handle_ = frame.release();
+
+            if(job_id != nullptr){
+                *job_id = ctx->id_;
+            }
+
+        }
+
+        return err;
+
+    }
+
+    std::size_t arena_used() const {
+        return arena_.used();
+    }
+
+    std::size_t arena_peak() const {
+        return arena_.peak();
+    }
+
+private:
+
+    // Far enough out to cost nothing, near enough to compare correctly across tick wrap
+    static constexpr uint32_t idle_period = 0x3fffffff;
+
+    struct job_runner* runner_;
+    alignas(std::max_align_t) unsigned char storage_[ArenaSize];
+    co_arena arena_;
+    std::array<co_context, MaxJobs> contexts_;
+
+};
+
+} // namespace jr
+
+#endif // __JOB_RUNNER_CORO_HPP__
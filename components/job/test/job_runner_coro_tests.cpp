@@ -0,0 +1,348 @@
+#include "job_runner_tests.h"
+
+#ifdef JOB_RUNNER_TESTING_ENABLE
+#ifdef JOB_RUNNER_TEST_CORO
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+
+#include "job_runner.h"
+#include "job_runner_coro.hpp"
+
+#define CORO_TICKS 200000
+#define CORO_SLEEP_TICKS 20
+#define CORO_NOTIFY_TICK 50
+
+static job_runner_state_t job_runner_test_coro_plain(job_runner_state_t state, void*){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static jr::job job_runner_test_coro_loop(jr::co_context& ctx){
+
+    while(true){
+        co_await ctx.sleep(1);
+    }
+
+}
+
+static uint32_t job_runner_test_coro_tick(jr::co_context& ctx){
+
+    uint32_t tick = 0;
+    job_runner_get_tick(ctx.runner(), &tick);
+
+    return tick;
+
+}
+
+// Wake, give the sensor 20 ticks, read, then wait for whoever wants the reading
+static jr::job job_runner_test_coro_sensor(jr::co_context& ctx, uint32_t* log){
+
+    log[0] = job_runner_test_coro_tick(ctx);
+
+    co_await ctx.sleep(CORO_SLEEP_TICKS);
+    log[1] = job_runner_test_coro_tick(ctx);
+
+    void* data = co_await ctx.notification();
+    log[2] = job_runner_test_coro_tick(ctx);
+    log[3] = (data != NULL) ? *(uint32_t*) data : 0;
+
+}
+
+static jr::job job_runner_test_coro_waiter(jr::co_context& ctx, int16_t sensor, uint32_t* log){
+
+    co_await ctx.completion(sensor);
+    log[4] = job_runner_test_coro_tick(ctx);
+
+}
+
+// Leaves the runner's command queue full behind it, the waiter has to be woken without a queue slot
+static jr::job job_runner_test_coro_filler(jr::co_context& ctx, int16_t plain, int count){
+
+    for(int i = 0; i < count; i++){
+        job_runner_notify_job(ctx.runner(), plain, NULL, NULL);
+    }
+
+    co_return;
+
+}
+
+static jrerr_t job_runner_test_coro_finish(struct job_runner* runner, int8_t* finished){
+
+    jrerr_t err = JR_SUCCESS;
+
+    if( ! *finished ){
+        err = job_runner_shutdown(runner);
+    }
+
+    while(err == JR_SUCCESS && ! *finished){
+        err = job_runner_simulate(runner, 1000, finished);
+    }
+
+    return err;
+
+}
+
+// One job on a one tick loop, either a plain callback or a coroutine sleeping a tick, so the only difference per run is
+// the resume and the deferral behind the await
+static jrerr_t job_runner_test_coro_bench(bool coroutine, uint32_t* runs){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_info info = {};
+    int8_t finished = 0;
+    int64_t elapsed_us = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+
+    err = job_runner_create(&runner, 1);
+
+    jr::co_runner<256, 1> coroutines(runner);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS && coroutine){
+        err = coroutines.spawn(NULL, job_runner_test_coro_loop);
+    }
+    else if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, (void*) job_runner_test_coro_plain, 1, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+
+        int64_t start_us = esp_timer_get_time();
+        err = job_runner_simulate(runner, CORO_TICKS, &finished);
+        elapsed_us = esp_timer_get_time() - start_us;
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(runner, &info, NULL, 0, NULL);
+    }
+
+    if(err == JR_SUCCESS && (finished || info.dispatched == 0)){
+
+        ESP_LOGE("job_runner_test", "FAIL %s job stopped running, %u runs", coroutine ? "coroutine" : "callback",
+            (unsigned int) info.dispatched);
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS && coroutine && coroutines.arena_peak() == 0){
+
+        ESP_LOGE("job_runner_test", "FAIL coroutine frame never came from the arena");
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test", "%s: %u runs, %u ns per run, frame %u bytes", coroutine ? "coroutine" : "callback ",
+            (unsigned int) info.dispatched, (unsigned int) (elapsed_us * 1000 / info.dispatched), (unsigned int) coroutines.arena_peak());
+
+    }
+
+    *runs = info.dispatched;
+
+    if(runner != NULL){
+        job_runner_test_coro_finish(runner, &finished);
+    }
+
+    return err;
+
+}
+
+// The sensor wakes on the first tick, sleeps 20 ticks, then takes the reading notified at tick 50; the waiter resumes
+// once the sensor returned
+static jrerr_t job_runner_test_coro_protocol(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    static uint32_t reading = 42;
+    uint32_t log[5] = {0};
+    int16_t sensor = -1;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+
+    err = job_runner_create(&runner, 1);
+
+    jr::co_runner<1024, 2> coroutines(runner);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = coroutines.spawn(&sensor, job_runner_test_coro_sensor, log);
+    }
+
+    if(err == JR_SUCCESS){
+        err = coroutines.spawn(NULL, job_runner_test_coro_waiter, sensor, log);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job_delayed(runner, sensor, &reading, NULL, CORO_NOTIFY_TICK, NULL);
+    }
+
+    // Both coroutines return, the runner ends with them
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 1000, &finished);
+    }
+
+    if(err == JR_SUCCESS && ! finished){
+
+        ESP_LOGE("job_runner_test", "FAIL coroutines still running after 1000 ticks");
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS && (log[0] > 1 || log[1] != log[0] + CORO_SLEEP_TICKS)){
+
+        ESP_LOGE("job_runner_test", "FAIL sensor woke at %u and read at %u, expected 1 and %u", (unsigned int) log[0],
+            (unsigned int) log[1], (unsigned int) (log[0] + CORO_SLEEP_TICKS));
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS && (log[2] != CORO_NOTIFY_TICK || log[3] != reading)){
+
+        ESP_LOGE("job_runner_test", "FAIL notified at %u with %u, expected %u with %u", (unsigned int) log[2], (unsigned int) log[3],
+            (unsigned int) CORO_NOTIFY_TICK, (unsigned int) reading);
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS && log[4] <= log[2]){
+
+        ESP_LOGE("job_runner_test", "FAIL waiter resumed at %u, before the sensor finished at %u", (unsigned int) log[4],
+            (unsigned int) log[2]);
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test", "PASS woke %u, read %u, notified %u with %u, waiter resumed %u", (unsigned int) log[0],
+            (unsigned int) log[1], (unsigned int) log[2], (unsigned int) log[3], (unsigned int) log[4]);
+
+    }
+
+    if(runner != NULL){
+        job_runner_test_coro_finish(runner, &finished);
+    }
+
+    return err;
+
+}
+
+static jrerr_t job_runner_test_coro_full_queue(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_info info = {};
+    uint32_t log[5] = {0};
+    int16_t plain = -1;
+    int16_t filler = -1;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+
+    err = job_runner_create(&runner, 1);
+
+    jr::co_runner<1024, 2> coroutines(runner);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, (void*) job_runner_test_coro_plain, 1000, &plain);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(runner, &info, NULL, 0, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = coroutines.spawn(&filler, job_runner_test_coro_filler, plain, (int) info.queue_size);
+    }
+
+    if(err == JR_SUCCESS){
+        err = coroutines.spawn(NULL, job_runner_test_coro_waiter, filler, log);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && log[4] == 0){
+
+        ESP_LOGE("job_runner_test", "FAIL waiter never resumed after the filler finished");
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test", "PASS waiter resumed at %u with the queue full", (unsigned int) log[4]);
+
+    }
+
+    if(runner != NULL){
+        job_runner_test_coro_finish(runner, &finished);
+    }
+
+    return err;
+
+}
+
+void job_runner_test_coro(){
+
+    ESP_LOGI("job_runner_test","Job Runner Coroutine Test, %d ticks per run.", CORO_TICKS);
+
+    uint32_t callback_runs = 0;
+    uint32_t coroutine_runs = 0;
+
+    if(job_runner_test_coro_protocol() != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Protocol run failed");
+    }
+
+    if(job_runner_test_coro_full_queue() != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Full queue run failed");
+    }
+
+    if(job_runner_test_coro_bench(false, &callback_runs) == JR_SUCCESS && job_runner_test_coro_bench(true, &coroutine_runs) == JR_SUCCESS){
+
+        // Same period, same ticks: the await must not lose or add runs
+        if(coroutine_runs != callback_runs){
+            ESP_LOGE("job_runner_test", "FAIL coroutine ran %u times, the callback %u", (unsigned int) coroutine_runs, (unsigned int) callback_runs);
+        }
+        else{
+            ESP_LOGI("job_runner_test", "PASS coroutine and callback both ran %u times", (unsigned int) coroutine_runs);
+        }
+
+    }
+    else{
+        ESP_LOGE("job_runner_test", "Bench run failed");
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+
+#endif //JOB_RUNNER_TEST_CORO
+#endif // JOB_RUNNER_TESTING_ENABLE
@@ -0,0 +1,167 @@
+#include "job_runner_tests.h"
+
+#ifdef JOB_RUNNER_TESTING_ENABLE
+#ifdef JOB_RUNNER_TEST_CPP
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_system.h"
+
+#include "job_runner.h"
+#include "job_runner.hpp"
+
+#include <memory>
+
+#define CPP_TICKS 100
+
+struct cpp_reading {
+
+    uint32_t value;
+    static uint32_t deleted;
+
+    ~cpp_reading(){
+        deleted++;
+    }
+
+};
+
+uint32_t cpp_reading::deleted = 0;
+
+static uint32_t cpp_blinks = 0;
+static uint32_t cpp_polls = 0;
+static uint32_t cpp_value = 0;
+
+static job_runner_state_t job_runner_test_cpp_blink(job_runner_state_t state, void*){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    cpp_blinks++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static job_runner_state_t job_runner_test_cpp_poll(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data != NULL){
+        cpp_value = static_cast<cpp_reading*>(data)->value;
+    }
+
+    cpp_polls++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// Checked while compiling, a bad row here would fail the build
+static constexpr auto cpp_table = jr::make_table(
+    jr::periodic(&job_runner_test_cpp_blink, 10),
+    jr::periodic(&job_runner_test_cpp_poll, 20, 5, 1, 0, 2000)
+);
+
+static jrerr_t job_runner_test_cpp_expect(const char* name, uint32_t value, uint32_t expected){
+
+    if(value != expected){
+        ESP_LOGE("job_runner_test", "FAIL %s: %u, expected %u", name, (unsigned int) value, (unsigned int) expected);
+        return JR_FAIL;
+    }
+
+    ESP_LOGI("job_runner_test", "PASS %s: %u", name, (unsigned int) value);
+
+    return JR_SUCCESS;
+
+}
+
+void job_runner_test_cpp(){
+
+    ESP_LOGI("job_runner_test","Job Runner C++ Front End Test, %d ticks.", CPP_TICKS);
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    uint32_t counted = 0;
+    int16_t first_id = -1;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+
+    jr::runner<4, 32> runner;
+
+    err = runner.create(1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner.get(), &clock);
+    }
+
+    // Captures a reference, so it takes a slot
+    if(err == JR_SUCCESS){
+
+        err = runner.add_job([&counted](job_runner_state_t state, void*){
+            if(state == JOB_RUNNER_SHUT_DOWN){
+                return JOB_RUNNER_IM_DONE;
+            }
+            counted++;
+            return JOB_RUNNER_KEEP_ALIVE;
+        }, 5);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = runner.add_jobs<cpp_table>(&first_id);
+    }
+
+    if(err == JR_SUCCESS){
+
+        std::unique_ptr<cpp_reading> reading(new cpp_reading{ 42 });
+        err = runner.notify(first_id + 1, std::move(reading));
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner.get(), CPP_TICKS, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = runner.shutdown();
+    }
+
+    while(err == JR_SUCCESS && ! finished){
+        err = job_runner_simulate(runner.get(), 1000, &finished);
+    }
+
+    // add_job runs first one period in, a table row at its phase. The window ends before tick CPP_TICKS.
+    if(err == JR_SUCCESS){
+        err = job_runner_test_cpp_expect("lambda runs", counted, CPP_TICKS / 5 - 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_cpp_expect("table runs", cpp_blinks, CPP_TICKS / 10);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_cpp_expect("notified value", cpp_value, 42);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_cpp_expect("notifications deleted", cpp_reading::deleted, 1);
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+
+#endif //JOB_RUNNER_TEST_CPP
+#endif // JOB_RUNNER_TESTING_ENABLE
\ No newline at end of file
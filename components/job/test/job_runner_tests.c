@@ -593,4 +593,4446 @@ void job_runner_test_notifications(){
 }
 #endif //JOB_RUNNER_TEST_NOTIFICATIONS
 
+#ifdef JOB_RUNNER_TEST_BALANCER
+#include "rom/ets_sys.h"
+
+job_runner_state_t job_runner_test_heavy_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    // Burn 20 milliseconds of cpu
+    ets_delay_us(20000);
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+job_runner_state_t job_runner_test_light_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    ets_delay_us(1000);
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static volatile uint32_t rollback_runs[2];
+
+job_runner_state_t job_runner_test_rollback_job0(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    rollback_runs[0]++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+job_runner_state_t job_runner_test_rollback_job1(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    rollback_runs[1]++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// The second runner is started behind the balancer's back, so execute fails after the first one is up. The first
+// runner must not run a job and has to start normally afterwards.
+static jrerr_t job_runner_test_balancer_rollback(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runners[2] = { NULL, NULL };
+    struct job_runner_balancer* balancer = NULL;
+
+    rollback_runs[0] = 0;
+    rollback_runs[1] = 0;
+
+    err = job_runner_create(&runners[0], 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_create(&runners[1], 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_create(&balancer, runners, 2, 20, 1000 / portTICK_PERIOD_MS);
+    }
+
+    // Placement is by job count, one job lands on each runner
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_add_job(balancer, job_runner_test_rollback_job0, 1, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_add_job(balancer, job_runner_test_rollback_job1, 1, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runners[1], "test_rb1", 4096, 5);
+    }
+
+    if(err == JR_SUCCESS){
+
+        jrerr_t exerr = job_runner_balancer_execute(balancer, "test_rb", 4096, 5);
+
+        if(exerr != JR_ALREADY_STARTED){
+            ESP_LOGE("job_runner_test", "FAIL rollback: execute returned %d, expected %d", (int) exerr, (int) JR_ALREADY_STARTED);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+
+        if(rollback_runs[0] != 0 || rollback_runs[1] == 0){
+            ESP_LOGE("job_runner_test", "FAIL rollback: stopped runner ran %u times, running one %u times", (unsigned int) rollback_runs[0], (unsigned int) rollback_runs[1]);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_execute(runners[0], "test_rb0", 4096, 5);
+
+        if(err == JR_SUCCESS){
+
+            vTaskDelay(100 / portTICK_PERIOD_MS);
+
+            if(rollback_runs[0] == 0){
+                ESP_LOGE("job_runner_test", "FAIL rollback: runner did not run once started again");
+                err = JR_FAIL;
+            }
+
+        }
+        else {
+            ESP_LOGE("job_runner_test", "FAIL rollback: runner could not be started again, code %d", (int) err);
+        }
+
+    }
+
+    if(balancer != NULL){
+        job_runner_balancer_destroy(balancer);
+    }
+
+    for(int i = 0; i < 2; i++){
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+
+        if(runners[i] != NULL && job_runner_shutdown_async(runners[i], &hnd) == JR_SUCCESS){
+            job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS rollback: no job ran on the runner stopped again, it started fine later");
+    }
+
+    return err;
+
+}
+
+static uint32_t migrate_runs[2];
+
+static job_runner_state_t job_runner_test_migrate_job(job_runner_state_t state, void* data, void* context){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    (*(uint32_t*) context)++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static jrerr_t job_runner_test_migrate_count(struct job_runner* runner, uint16_t* count){
+
+    struct job_runner_info info;
+
+    jrerr_t err = job_runner_inspect(runner, &info, NULL, 0, NULL);
+    *count = info.num_jobs + info.num_paused;
+
+    return err;
+
+}
+
+// Two simulated runners, the move is acted on by the source and the job is adopted by the target on their next ticks
+static jrerr_t job_runner_test_balancer_migrate(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runners[2] = { NULL, NULL };
+    struct job_runner_virtual_clock vclocks[2];
+    struct job_runner_clock clocks[2];
+    int16_t moved = -1;
+    int16_t kept = -1;
+    uint16_t counts[2] = { 0, 0 };
+    uint32_t runs = 0;
+    int8_t finished = 0;
+
+    migrate_runs[0] = 0;
+    migrate_runs[1] = 0;
+
+    for(int i = 0; err == JR_SUCCESS && i < 2; i++){
+
+        job_runner_virtual_clock_init(&vclocks[i], &clocks[i], 0);
+        err = job_runner_create(&runners[i], 1);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_set_clock(runners[i], &clocks[i]);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runners[0], job_runner_test_migrate_job, &migrate_runs[0], 1, &kept);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runners[0], job_runner_test_migrate_job, &migrate_runs[1], 1, &moved);
+    }
+
+    // The target needs a job of its own or it ends on its first tick
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runners[1], job_runner_test_migrate_job, &runs, 100, NULL);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < 2; i++){
+        err = job_runner_simulate(runners[i], 5, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_migrate_job(runners[0], moved, runners[1]);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < 2; i++){
+        err = job_runner_simulate(runners[i], 5, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+
+        runs = migrate_runs[1];
+        err = job_runner_simulate(runners[1], 5, &finished);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_migrate_count(runners[0], &counts[0]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_migrate_count(runners[1], &counts[1]);
+    }
+
+    if(err == JR_SUCCESS && (counts[0] != 1 || counts[1] != 2 || migrate_runs[1] == runs)){
+        ESP_LOGE("job_runner_test", "FAIL migrate: source has %u jobs, target %u, the moved job ran %u times on the target",
+            (unsigned int) counts[0], (unsigned int) counts[1], (unsigned int) (migrate_runs[1] - runs));
+        err = JR_FAIL;
+    }
+
+    // The last job of a runner is never handed away, a runner without jobs would end
+    if(err == JR_SUCCESS){
+        err = job_runner_migrate_job(runners[0], kept, runners[1]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runners[0], 5, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_migrate_count(runners[0], &counts[0]);
+    }
+
+    if(err == JR_SUCCESS && (finished || counts[0] != 1)){
+        ESP_LOGE("job_runner_test", "FAIL migrate: the last job left its runner");
+        err = JR_FAIL;
+    }
+
+    for(int i = 0; i < 2; i++){
+
+        finished = 0;
+
+        if(runners[i] != NULL && job_runner_shutdown(runners[i]) == JR_SUCCESS){
+
+            while( ! finished && job_runner_simulate(runners[i], 1, &finished) == JR_SUCCESS ){
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS migrate: the job moved and runs on the target, a runner keeps its last job");
+    }
+
+    return err;
+
+}
+
+static volatile uint32_t gone_runs = 0;
+
+job_runner_state_t job_runner_test_gone_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN || ++gone_runs >= 5){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// A runner whose last job ends frees itself under a running balancer, which has to let go of it
+static jrerr_t job_runner_test_balancer_gone(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runners[2] = { NULL, NULL };
+    struct job_runner_balancer* balancer = NULL;
+    job_runner_shutdown_response_handle_t hnd = NULL;
+    uint8_t load = 0xff;
+
+    gone_runs = 0;
+
+    err = job_runner_create(&runners[0], 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_create(&runners[1], 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_create(&balancer, runners, 2, 0, 1);
+    }
+
+    // Placement is by job count, the ending job lands on the second runner
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_add_job(balancer, job_runner_test_light_job, 1, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_add_job(balancer, job_runner_test_gone_job, 1, NULL);
+    }
+
+    // Once the second runner is freed the balancer keeps running every tick for a while
+    if(err == JR_SUCCESS){
+
+        err = job_runner_balancer_execute(balancer, "test_gone", 4096, 5);
+        vTaskDelay(500 / portTICK_PERIOD_MS);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_balancer_get_utilization(balancer, 1, &load);
+    }
+
+    if(err == JR_SUCCESS && (gone_runs < 5 || load != 0)){
+        ESP_LOGE("job_runner_test", "FAIL gone: the ending job ran %u times, its runner still reads %u%%", (unsigned int) gone_runs, (unsigned int) load);
+        err = JR_FAIL;
+    }
+
+    if(balancer != NULL){
+        job_runner_balancer_destroy(balancer);
+    }
+
+    if(runners[0] != NULL && job_runner_shutdown_async(runners[0], &hnd) == JR_SUCCESS){
+        job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS gone: the balancer let go of the runner that freed itself");
+    }
+
+    return err;
+
+}
+
+void job_runner_test_balancer(){
+
+    ESP_LOGI("job_runner_test","Job Runner Balancer Test.");
+
+    jrerr_t err = job_runner_test_balancer_rollback();
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_balancer_migrate();
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_balancer_gone();
+    }
+
+    struct job_runner* runners[2] = { NULL, NULL };
+    struct job_runner_balancer* balancer = NULL;
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_create(&runners[0], 1);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_create(&runners[1], 1);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_balancer_create(&balancer, runners, 2, 20, 1000 / portTICK_PERIOD_MS);
+
+    }
+
+    // Jobs are placed round robin, so every heavy job initially lands on the first runner
+    for(int i = 0; err == JR_SUCCESS && i < 8; i++){
+
+        void* job = (i % 2 == 0) ? (void*) job_runner_test_heavy_job : (void*) job_runner_test_light_job;
+        err = job_runner_balancer_add_job(balancer, job, 100 / portTICK_PERIOD_MS, NULL);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test","All Jobs Added, Starting Runners...");
+
+        err = job_runner_balancer_execute(balancer, "test_run", 4096, 5);
+
+    }
+
+    for(int second = 0; err == JR_SUCCESS && second < 30; second++){
+
+        uint8_t load[2] = { 0, 0 };
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+
+        job_runner_balancer_get_utilization(balancer, 0, &load[0]);
+        job_runner_balancer_get_utilization(balancer, 1, &load[1]);
+
+        ESP_LOGI("job_runner_test","t=%ds runner 0: %d%% runner 1: %d%%", second + 1, (int) load[0], (int) load[1]);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_balancer_destroy(balancer);
+
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < 2; i++){
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+
+        err = job_runner_shutdown_async(runners[i], &hnd);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Balancer test failed code: %d", (int) err);
+    }
+    else {
+        ESP_LOGI("job_runner_test", "Balancer test done!!!");
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_BALANCER
+
+#ifdef JOB_RUNNER_TEST_ADAPTIVE_DELAY
+#include "esp_timer.h"
+
+static int64_t adaptive_latency_total = 0;
+static int64_t adaptive_latency_max = 0;
+static uint32_t adaptive_latency_count = 0;
+
+job_runner_state_t job_runner_test_latency_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data){
+
+        // The payload is the time the notification was sent
+        int64_t latency = esp_timer_get_time() - *((int64_t*) data);
+
+        adaptive_latency_total += latency;
+        adaptive_latency_count++;
+
+        if(latency > adaptive_latency_max){
+            adaptive_latency_max = latency;
+        }
+
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+job_runner_state_t job_runner_test_tick_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void delete_timestamp(void* timestamp){
+    free(timestamp);
+}
+
+// profile 0 is idle, 1 is a steady notification every 20 ms, 2 is a burst of 5 notifications every second
+static void job_runner_test_adaptive_profile(int profile, uint32_t fixed_delay, uint32_t floor, uint32_t ceiling){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_loop_stats stats = {0};
+    int16_t latency_job = 0;
+
+    adaptive_latency_total = 0;
+    adaptive_latency_max = 0;
+    adaptive_latency_count = 0;
+
+    err = job_runner_create(&runner, fixed_delay);
+
+    if(err == JR_SUCCESS && ceiling > 0){
+
+        err = job_runner_set_adaptive_delay(runner, floor, ceiling);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_add_job(runner, job_runner_test_latency_job, 60000 / portTICK_PERIOD_MS, &latency_job);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_add_job(runner, job_runner_test_tick_job, 100 / portTICK_PERIOD_MS, NULL);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+
+    }
+
+    for(int ms = 0; err == JR_SUCCESS && ms < 5000; ms += 20){
+
+        int burst = 0;
+
+        if(profile == 1){
+            burst = 1;
+        }
+        else if(profile == 2 && ms % 1000 == 0){
+            burst = 5;
+        }
+
+        for(int i = 0; i < burst; i++){
+
+            int64_t* timestamp = malloc(sizeof(int64_t));
+            *timestamp = esp_timer_get_time();
+
+            if(job_runner_notify_job(runner, latency_job, timestamp, &delete_timestamp) != JR_SUCCESS){
+                free(timestamp);
+            }
+
+        }
+
+        vTaskDelay(20 / portTICK_PERIOD_MS);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        job_runner_get_loop_stats(runner, &stats);
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+        err = job_runner_shutdown_async(runner, &hnd);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    const char* names[] = { "idle", "steady", "bursty" };
+
+    ESP_LOGI("job_runner_test", "%-6s %s %2u-%-3u wakeups/s: %4u latency avg: %6d us max: %6d us", names[profile], (ceiling > 0) ? "adaptive" : "fixed   ",
+        (unsigned int) ((ceiling > 0) ? floor : fixed_delay), (unsigned int) ((ceiling > 0) ? ceiling : fixed_delay), (unsigned int) (stats.wakeups / 5),
+        (int) (adaptive_latency_count ? adaptive_latency_total / adaptive_latency_count : 0), (int) adaptive_latency_max);
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Profile failed code: %d", (int) err);
+    }
+
+}
+
+#define ADAPTIVE_IDLE_CEILING 50
+#define ADAPTIVE_IDLE_WINDOW 1000
+
+// Simulated so the count does not depend on the scheduler: with nothing due and nothing sent, a runner that backed off
+// to its ceiling wakes exactly once per ceiling
+static jrerr_t job_runner_test_adaptive_idle_window(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_loop_stats before = {0};
+    struct job_runner_loop_stats after = {0};
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_adaptive_delay(runner, 1, ADAPTIVE_IDLE_CEILING);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_tick_job, 0x10000000, NULL);
+    }
+
+    // Long enough to back off all the way to the ceiling
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, ADAPTIVE_IDLE_WINDOW, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_loop_stats(runner, &before);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, ADAPTIVE_IDLE_WINDOW, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_loop_stats(runner, &after);
+    }
+
+    if(err == JR_SUCCESS && after.wakeups - before.wakeups != ADAPTIVE_IDLE_WINDOW / ADAPTIVE_IDLE_CEILING){
+        ESP_LOGE("job_runner_test", "FAIL idle: %u wakeups in %d ticks, expected %d", (unsigned int) (after.wakeups - before.wakeups),
+            ADAPTIVE_IDLE_WINDOW, ADAPTIVE_IDLE_WINDOW / ADAPTIVE_IDLE_CEILING);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL){
+
+        job_runner_shutdown(runner);
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS idle: %u wakeups in %d ticks", (unsigned int) (after.wakeups - before.wakeups), ADAPTIVE_IDLE_WINDOW);
+    }
+
+    return err;
+
+}
+
+void job_runner_test_adaptive_delay(){
+
+    ESP_LOGI("job_runner_test","Job Runner Adaptive Delay Benchmark.");
+
+    job_runner_test_adaptive_idle_window();
+
+    for(int profile = 0; profile < 3; profile++){
+
+        job_runner_test_adaptive_profile(profile, 1, 0, 0);
+        job_runner_test_adaptive_profile(profile, 10, 0, 0);
+        job_runner_test_adaptive_profile(profile, 0, 1, 50);
+
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_ADAPTIVE_DELAY
+
+#ifdef JOB_RUNNER_TEST_SIMULATION
+#include "esp_timer.h"
+
+#define SIM_JOBS 8
+#define SIM_DAY_TICKS (24 * 3600 * configTICK_RATE_HZ)
+
+struct sim_job_stats {
+
+    uint32_t period;
+    uint32_t phase;
+    uint32_t run_limit;         // Runs before the job is done, 0 to run until shutdown
+    uint32_t runs;
+    uint32_t notified;
+    uint32_t expected;
+    uint32_t max_lateness;
+    uint64_t total_lateness;
+
+};
+
+static struct job_runner_virtual_clock sim_clock;
+static struct sim_job_stats sim_jobs[SIM_JOBS];
+static int16_t sim_shutdown_order[SIM_JOBS];
+static uint8_t sim_num_shutdown = 0;
+static uint32_t sim_seed = 0;
+
+static uint32_t sim_rand(){
+
+    // xorshift32, the whole workload comes from the seed
+    sim_seed ^= sim_seed << 13;
+    sim_seed ^= sim_seed >> 17;
+    sim_seed ^= sim_seed << 5;
+
+    return sim_seed;
+
+}
+
+static job_runner_state_t sim_job_run(int index, job_runner_state_t state, void* data){
+
+    struct sim_job_stats* stats = &sim_jobs[index];
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        sim_shutdown_order[sim_num_shutdown++] = index;
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data != NULL){
+
+        // Notified runs are early by design, they do not count towards lateness
+        stats->notified++;
+
+    }
+    else {
+
+        uint32_t lateness = sim_clock.now - stats->expected;
+
+        stats->total_lateness += lateness;
+        if(lateness > stats->max_lateness){
+            stats->max_lateness = lateness;
+        }
+
+    }
+
+    stats->runs++;
+    stats->expected = sim_clock.now + stats->period;
+
+    if(stats->run_limit > 0 && stats->runs >= stats->run_limit){
+        sim_shutdown_order[sim_num_shutdown++] = index;
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+#define SIM_JOB(n) job_runner_state_t job_runner_test_sim_job##n(job_runner_state_t state, void* data){ return sim_job_run(n, state, data); }
+
+SIM_JOB(0) SIM_JOB(1) SIM_JOB(2) SIM_JOB(3) SIM_JOB(4) SIM_JOB(5) SIM_JOB(6) SIM_JOB(7)
+
+static void* const sim_callbacks[SIM_JOBS] = {
+    job_runner_test_sim_job0, job_runner_test_sim_job1, job_runner_test_sim_job2, job_runner_test_sim_job3,
+    job_runner_test_sim_job4, job_runner_test_sim_job5, job_runner_test_sim_job6, job_runner_test_sim_job7
+};
+
+static uint32_t sim_marker = 0;
+
+static uint32_t job_runner_test_simulate_day(uint32_t seed){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_clock clock;
+    struct job_runner_job_desc table[SIM_JOBS];
+    int16_t first_id = 0;
+    int8_t finished = 0;
+
+    sim_seed = seed;
+    sim_num_shutdown = 0;
+    memset(sim_jobs, 0, sizeof(sim_jobs));
+
+    job_runner_virtual_clock_init(&sim_clock, &clock, 0);
+
+    for(int i = 0; i < SIM_JOBS; i++){
+
+        sim_jobs[i].period = 1 + sim_rand() % 200;
+        sim_jobs[i].phase = sim_rand() % sim_jobs[i].period;
+        sim_jobs[i].run_limit = (sim_rand() % 4 == 0) ? 1000 + sim_rand() % 100000 : 0;
+        sim_jobs[i].expected = sim_jobs[i].phase;
+
+        table[i] = (struct job_runner_job_desc) { .job_callback = sim_callbacks[i], .repeat_delay = sim_jobs[i].period, .phase = sim_jobs[i].phase, .priority = 0, .flags = 0 };
+
+    }
+
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+
+        // The clock has to be in place before the table so phases start from virtual time
+        err = job_runner_set_clock(runner, &clock);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_add_jobs(runner, table, SIM_JOBS, &first_id);
+
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    while(err == JR_SUCCESS && ! finished && sim_clock.now < SIM_DAY_TICKS){
+
+        // Bursts of simulated time with a random notification in between
+        err = job_runner_simulate(runner, 1 + sim_rand() % 10000, &finished);
+
+        if(err == JR_SUCCESS && ! finished){
+
+            int index = sim_rand() % SIM_JOBS;
+
+            if(sim_jobs[index].run_limit == 0 || sim_jobs[index].runs < sim_jobs[index].run_limit){
+                job_runner_notify_job(runner, first_id + index, &sim_marker, NULL);
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && ! finished){
+
+        err = job_runner_shutdown(runner);
+
+    }
+
+    while(err == JR_SUCCESS && ! finished){
+
+        err = job_runner_simulate(runner, 1000, &finished);
+
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Simulation failed code: %d", (int) err);
+    }
+
+    // Everything the run produced folds into one digest, equal seeds must give equal digests
+    uint32_t digest = 2166136261u;
+
+    for(int i = 0; i < SIM_JOBS; i++){
+
+        ESP_LOGI("job_runner_test", "job %d period %4u runs %7u notified %4u lateness avg %u max %u", i, (unsigned int) sim_jobs[i].period,
+            (unsigned int) sim_jobs[i].runs, (unsigned int) sim_jobs[i].notified,
+            (unsigned int) ((sim_jobs[i].runs > sim_jobs[i].notified) ? sim_jobs[i].total_lateness / (sim_jobs[i].runs - sim_jobs[i].notified) : 0),
+            (unsigned int) sim_jobs[i].max_lateness);
+
+        digest = (digest ^ sim_jobs[i].runs) * 16777619u;
+        digest = (digest ^ sim_jobs[i].max_lateness) * 16777619u;
+        digest = (digest ^ (uint32_t) sim_jobs[i].total_lateness) * 16777619u;
+
+    }
+
+    for(int i = 0; i < sim_num_shutdown; i++){
+        digest = (digest ^ sim_shutdown_order[i]) * 16777619u;
+    }
+
+    ESP_LOGI("job_runner_test", "Simulated %u ticks in %d ms, %d jobs finished, digest %08x", (unsigned int) sim_clock.now, (int) (elapsed_us / 1000),
+        (int) sim_num_shutdown, (unsigned int) digest);
+
+    return digest;
+
+}
+
+#define SCHED_PERIOD 20
+#define SCHED_TICKS 200
+#define SCHED_RUNS (SCHED_TICKS / SCHED_PERIOD)
+
+static struct job_runner* sched_runner = NULL;
+static int16_t sched_target = -1;
+static uint32_t sched_ticks[2][SCHED_RUNS + 1];
+static uint32_t sched_runs[2];
+static uint32_t sched_notified = 0;
+static uint32_t sched_refused = 0;
+static uint16_t sched_queue_size = 0;
+
+static job_runner_state_t sched_record(int index, job_runner_state_t state){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(sched_runs[index] <= SCHED_RUNS){
+        sched_ticks[index][sched_runs[index]] = sim_clock.now;
+    }
+
+    sched_runs[index]++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+job_runner_state_t job_runner_test_sched_steady(job_runner_state_t state, void* data){
+
+    return sched_record(0, state);
+
+}
+
+// Sends twice what the queue holds, a full queue has to refuse right away instead of waiting on the runner it runs on
+job_runner_state_t job_runner_test_sched_flood(job_runner_state_t state, void* data){
+
+    if(state != JOB_RUNNER_SHUT_DOWN){
+
+        for(int i = 0; i < 2 * sched_queue_size; i++){
+
+            if(job_runner_notify_job(sched_runner, sched_target, &sim_marker, NULL) == JR_QUEUE_FULL){
+                sched_refused++;
+            }
+
+        }
+
+    }
+
+    return sched_record(1, state);
+
+}
+
+job_runner_state_t job_runner_test_sched_target(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data != NULL){
+        sched_notified++;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// Two jobs on the same period half a period apart never meet, each has to run exactly on its phase
+static jrerr_t job_runner_test_simulate_schedule(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_clock clock;
+    struct job_runner_info info;
+    struct job_runner_job_desc table[3] = {
+        { .job_callback = job_runner_test_sched_steady, .repeat_delay = SCHED_PERIOD, .phase = 0, .priority = 0, .flags = 0 },
+        { .job_callback = job_runner_test_sched_flood, .repeat_delay = SCHED_PERIOD, .phase = SCHED_PERIOD / 2, .priority = 0, .flags = 0 },
+        { .job_callback = job_runner_test_sched_target, .repeat_delay = 0x10000000, .phase = 0x10000000, .priority = 0, .flags = 0 },
+    };
+    int16_t first_id = 0;
+    uint16_t num_filled = 0;
+    int8_t finished = 0;
+
+    memset(sched_ticks, 0, sizeof(sched_ticks));
+    memset(sched_runs, 0, sizeof(sched_runs));
+    sched_notified = 0;
+    sched_refused = 0;
+
+    job_runner_virtual_clock_init(&sim_clock, &clock, 0);
+    err = job_runner_create(&sched_runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(sched_runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_jobs(sched_runner, table, 3, &first_id);
+    }
+
+    if(err == JR_SUCCESS){
+
+        sched_target = first_id + 2;
+        err = job_runner_inspect(sched_runner, &info, NULL, 0, &num_filled);
+        sched_queue_size = info.queue_size;
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(sched_runner, SCHED_TICKS, &finished);
+    }
+
+    for(int index = 0; err == JR_SUCCESS && index < 2; index++){
+
+        for(uint32_t run = 0; run < sched_runs[index] && run <= SCHED_RUNS; run++){
+
+            uint32_t expected = table[index].phase + run * SCHED_PERIOD;
+
+            if(sched_ticks[index][run] != expected){
+                ESP_LOGE("job_runner_test", "FAIL job %d run %u at tick %u, expected %u", index, (unsigned int) run, (unsigned int) sched_ticks[index][run], (unsigned int) expected);
+                err = JR_FAIL;
+                break;
+            }
+
+        }
+
+        if(err == JR_SUCCESS && sched_runs[index] != SCHED_RUNS){
+            ESP_LOGE("job_runner_test", "FAIL job %d ran %u times, expected %d", index, (unsigned int) sched_runs[index], SCHED_RUNS);
+            err = JR_FAIL;
+        }
+
+    }
+
+    // Each flood fits a queue's worth and is refused the rest. Notifications the runner takes before the job ran fold into
+    // one run, every flood still gets the job running.
+    if(err == JR_SUCCESS && (sched_refused != SCHED_RUNS * sched_queue_size || sched_notified < SCHED_RUNS)){
+        ESP_LOGE("job_runner_test", "FAIL %u notifications refused, expected %u, and %u delivered", (unsigned int) sched_refused,
+            (unsigned int) (SCHED_RUNS * sched_queue_size), (unsigned int) sched_notified);
+        err = JR_FAIL;
+    }
+
+    if(sched_runner != NULL){
+
+        job_runner_shutdown(sched_runner);
+
+        while( ! finished && job_runner_simulate(sched_runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS every run on its tick, full queue refused from the runner");
+    }
+
+    return err;
+
+}
+
+void job_runner_test_simulation(){
+
+    ESP_LOGI("job_runner_test","Job Runner Simulation Test.");
+
+    uint32_t first = job_runner_test_simulate_day(0x1234abcd);
+    uint32_t second = job_runner_test_simulate_day(0x1234abcd);
+
+    if(first == second){
+        ESP_LOGI("job_runner_test", "PASS, same seed gave the same schedule");
+    }
+    else {
+        ESP_LOGE("job_runner_test", "FAIL, same seed gave different schedules");
+    }
+
+    job_runner_test_simulate_schedule();
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_SIMULATION
+
+#ifdef JOB_RUNNER_TEST_INLINE_NOTIFY
+#include "esp_timer.h"
+
+#define INLINE_NOTIFY_COUNT 10000
+
+struct inline_event {
+
+    uint32_t code;
+    int64_t timestamp;
+
+};
+
+static uint32_t inline_event_allocs = 0;
+static uint32_t inline_event_frees = 0;
+static uint32_t inline_event_seen = 0;
+
+job_runner_state_t job_runner_test_event_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data){
+
+        struct inline_event* event = (struct inline_event*) data;
+        inline_event_seen += (event->code != 0);
+
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void delete_event(void* event){
+    inline_event_frees++;
+    free(event);
+}
+
+static void job_runner_test_inline_run(int use_inline){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_loop_stats stats = {0};
+    int16_t event_job = 0;
+
+    inline_event_allocs = 0;
+    inline_event_frees = 0;
+    inline_event_seen = 0;
+
+    err = job_runner_create(&runner, 0);
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_add_job(runner, job_runner_test_event_job, 60000 / portTICK_PERIOD_MS, &event_job);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+
+    }
+
+    uint32_t heap_before = esp_get_free_heap_size();
+    uint32_t heap_low = heap_before;
+    int64_t start_us = esp_timer_get_time();
+
+    for(int i = 0; err == JR_SUCCESS && i < INLINE_NOTIFY_COUNT; i++){
+
+        struct inline_event event = { .code = i + 1, .timestamp = esp_timer_get_time() };
+
+        if(use_inline){
+
+            err = job_runner_notify_job_inline(runner, event_job, &event, sizeof(event));
+
+        }
+        else {
+
+            struct inline_event* copy = malloc(sizeof(struct inline_event));
+            *copy = event;
+            inline_event_allocs++;
+
+            err = job_runner_notify_job(runner, event_job, copy, &delete_event);
+
+        }
+
+        if((i & 0xff) == 0 && esp_get_free_heap_size() < heap_low){
+            heap_low = esp_get_free_heap_size();
+        }
+
+    }
+
+    // Done once the runner has taken every command off the queue
+    do {
+
+        job_runner_get_loop_stats(runner, &stats);
+        vTaskDelay(1);
+
+    } while(err == JR_SUCCESS && stats.commands < INLINE_NOTIFY_COUNT);
+
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    if(err == JR_SUCCESS){
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+        err = job_runner_shutdown_async(runner, &hnd);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    ESP_LOGI("job_runner_test", "%s: %d notifications/s, %u allocs %u frees, heap dipped %u bytes, %u delivered", use_inline ? "inline " : "pointer",
+        (int) (elapsed_us > 0 ? (int64_t) INLINE_NOTIFY_COUNT * 1000000 / elapsed_us : 0), (unsigned int) inline_event_allocs, (unsigned int) inline_event_frees,
+        (unsigned int) (heap_before - heap_low), (unsigned int) inline_event_seen);
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+
+}
+
+void job_runner_test_inline_notify(){
+
+    ESP_LOGI("job_runner_test","Job Runner Inline Notification Benchmark.");
+
+    job_runner_test_inline_run(0);
+    job_runner_test_inline_run(1);
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_INLINE_NOTIFY
+
+
+#ifdef JOB_RUNNER_TEST_SCAN
+#include "esp_timer.h"
+
+// The largest size needs several MB, boards without PSRAM skip it
+#ifndef SCAN_MAX_JOBS
+#define SCAN_MAX_JOBS 32000
+#endif
+
+#define SCAN_PASSES 200
+
+job_runner_state_t job_runner_test_idle_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static int64_t job_runner_test_scan_table(uint16_t count){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_loop_stats before = {0};
+    struct job_runner_loop_stats after = {0};
+    struct job_runner_job_desc* table = NULL;
+    int16_t first_id = 0;
+    int8_t finished = 0;
+    int64_t elapsed_us = -1;
+
+    table = malloc(count * sizeof(struct job_runner_job_desc));
+
+    if(table == NULL){
+        err = JR_MEMORY_ALLOC_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Nothing comes due during the run, every loop is one full scan of the table
+        for(uint16_t i = 0; i < count; i++){
+            table[i] = (struct job_runner_job_desc) { .job_callback = job_runner_test_idle_job, .repeat_delay = 0x10000000, .phase = 0x10000000, .priority = 0, .flags = 0 };
+        }
+
+        job_runner_virtual_clock_init(&vclock, &clock, 0);
+        err = job_runner_create(&runner, 1);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_jobs(runner, table, count, &first_id);
+    }
+
+    // Jobs keep the callback and nothing else of their descriptor, the table is not needed past the call
+    if(table != NULL){
+        free(table);
+        table = NULL;
+    }
+
+    if(err == JR_SUCCESS){
+
+        // The first loop builds the hot table, keep it out of the measurement
+        err = job_runner_simulate(runner, 1, &finished);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_loop_stats(runner, &before);
+    }
+
+    if(err == JR_SUCCESS){
+
+        int64_t start_us = esp_timer_get_time();
+
+        err = job_runner_simulate(runner, SCAN_PASSES, &finished);
+
+        elapsed_us = esp_timer_get_time() - start_us;
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_loop_stats(runner, &after);
+    }
+
+    if(err == JR_SUCCESS && after.wakeups - before.wakeups != SCAN_PASSES){
+        ESP_LOGE("job_runner_test", "Table scan ran %u loops, expected %d", (unsigned int) (after.wakeups - before.wakeups), SCAN_PASSES);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL){
+
+        // Every job says done on shutdown, the runner frees itself once it runs out
+        job_runner_shutdown(runner);
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(table != NULL){
+        free(table);
+    }
+
+    return (err == JR_SUCCESS) ? elapsed_us : -1;
+
+}
+
+#define CHURN_JOBS 16
+#define CHURN_PERIOD 50
+#define CHURN_TICKS 1000
+#define CHURN_DONE_AFTER 3
+#define CHURN_PAUSE_AT 300
+#define CHURN_RESUME_AT 500
+
+static uint32_t churn_runs[CHURN_JOBS];
+
+static job_runner_state_t job_runner_test_churn_job(job_runner_state_t state, void* data, void* context){
+
+    uint32_t* runs = (uint32_t*) context;
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    (*runs)++;
+
+    // Every fourth job leaves the table partway through a pass
+    if((runs - churn_runs) % 4 == 0 && *runs == CHURN_DONE_AFTER){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// Jobs finishing, pausing and resuming patch the hot table in place, the jobs around them have to keep their period.
+// A stale entry runs its job every loop, a lost one never runs again.
+static jrerr_t job_runner_test_scan_churn(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    int16_t ids[CHURN_JOBS];
+    int8_t finished = 0;
+
+    memset(churn_runs, 0, sizeof(churn_runs));
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < CHURN_JOBS; i++){
+        err = job_runner_add_job_with_context(runner, job_runner_test_churn_job, &churn_runs[i], CHURN_PERIOD, &ids[i]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, CHURN_PAUSE_AT, &finished);
+    }
+
+    // The job after each finishing one sits out for a while
+    for(int i = 1; err == JR_SUCCESS && i < CHURN_JOBS; i += 4){
+        err = job_runner_pause_job(runner, ids[i]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, CHURN_RESUME_AT - CHURN_PAUSE_AT, &finished);
+    }
+
+    for(int i = 1; err == JR_SUCCESS && i < CHURN_JOBS; i += 4){
+        err = job_runner_resume_job(runner, ids[i]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, CHURN_TICKS - CHURN_RESUME_AT, &finished);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < CHURN_JOBS; i++){
+
+        uint32_t expected = CHURN_TICKS / CHURN_PERIOD;
+        uint32_t slack = 2;
+
+        if(i % 4 == 0){
+            expected = CHURN_DONE_AFTER;
+            slack = 0;
+        }
+        else if(i % 4 == 1){
+            expected -= (CHURN_RESUME_AT - CHURN_PAUSE_AT) / CHURN_PERIOD;
+        }
+
+        // The end of the window and the resume can each cost or add a run
+        if(churn_runs[i] + slack < expected || churn_runs[i] > expected + slack){
+            ESP_LOGE("job_runner_test", "FAIL churn: job %d ran %u times, expected %u", i, (unsigned int) churn_runs[i], (unsigned int) expected);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(runner != NULL){
+
+        job_runner_shutdown(runner);
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS churn: every job kept its period through finishes, pauses and resumes");
+    }
+
+    return err;
+
+}
+
+void job_runner_test_scan(){
+
+    ESP_LOGI("job_runner_test","Job Runner Scan Benchmark.");
+
+    static const uint32_t sizes[] = { 1000, 10000, 32000 };
+
+    for(int i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++){
+
+        if(sizes[i] > SCAN_MAX_JOBS){
+            ESP_LOGI("job_runner_test", "%6u jobs: skipped, above SCAN_MAX_JOBS", (unsigned int) sizes[i]);
+            continue;
+        }
+
+        int64_t table_us = job_runner_test_scan_table(sizes[i]);
+
+        if(table_us < 0){
+            ESP_LOGE("job_runner_test", "FAIL %u jobs: table scan failed or ran the wrong number of loops", (unsigned int) sizes[i]);
+            continue;
+        }
+
+        ESP_LOGI("job_runner_test", "%6u jobs: %u us per pass over the table", (unsigned int) sizes[i], (unsigned int) (table_us / SCAN_PASSES));
+
+    }
+
+    job_runner_test_scan_churn();
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_SCAN
+
+#ifdef JOB_RUNNER_TEST_PUBSUB
+#include "esp_timer.h"
+
+#define PUBSUB_MESSAGES 500
+#define PUBSUB_MAX_SUBSCRIBERS 64
+
+static uint32_t pubsub_delivered = 0;
+static uint32_t pubsub_destroyed = 0;
+
+job_runner_state_t job_runner_test_subscriber_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data){
+        __atomic_add_fetch(&pubsub_delivered, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void delete_reading(void* reading){
+    __atomic_add_fetch(&pubsub_destroyed, 1, __ATOMIC_SEQ_CST);
+    free(reading);
+}
+
+#define PUBSUB_SHARED_SUBSCRIBERS 3
+
+static uint32_t* pubsub_seen[PUBSUB_SHARED_SUBSCRIBERS];
+static uint32_t pubsub_destroyed_before[PUBSUB_SHARED_SUBSCRIBERS];
+
+static job_runner_state_t job_runner_test_shared_subscriber(job_runner_state_t state, void* data, void* context){
+
+    int index = (int) (intptr_t) context;
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data){
+        pubsub_seen[index] = (uint32_t*) data;
+        pubsub_destroyed_before[index] = pubsub_destroyed;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// One payload, several subscribers: every one of them sees the same pointer and the destructor runs once, after the last
+static jrerr_t job_runner_test_pubsub_shared(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    int16_t ids[PUBSUB_SHARED_SUBSCRIBERS];
+    int16_t outsider = -1;
+    job_runner_topic_t topic = job_runner_topic("sensor/shared");
+    uint32_t* reading = NULL;
+    int8_t finished = 0;
+
+    pubsub_destroyed = 0;
+    memset(pubsub_seen, 0, sizeof(pubsub_seen));
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < PUBSUB_SHARED_SUBSCRIBERS; i++){
+
+        err = job_runner_add_job_with_context(runner, job_runner_test_shared_subscriber, (void*) (intptr_t) i, 60000 / portTICK_PERIOD_MS, &ids[i]);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_subscribe(runner, ids[i], topic);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_subscriber_job, 60000 / portTICK_PERIOD_MS, &outsider);
+    }
+
+    if(err == JR_SUCCESS && job_runner_unsubscribe(runner, outsider, topic) != JR_NOT_SUBSCRIBED){
+        ESP_LOGE("job_runner_test", "FAIL shared: unsubscribing a job that never subscribed did not return JR_NOT_SUBSCRIBED");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+
+        reading = malloc(sizeof(uint32_t));
+
+        if(reading == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+        else if((err = job_runner_publish(runner, topic, reading, &delete_reading)) != JR_SUCCESS){
+            free(reading);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < PUBSUB_SHARED_SUBSCRIBERS; i++){
+
+        if(pubsub_seen[i] != reading || pubsub_destroyed_before[i] != 0){
+            ESP_LOGE("job_runner_test", "FAIL shared: subscriber %d saw %p with %u destroyed, expected %p with none", i, (void*) pubsub_seen[i],
+                (unsigned int) pubsub_destroyed_before[i], (void*) reading);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && pubsub_destroyed != 1){
+        ESP_LOGE("job_runner_test", "FAIL shared: destructor ran %u times, expected once", (unsigned int) pubsub_destroyed);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL){
+
+        job_runner_shutdown(runner);
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS && pubsub_destroyed != 1){
+        ESP_LOGE("job_runner_test", "FAIL shared: destructor ran %u times by the end, expected once", (unsigned int) pubsub_destroyed);
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS shared: %d subscribers saw one payload, destroyed once after the last", PUBSUB_SHARED_SUBSCRIBERS);
+    }
+
+    return err;
+
+}
+
+// use_topic 0 sends every subscriber its own copy with job_runner_notify_job, the way fan-out was done before topics
+static void job_runner_test_pubsub_run(uint8_t subscribers, int use_topic){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    int16_t ids[PUBSUB_MAX_SUBSCRIBERS];
+    job_runner_topic_t topic = job_runner_topic("sensor/reading");
+    uint32_t payloads = 0;
+
+    pubsub_delivered = 0;
+    pubsub_destroyed = 0;
+
+    // No loop delay, the runner sleeps in the command queue and wakes for every publish
+    err = job_runner_create(&runner, 0);
+
+    for(uint8_t i = 0; err == JR_SUCCESS && i < subscribers; i++){
+
+        err = job_runner_add_job(runner, job_runner_test_subscriber_job, 60000 / portTICK_PERIOD_MS, &ids[i]);
+
+        if(err == JR_SUCCESS && use_topic){
+            err = job_runner_subscribe(runner, ids[i], topic);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    for(int m = 0; err == JR_SUCCESS && m < PUBSUB_MESSAGES; m++){
+
+        if(use_topic){
+
+            uint32_t* reading = malloc(sizeof(uint32_t));
+            *reading = m;
+
+            if(job_runner_publish(runner, topic, reading, &delete_reading) == JR_SUCCESS){
+                payloads++;
+            }
+            else {
+                free(reading);
+            }
+
+        }
+        else {
+
+            for(uint8_t i = 0; i < subscribers; i++){
+
+                uint32_t* reading = malloc(sizeof(uint32_t));
+                *reading = m;
+
+                if(job_runner_notify_job(runner, ids[i], reading, &delete_reading) == JR_SUCCESS){
+                    payloads++;
+                }
+                else {
+                    free(reading);
+                }
+
+            }
+
+        }
+
+    }
+
+    // Done once every payload is gone, the runner destroys a payload that was replaced before its job ran
+    for(int ms = 0; err == JR_SUCCESS && __atomic_load_n(&pubsub_destroyed, __ATOMIC_SEQ_CST) < payloads && ms < 10000; ms++){
+        vTaskDelay(1);
+    }
+
+    int64_t elapsed_us = esp_timer_get_time() - start_us;
+
+    if(err == JR_SUCCESS){
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+        err = job_runner_shutdown_async(runner, &hnd);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    // The runner is gone, every payload handed over went through its destructor exactly once
+    if(err == JR_SUCCESS && pubsub_destroyed != payloads){
+        ESP_LOGE("job_runner_test", "FAIL %u payloads handed over, %u destroyed", (unsigned int) payloads, (unsigned int) pubsub_destroyed);
+        err = JR_FAIL;
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+
+    ESP_LOGI("job_runner_test", "%2u subscribers %s: %6u msgs/s, %7u deliveries/s, %u of %u delivered", (unsigned int) subscribers, use_topic ? "publish" : "notify ",
+        (unsigned int) (elapsed_us > 0 ? PUBSUB_MESSAGES * 1000000LL / elapsed_us : 0), (unsigned int) (elapsed_us > 0 ? pubsub_delivered * 1000000LL / elapsed_us : 0),
+        (unsigned int) pubsub_delivered, (unsigned int) (PUBSUB_MESSAGES * subscribers));
+
+}
+
+void job_runner_test_pubsub(){
+
+    ESP_LOGI("job_runner_test","Job Runner Publish/Subscribe Benchmark.");
+
+    job_runner_test_pubsub_shared();
+
+    for(uint8_t subscribers = 1; subscribers <= PUBSUB_MAX_SUBSCRIBERS; subscribers *= 2){
+
+        job_runner_test_pubsub_run(subscribers, 1);
+        job_runner_test_pubsub_run(subscribers, 0);
+
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_PUBSUB
+
+#ifdef JOB_RUNNER_TEST_REPLAY
+#include "esp_timer.h"
+
+#define REPLAY_BUFFER_SIZE (16 * 1024)
+
+job_runner_state_t job_runner_test_sensor_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    // Some work per run so the recording has callback times worth replaying
+    int64_t until = esp_timer_get_time() + (data ? 300 : 100);
+
+    while(esp_timer_get_time() < until){
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static void job_runner_test_replay_print(const char* name, jrerr_t err, const struct job_runner_replay_stats* stats){
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "%s failed code: %d", name, (int) err);
+        return;
+    }
+
+    ESP_LOGI("job_runner_test", "%s: %u jobs, %u notifications over %u ticks, %u callbacks in %u ms, latency avg %u us max %u us, max late %u ticks",
+        name, (unsigned int) stats->jobs, (unsigned int) stats->notifications, (unsigned int) stats->ticks, (unsigned int) stats->dispatched,
+        (unsigned int) (stats->wall_us / 1000),
+        (unsigned int) (stats->latency.total.count ? stats->latency.total.total_us / stats->latency.total.count : 0),
+        (unsigned int) stats->latency.total.max_us, (unsigned int) stats->max_late);
+
+}
+
+void job_runner_test_replay(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_replay_stats stats;
+    uint8_t* recording = malloc(REPLAY_BUFFER_SIZE);
+    int16_t sensor_job = 0;
+    size_t used = 0;
+    uint32_t dropped = 0;
+
+    ESP_LOGI("job_runner_test","Job Runner Record and Replay Test.");
+
+    if(recording == NULL){
+        err = JR_MEMORY_ALLOC_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_create(&runner, 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_record_start(runner, recording, REPLAY_BUFFER_SIZE);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_sensor_job, 50 / portTICK_PERIOD_MS, &sensor_job);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_sensor_job, 20 / portTICK_PERIOD_MS, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+    }
+
+    // The "production" traffic, an irregular stream of sized and inline notifications
+    for(int i = 0; err == JR_SUCCESS && i < 300; i++){
+
+        if(i % 4 == 0){
+
+            uint8_t* reading = malloc(64);
+
+            if(job_runner_notify_job_sized(runner, sensor_job, reading, &free, 64) != JR_SUCCESS){
+                free(reading);
+            }
+
+        }
+        else {
+
+            uint32_t code = i;
+            job_runner_notify_job_inline(runner, sensor_job, &code, sizeof(code));
+
+        }
+
+        vTaskDelay((1 + i % 3) * 10 / portTICK_PERIOD_MS);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_record_stop(runner, &used, &dropped);
+    }
+
+    if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test", "Recorded %u bytes, %u entries dropped", (unsigned int) used, (unsigned int) dropped);
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+        err = job_runner_shutdown_async(runner, &hnd);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // The same trace against two runner configurations
+        job_runner_test_replay_print("replay delay 1", job_runner_replay(recording, used, 1, &stats), &stats);
+        job_runner_test_replay_print("replay delay 5", job_runner_replay(recording, used, 5, &stats), &stats);
+
+    }
+    else {
+
+        ESP_LOGE("job_runner_test", "Recording failed code: %d", (int) err);
+
+    }
+
+    if(recording != NULL){
+        free(recording);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_REPLAY
+
+#ifdef JOB_RUNNER_TEST_STREAM
+#include "esp_timer.h"
+#include "freertos/semphr.h"
+
+#define STREAM_SAMPLE_SIZE 64
+#define STREAM_SLOTS 64
+#define STREAM_BURST 16
+#define STREAM_RUN_MS 5000
+#define STREAM_NOTIFY_BIT 0x01
+
+struct stream_sample {
+
+    uint32_t seq;
+    int64_t time_us;
+    uint8_t payload[STREAM_SAMPLE_SIZE - 12];
+
+};
+
+static struct job_runner_stream* stream_out = NULL;
+
+// Baseline: one shared buffer behind a mutex, the producer copies in and the consumer polls and copies out
+static SemaphoreHandle_t stream_lock = NULL;
+static struct stream_sample stream_shared[STREAM_SLOTS];
+static uint32_t stream_shared_count = 0;
+
+static volatile int stream_use_ring = 0;
+static volatile int stream_stop = 0;
+static uint32_t stream_produced = 0;
+static uint32_t stream_dropped = 0;
+static uint32_t stream_consumed = 0;
+static uint32_t stream_wakeups = 0;
+static int64_t stream_producer_us = 0;
+static int64_t stream_consumer_us = 0;
+static TaskHandle_t stream_consumer_task = NULL;
+
+static void job_runner_test_stream_fill(struct stream_sample* sample){
+
+    sample->seq = stream_produced;
+    sample->time_us = esp_timer_get_time();
+    memset(sample->payload, (uint8_t) stream_produced, sizeof(sample->payload));
+
+}
+
+job_runner_state_t job_runner_test_stream_producer_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    int64_t start_us = esp_timer_get_time();
+
+    for(int i = 0; i < STREAM_BURST; i++){
+
+        if(stream_use_ring){
+
+            // Written in place, nothing is copied on the way to the consumer
+            struct stream_sample* sample = job_runner_stream_reserve(stream_out);
+
+            if(sample == NULL){
+                stream_dropped++;
+                continue;
+            }
+
+            job_runner_test_stream_fill(sample);
+            job_runner_stream_commit(stream_out, sizeof(struct stream_sample));
+
+        }
+        else {
+
+            struct stream_sample sample;
+            job_runner_test_stream_fill(&sample);
+
+            xSemaphoreTake(stream_lock, portMAX_DELAY);
+
+            if(stream_shared_count < STREAM_SLOTS){
+                memcpy(&stream_shared[stream_shared_count++], &sample, sizeof(sample));
+            }
+            else {
+                stream_dropped++;
+            }
+
+            xSemaphoreGive(stream_lock);
+
+        }
+
+        stream_produced++;
+
+    }
+
+    stream_producer_us += esp_timer_get_time() - start_us;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static uint32_t job_runner_test_stream_check(const struct stream_sample* sample){
+
+    // Touch the whole sample so both variants read the same bytes
+    uint32_t sum = sample->seq;
+
+    for(int i = 0; i < sizeof(sample->payload); i++){
+        sum += sample->payload[i];
+    }
+
+    return sum;
+
+}
+
+static void job_runner_test_stream_consumer(void* arg){
+
+    volatile uint32_t sum = 0;
+
+    if(stream_use_ring){
+        job_runner_stream_bind_consumer(stream_out, STREAM_NOTIFY_BIT);
+    }
+
+    while(!stream_stop){
+
+        if(stream_use_ring){
+
+            uint32_t bits = 0;
+
+            if(xTaskNotifyWait(0, STREAM_NOTIFY_BIT, &bits, 10 / portTICK_PERIOD_MS) != pdTRUE){
+                continue;
+            }
+
+            stream_wakeups++;
+
+            int64_t start_us = esp_timer_get_time();
+
+            const struct stream_sample* sample = NULL;
+
+            while((sample = job_runner_stream_peek(stream_out, NULL)) != NULL){
+
+                sum += job_runner_test_stream_check(sample);
+                job_runner_stream_release(stream_out);
+                stream_consumed++;
+
+            }
+
+            stream_consumer_us += esp_timer_get_time() - start_us;
+
+        }
+        else {
+
+            // Nothing tells the consumer data is there, so it looks every tick
+            vTaskDelay(1);
+            stream_wakeups++;
+
+            int64_t start_us = esp_timer_get_time();
+
+            static struct stream_sample local[STREAM_SLOTS];
+            uint32_t count = 0;
+
+            xSemaphoreTake(stream_lock, portMAX_DELAY);
+
+            count = stream_shared_count;
+            memcpy(local, stream_shared, count * sizeof(struct stream_sample));
+            stream_shared_count = 0;
+
+            xSemaphoreGive(stream_lock);
+
+            for(uint32_t i = 0; i < count; i++){
+                sum += job_runner_test_stream_check(&local[i]);
+            }
+
+            stream_consumed += count;
+            stream_consumer_us += esp_timer_get_time() - start_us;
+
+        }
+
+    }
+
+    stream_consumer_task = NULL;
+    vTaskDelete(NULL);
+
+}
+
+static void job_runner_test_stream_run(int use_ring){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    int16_t producer = 0;
+
+    stream_use_ring = use_ring;
+    stream_stop = 0;
+    stream_produced = 0;
+    stream_dropped = 0;
+    stream_consumed = 0;
+    stream_wakeups = 0;
+    stream_producer_us = 0;
+    stream_consumer_us = 0;
+    stream_shared_count = 0;
+
+    if(use_ring){
+        err = job_runner_stream_create(&stream_out, sizeof(struct stream_sample), STREAM_SLOTS);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_create(&runner, 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_stream_producer_job, 1, &producer);
+    }
+
+    if(err == JR_SUCCESS){
+
+        if(xTaskCreate(&job_runner_test_stream_consumer, "stream_cons", 4096, NULL, 4, &stream_consumer_task) != pdPASS){
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Let the consumer bind before anything is committed
+        vTaskDelay(10 / portTICK_PERIOD_MS);
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(STREAM_RUN_MS / portTICK_PERIOD_MS);
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+        err = job_runner_shutdown_async(runner, &hnd);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    stream_stop = 1;
+
+    while(stream_consumer_task != NULL){
+        vTaskDelay(1);
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+
+    ESP_LOGI("job_runner_test", "%s: %u produced, %u consumed, %u dropped, producer %u us/1000, consumer %u us/1000, %u consumer wakeups",
+        use_ring ? "stream " : "mutex  ", (unsigned int) stream_produced, (unsigned int) stream_consumed, (unsigned int) stream_dropped,
+        (unsigned int) (stream_produced ? stream_producer_us * 1000 / stream_produced : 0),
+        (unsigned int) (stream_consumed ? stream_consumer_us * 1000 / stream_consumed : 0), (unsigned int) stream_wakeups);
+
+    if(use_ring && stream_out != NULL){
+
+        struct job_runner_stream_stats stats;
+
+        if(job_runner_stream_get_stats(stream_out, &stats) == JR_SUCCESS){
+            ESP_LOGI("job_runner_test", "stream stats: %u committed, %u dropped, high water %u of %u slots, %u wakeups",
+                (unsigned int) stats.committed, (unsigned int) stats.dropped, (unsigned int) stats.high_water, (unsigned int) STREAM_SLOTS,
+                (unsigned int) stats.wakeups);
+        }
+
+        job_runner_stream_destroy(stream_out);
+        stream_out = NULL;
+
+    }
+
+}
+
+void job_runner_test_stream(){
+
+    ESP_LOGI("job_runner_test","Job Runner Stream Benchmark.");
+
+    stream_lock = xSemaphoreCreateMutex();
+
+    job_runner_test_stream_run(1);
+    job_runner_test_stream_run(0);
+
+    vSemaphoreDelete(stream_lock);
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_STREAM
+
+#ifdef JOB_RUNNER_TEST_STAGGER
+
+#define STAGGER_JOBS 100
+#define STAGGER_PERIOD 100
+#define STAGGER_TICKS (STAGGER_PERIOD * 100)
+
+job_runner_state_t job_runner_test_stagger_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// The runner takes one job per loop, so jobs due on the same tick queue up and the pile up shows as lateness. The
+// arrays live on the heap, together they are more than the main task stack.
+static jrerr_t job_runner_test_stagger_run(int stagger, uint32_t expected_peak){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_job_desc* table = NULL;
+    struct job_runner_info info;
+    struct job_runner_job_info* jobs = NULL;
+    uint16_t* due = NULL;
+    uint16_t filled = 0;
+    uint32_t peak = 0;
+    uint32_t max_late = 0;
+    uint64_t total_late = 0;
+    int8_t finished = 0;
+
+    table = malloc(STAGGER_JOBS * sizeof(struct job_runner_job_desc));
+    jobs = malloc(STAGGER_JOBS * sizeof(struct job_runner_job_info));
+    due = calloc(STAGGER_PERIOD, sizeof(uint16_t));
+
+    if(table == NULL || jobs == NULL || due == NULL){
+        err = JR_MEMORY_ALLOC_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+
+        for(int i = 0; i < STAGGER_JOBS; i++){
+            table[i] = (struct job_runner_job_desc) { .job_callback = job_runner_test_stagger_job, .repeat_delay = STAGGER_PERIOD, .phase = 0, .priority = 0, .flags = 0 };
+        }
+
+        job_runner_virtual_clock_init(&vclock, &clock, 0);
+        err = job_runner_create(&runner, 1);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_phase_staggering(runner, stagger);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_jobs(runner, table, STAGGER_JOBS, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+
+        // Zero ticks only starts the runner, the phases are placed by then
+        err = job_runner_simulate(runner, 0, &finished);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(runner, &info, jobs, STAGGER_JOBS, &filled);
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < filled; i++){
+
+        uint32_t tick = (jobs[i].next_in > 0) ? jobs[i].next_in % STAGGER_PERIOD : 0;
+
+        if(++due[tick] > peak){
+            peak = due[tick];
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, STAGGER_TICKS, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(runner, &info, jobs, STAGGER_JOBS, &filled);
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < filled; i++){
+
+        total_late += jobs[i].max_late;
+
+        if(jobs[i].max_late > max_late){
+            max_late = jobs[i].max_late;
+        }
+
+    }
+
+    if(runner != NULL){
+
+        // Every job says done on shutdown, the runner frees itself once it runs out
+        job_runner_shutdown(runner);
+
+        while( ! finished && job_runner_simulate(runner, 1000, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(table != NULL){
+        free(table);
+    }
+
+    if(jobs != NULL){
+        free(jobs);
+    }
+
+    if(due != NULL){
+        free(due);
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+    else if(peak != expected_peak){
+
+        ESP_LOGE("job_runner_test", "FAIL %s: peak %u jobs due per tick, expected %u", stagger ? "staggered" : "aligned",
+            (unsigned int) peak, (unsigned int) expected_peak);
+        err = JR_FAIL;
+
+    }
+    else {
+
+        ESP_LOGI("job_runner_test", "PASS %s: peak %3u jobs due per tick, worst lateness %3u ticks, mean worst lateness per job %3u ticks",
+            stagger ? "staggered" : "aligned  ", (unsigned int) peak, (unsigned int) max_late, (unsigned int) (filled ? total_late / filled : 0));
+
+    }
+
+    return err;
+
+}
+
+void job_runner_test_stagger(){
+
+    ESP_LOGI("job_runner_test","Job Runner Phase Staggering Test, %d jobs every %d ticks.", STAGGER_JOBS, STAGGER_PERIOD);
+
+    // Without staggering every job comes due on the first tick, with it the jobs are spread evenly over the period
+    jrerr_t err = job_runner_test_stagger_run(0, STAGGER_JOBS);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_stagger_run(1, (STAGGER_JOBS + STAGGER_PERIOD - 1) / STAGGER_PERIOD);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_STAGGER
+
+
+#ifdef JOB_RUNNER_TEST_TIMERS
+
+static uint32_t timer_marker = 0;
+static uint32_t timer_payload_seen = 0;
+static uint32_t timer_payload_frees = 0;
+
+job_runner_state_t job_runner_test_timer_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data == &timer_marker){
+        timer_payload_seen++;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void delete_timer_payload(void* data){
+    timer_payload_frees++;
+}
+
+static jrerr_t job_runner_test_timer_expect(const char* name, uint32_t seen, uint32_t frees){
+
+    if(timer_payload_seen != seen || timer_payload_frees != frees){
+
+        ESP_LOGE("job_runner_test", "FAIL %s: payload delivered %u times and destroyed %u times, expected %u and %u", name,
+            (unsigned int) timer_payload_seen, (unsigned int) timer_payload_frees, (unsigned int) seen, (unsigned int) frees);
+        return JR_FAIL;
+
+    }
+
+    ESP_LOGI("job_runner_test", "PASS %s", name);
+
+    return JR_SUCCESS;
+
+}
+
+void job_runner_test_timers(){
+
+    ESP_LOGI("job_runner_test","Job Runner Delayed Notification Test.");
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    job_runner_timer_t handle = 0;
+    int16_t job_id = 0;
+
+    // Refused before anything reads the runner
+    if(job_runner_notify_job_at(NULL, 0, &timer_marker, &delete_timer_payload, 0, &handle) != JR_NULL_POINTER){
+        ESP_LOGE("job_runner_test", "FAIL a NULL runner was not refused");
+        err = JR_FAIL;
+    }
+
+    // A slow loop takes one command every 100 ms, anything on the normal lane waits behind the notifications below
+    if(err == JR_SUCCESS){
+        err = job_runner_create(&runner, 100 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_timer_job, 60000 / portTICK_PERIOD_MS, &job_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+    }
+
+    // Cancelled right after it was handed out, with the normal lane backed up
+    for(int i = 0; err == JR_SUCCESS && i < 4; i++){
+        err = job_runner_notify_job(runner, job_id, NULL, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job_delayed(runner, job_id, &timer_marker, &delete_timer_payload, 500 / portTICK_PERIOD_MS, &handle);
+    }
+
+    if(err == JR_SUCCESS){
+
+        jrerr_t cancelled = job_runner_cancel_notification(runner, handle);
+
+        if(cancelled != JR_SUCCESS){
+            ESP_LOGE("job_runner_test", "FAIL cancel right after the send returned %d", (int) cancelled);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        err = job_runner_test_timer_expect("cancel right after the send", 0, 1);
+
+    }
+
+    // Cancelled while it waits for its time, a second cancel finds nothing left
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job_delayed(runner, job_id, &timer_marker, &delete_timer_payload, 500 / portTICK_PERIOD_MS, &handle);
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(100 / portTICK_PERIOD_MS);
+
+        jrerr_t cancelled = job_runner_cancel_notification(runner, handle);
+        jrerr_t again = job_runner_cancel_notification(runner, handle);
+
+        if(cancelled != JR_SUCCESS || again != JR_NOT_PENDING){
+            ESP_LOGE("job_runner_test", "FAIL cancel before it fired returned %d, then %d", (int) cancelled, (int) again);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        err = job_runner_test_timer_expect("cancel before it fired", 0, 2);
+
+    }
+
+    // Delivered first, the cancel is refused and the payload is not destroyed a second time
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job_delayed(runner, job_id, &timer_marker, &delete_timer_payload, 200 / portTICK_PERIOD_MS, &handle);
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+
+        jrerr_t cancelled = job_runner_cancel_notification(runner, handle);
+
+        if(cancelled != JR_NOT_PENDING){
+            ESP_LOGE("job_runner_test", "FAIL cancel after it fired returned %d", (int) cancelled);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_timer_expect("cancel after it fired", 1, 3);
+    }
+
+    if(runner != NULL){
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+
+        if(job_runner_shutdown_async(runner, &hnd) == JR_SUCCESS){
+            job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_TIMERS
+
+
+#ifdef JOB_RUNNER_TEST_SHUTDOWN
+
+#define SHUTDOWN_JOBS 4
+#define SHUTDOWN_HANDLES 60
+
+static uint32_t shutdown_delivered = 0;
+static uint32_t shutdown_destroyed = 0;
+
+job_runner_state_t job_runner_test_shutdown_job(job_runner_state_t state, void* data){
+
+    if(data != NULL){
+        shutdown_delivered++;
+    }
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void delete_shutdown_payload(void* data){
+    shutdown_destroyed++;
+    free(data);
+}
+
+// Notifications still queued when the shutdown is sent reach their jobs with the shutdown call
+static jrerr_t job_runner_test_shutdown_drain(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    job_runner_shutdown_response_handle_t hnd = NULL;
+    int16_t job_ids[SHUTDOWN_JOBS];
+
+    // One command per loop every 100 ms, the notifications are all still queued when the shutdown goes out
+    err = job_runner_create(&runner, 100 / portTICK_PERIOD_MS);
+
+    for(int i = 0; err == JR_SUCCESS && i < SHUTDOWN_JOBS; i++){
+        err = job_runner_add_job(runner, job_runner_test_shutdown_job, 60000 / portTICK_PERIOD_MS, &job_ids[i]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < SHUTDOWN_JOBS; i++){
+        err = job_runner_notify_job(runner, job_ids[i], malloc(1), &delete_shutdown_payload);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_shutdown_async(runner, &hnd);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS && (shutdown_delivered != SHUTDOWN_JOBS || shutdown_destroyed != SHUTDOWN_JOBS)){
+
+        ESP_LOGE("job_runner_test", "FAIL drain: %u of %d notifications delivered, %u destroyed", (unsigned int) shutdown_delivered, SHUTDOWN_JOBS,
+            (unsigned int) shutdown_destroyed);
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test", "PASS drain: every queued notification delivered before the runner went away");
+
+    }
+
+    return err;
+
+}
+
+// An adaptive runner asleep at its ceiling is woken by the shutdown, it does not sleep the ceiling out first
+static jrerr_t job_runner_test_shutdown_wake(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    job_runner_shutdown_response_handle_t hnd = NULL;
+
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_adaptive_delay(runner, 1, 10000 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_shutdown_job, 60000 / portTICK_PERIOD_MS, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+    }
+
+    if(err == JR_SUCCESS){
+
+        vTaskDelay(1000 / portTICK_PERIOD_MS);
+        err = job_runner_shutdown_async(runner, &hnd);
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_await_shutdown(hnd, 200 / portTICK_PERIOD_MS);
+        if(err != JR_SUCCESS){
+            ESP_LOGE("job_runner_test", "FAIL wake: sleeping runner did not shut down within 200 ms, code %d", (int) err);
+        }
+        else {
+            ESP_LOGI("job_runner_test", "PASS wake");
+        }
+
+    }
+
+    return err;
+
+}
+
+// A payload handed to a helper with an offloaded job is destroyed once the helper is done, shutdown included
+static jrerr_t job_runner_test_shutdown_offload(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    job_runner_shutdown_response_handle_t hnd = NULL;
+    struct job_runner_job_desc desc = { .job_callback = job_runner_test_shutdown_job, .repeat_delay = 60000 / portTICK_PERIOD_MS,
+        .flags = JOB_RUNNER_JOB_OFFLOAD };
+    uint32_t delivered = shutdown_delivered;
+    uint32_t destroyed = shutdown_destroyed;
+    int16_t job_id = -1;
+
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_helpers(runner, 1, 4096, 5);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_jobs(runner, &desc, 1, &job_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runner, "test_run", 4096, 5);
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_notify_job(runner, job_id, malloc(1), &delete_shutdown_payload);
+        vTaskDelay(200 / portTICK_PERIOD_MS);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_shutdown_async(runner, &hnd);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS && (shutdown_delivered - delivered != 1 || shutdown_destroyed - destroyed != 1)){
+
+        ESP_LOGE("job_runner_test", "FAIL offload: the helper got %u payloads, %u destroyed", (unsigned int) (shutdown_delivered - delivered),
+            (unsigned int) (shutdown_destroyed - destroyed));
+        err = JR_FAIL;
+
+    }
+    else if(err == JR_SUCCESS){
+
+        ESP_LOGI("job_runner_test", "PASS offload: the helper's payload was destroyed and the runner shut down");
+
+    }
+
+    return err;
+
+}
+
+// Handles are not limited to the bits of one event group and outlive their runners. A runner has one handle, however
+// often it is asked for, and job_runner_await_all uses them up only once every runner is done.
+static jrerr_t job_runner_test_shutdown_handles(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    job_runner_shutdown_response_handle_t handles[SHUTDOWN_HANDLES];
+    job_runner_shutdown_response_handle_t again = NULL;
+    int8_t finished = 0;
+    int claimed = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+
+    for( ; err == JR_SUCCESS && claimed < SHUTDOWN_HANDLES; claimed++){
+
+        finished = 0;
+        err = job_runner_create(&runner, 1);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_set_clock(runner, &clock);
+        }
+
+        if(err == JR_SUCCESS){
+            err = job_runner_add_job(runner, job_runner_test_shutdown_job, 10, NULL);
+        }
+
+        if(err == JR_SUCCESS){
+            err = job_runner_get_shutdown_response_handle(runner, &handles[claimed]);
+        }
+
+        if(err == JR_SUCCESS){
+            err = job_runner_simulate(runner, 1, &finished);
+        }
+
+        // The last runner keeps running so the first wait times out
+        if(err == JR_SUCCESS && claimed < SHUTDOWN_HANDLES - 1){
+
+            err = job_runner_shutdown_async(runner, &again);
+
+            while(err == JR_SUCCESS && ! finished){
+                err = job_runner_simulate(runner, 1, &finished);
+            }
+
+        }
+        else if(err == JR_SUCCESS){
+
+            err = job_runner_get_shutdown_response_handle(runner, &again);
+
+        }
+
+        if(err == JR_SUCCESS && again != handles[claimed]){
+            ESP_LOGE("job_runner_test", "FAIL handles: asking runner %d again gave another handle", claimed);
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS && job_runner_await_all(handles, SHUTDOWN_HANDLES, 0) != JR_TIMEOUT){
+        ESP_LOGE("job_runner_test", "FAIL handles: the wait returned before the last runner was done");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_shutdown(runner);
+    }
+
+    while(err == JR_SUCCESS && ! finished){
+        err = job_runner_simulate(runner, 1, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_await_all(handles, SHUTDOWN_HANDLES, 0);
+    }
+
+    if(err == JR_SUCCESS && job_runner_await_shutdown(handles[0], 0) != JR_INVALID_SHUTDOWN_CODE){
+        ESP_LOGE("job_runner_test", "FAIL handles: a handle was still valid after the wait used it up");
+        err = JR_FAIL;
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "FAIL handles: stopped after %d handles, code %d", claimed, (int) err);
+    }
+    else {
+        ESP_LOGI("job_runner_test", "PASS handles: %d runners awaited at once", claimed);
+    }
+
+    return err;
+
+}
+
+void job_runner_test_shutdown(){
+
+    ESP_LOGI("job_runner_test","Job Runner Shutdown Test.");
+
+    jrerr_t err = job_runner_test_shutdown_drain();
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_shutdown_wake();
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_shutdown_offload();
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_shutdown_handles();
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Run failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_SHUTDOWN
+
+
+#ifdef JOB_RUNNER_TEST_CONSOLE
+
+#include "esp_console.h"
+
+#define CONSOLE_RUNNERS 2
+
+job_runner_state_t job_runner_test_console_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static jrerr_t job_runner_test_console_run(){
+
+    int ret = 0;
+
+    if(esp_console_run("jobs", &ret) != ESP_OK || ret != 0){
+        return JR_FAIL;
+    }
+
+    return JR_SUCCESS;
+
+}
+
+// The registered runners free themselves on shutdown, the command has to notice instead of dumping freed memory
+void job_runner_test_console(){
+
+    ESP_LOGI("job_runner_test","Job Runner Console Test.");
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runners[CONSOLE_RUNNERS] = {NULL};
+    job_runner_shutdown_response_handle_t hnd = NULL;
+    esp_console_config_t console_config = { .max_cmdline_length = 64, .max_cmdline_args = 4 };
+    uint32_t runs = 0;
+
+    esp_err_t cerr = esp_console_init(&console_config);
+    if(cerr != ESP_OK && cerr != ESP_ERR_INVALID_STATE){
+        err = JR_FAIL;
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < CONSOLE_RUNNERS; i++){
+
+        err = job_runner_create(&runners[i], 1);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_add_job(runners[i], job_runner_test_console_job, 10 / portTICK_PERIOD_MS, NULL);
+        }
+
+        if(err == JR_SUCCESS){
+            err = job_runner_execute(runners[i], "test_run", 4096, 5);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_console_register(runners, CONSOLE_RUNNERS);
+    }
+
+    // The first runner is gone before the command runs
+    if(err == JR_SUCCESS){
+        err = job_runner_shutdown_async(runners[0], &hnd);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_await_shutdown(hnd, 5000 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_console_run();
+    }
+
+    // The second one shuts down while the command keeps dumping it
+    if(err == JR_SUCCESS){
+        err = job_runner_shutdown_async(runners[1], &hnd);
+    }
+
+    while(err == JR_SUCCESS){
+
+        err = job_runner_test_console_run();
+        runs++;
+
+        if(err == JR_SUCCESS){
+
+            err = job_runner_await_shutdown(hnd, 0);
+
+            if(err == JR_SUCCESS){
+                break;
+            }
+
+            if(err == JR_TIMEOUT){
+                err = JR_SUCCESS;
+            }
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_console_run();
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "FAIL console, code %d", (int) err);
+    }
+    else {
+        ESP_LOGI("job_runner_test", "PASS console: %u dumps while the runner shut down", (unsigned int) runs);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_CONSOLE
+
+
+#ifdef JOB_RUNNER_TEST_COALESCE
+
+#define COALESCE_BURST 4
+#define COALESCE_PERIOD 0x10000000
+
+static uint32_t coalesce_created = 0;
+static uint32_t coalesce_destroyed = 0;
+
+static uint32_t* coalesce_payload(uint32_t value){
+
+    uint32_t* payload = malloc(sizeof(uint32_t));
+
+    if(payload != NULL){
+        *payload = value;
+        coalesce_created++;
+    }
+
+    return payload;
+
+}
+
+static void coalesce_dtor(void* data){
+
+    coalesce_destroyed++;
+    free(data);
+
+}
+
+// Folds the incoming value into the pending payload, the incoming one is destroyed
+static void* coalesce_merge_keep(void* pending, void* incoming){
+
+    *(uint32_t*) pending += *(uint32_t*) incoming;
+    return pending;
+
+}
+
+// Returns a new payload, both inputs are destroyed
+static void* coalesce_merge_new(void* pending, void* incoming){
+
+    uint32_t* merged = coalesce_payload(*(uint32_t*) pending + *(uint32_t*) incoming);
+    return (merged != NULL) ? merged : pending;
+
+}
+
+static job_runner_state_t job_runner_test_coalesce_job(job_runner_state_t state, void* data, void* context){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data != NULL){
+        *(uint32_t*) context = *(uint32_t*) data;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// Slots live in one array that grows as jobs ask for one. A paused job has to get a slot and follow the array when a
+// later job makes it move, its notification waits for the resume.
+static jrerr_t job_runner_test_coalesce_paused(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_job_desc desc;
+    int16_t paused_id = -1;
+    int16_t other_id = -1;
+    int16_t table_id = -1;
+    uint32_t paused_seen = 0;
+    uint32_t other_seen = 0;
+    uint32_t table_seen = 0;
+    uint32_t created = coalesce_created;
+    uint32_t destroyed = coalesce_destroyed;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_coalesce_job, &paused_seen, COALESCE_PERIOD, &paused_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_coalesce_job, &other_seen, COALESCE_PERIOD, &other_id);
+    }
+
+    if(err == JR_SUCCESS){
+
+        memset(&desc, 0, sizeof(desc));
+        desc.job_callback = (void*) job_runner_test_coalesce_job;
+        desc.repeat_delay = COALESCE_PERIOD;
+        desc.flags = JOB_RUNNER_JOB_PAUSED | JOB_RUNNER_JOB_CONTEXT;
+        desc.context = &table_seen;
+
+        err = job_runner_add_jobs(runner, &desc, 1, &table_id);
+
+    }
+
+    // Paused with its slot in place, the next two slots move the array under it
+    if(err == JR_SUCCESS){
+        err = job_runner_set_notif_coalescing(runner, paused_id, JOB_RUNNER_COALESCE_LATEST, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_pause_job(runner, paused_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_notif_coalescing(runner, other_id, JOB_RUNNER_COALESCE_LATEST, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_notif_coalescing(runner, table_id, JOB_RUNNER_COALESCE_MERGE, coalesce_merge_keep);
+    }
+
+    for(uint32_t value = 1; err == JR_SUCCESS && value <= COALESCE_BURST; value++){
+
+        uint32_t* payload = coalesce_payload(value);
+
+        err = (payload == NULL) ? JR_MEMORY_ALLOC_FAIL : job_runner_notify_job(runner, paused_id, payload, coalesce_dtor);
+
+        if(err == JR_SUCCESS){
+
+            payload = coalesce_payload(value);
+            err = (payload == NULL) ? JR_MEMORY_ALLOC_FAIL : job_runner_notify_job(runner, table_id, payload, coalesce_dtor);
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && (paused_seen != 0 || table_seen != 0)){
+        ESP_LOGE("job_runner_test", "FAIL paused jobs ran, saw %u and %u", (unsigned int) paused_seen, (unsigned int) table_seen);
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_resume_job(runner, paused_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_resume_job(runner, table_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && (paused_seen != COALESCE_BURST || table_seen != COALESCE_BURST * (COALESCE_BURST + 1) / 2 || other_seen != 0)){
+        ESP_LOGE("job_runner_test", "FAIL after the resume: saw %u, %u and %u", (unsigned int) paused_seen, (unsigned int) table_seen, (unsigned int) other_seen);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS && coalesce_created - created != coalesce_destroyed - destroyed){
+        ESP_LOGE("job_runner_test", "FAIL paused: %u payloads made, %u destroyed", (unsigned int) (coalesce_created - created), (unsigned int) (coalesce_destroyed - destroyed));
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS paused: slots of paused jobs followed the array, notifications waited for the resume");
+    }
+
+    return err;
+
+}
+
+// A bucket of burst notifications that refills at per_second, the refused ones are counted and left with the caller
+static jrerr_t job_runner_test_notif_rate(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_notif_stats stats;
+    int16_t job_id = -1;
+    uint32_t seen = 0;
+    uint32_t accepted = 0;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_coalesce_job, &seen, COALESCE_PERIOD, &job_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_notif_rate(runner, job_id, 1, 2);
+    }
+
+    // The full bucket takes the burst, the rest of the second is refused
+    for(int i = 0; err == JR_SUCCESS && i < 4; i++){
+
+        jrerr_t sent = job_runner_notify_job(runner, job_id, NULL, NULL);
+
+        if(sent == JR_SUCCESS){
+            accepted++;
+        }
+        else if(sent != JR_RATE_LIMITED){
+            err = sent;
+        }
+
+    }
+
+    // One second of the runner's clock brings back one notification
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, configTICK_RATE_HZ, &finished);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < 2; i++){
+
+        jrerr_t sent = job_runner_notify_job(runner, job_id, NULL, NULL);
+
+        if(sent == JR_SUCCESS){
+            accepted++;
+        }
+        else if(sent != JR_RATE_LIMITED){
+            err = sent;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_notif_stats(runner, job_id, &stats);
+    }
+
+    if(err == JR_SUCCESS && (accepted != 3 || stats.dropped != 3)){
+        ESP_LOGE("job_runner_test", "FAIL rate: %u accepted and %u dropped, expected 3 and 3", (unsigned int) accepted, (unsigned int) stats.dropped);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS rate: burst of 2, one more after a second, 3 refused");
+    }
+
+    return err;
+
+}
+
+void job_runner_test_coalesce(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Coalescing Test.");
+
+    static const job_runner_coalesce_t modes[] = { JOB_RUNNER_COALESCE_LATEST, JOB_RUNNER_COALESCE_MERGE, JOB_RUNNER_COALESCE_MERGE };
+    static void* (*const merges[])(void* pending, void* incoming) = { NULL, coalesce_merge_keep, coalesce_merge_new };
+    static const uint32_t expected[] = { COALESCE_BURST, COALESCE_BURST * (COALESCE_BURST + 1) / 2, COALESCE_BURST * (COALESCE_BURST + 1) / 2 };
+    static const char* names[] = { "latest", "merge into pending", "merge into new" };
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    int16_t ids[3];
+    uint32_t seen[3] = {0};
+    int16_t filler = -1;
+    uint32_t filler_seen = 0;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < 3; i++){
+
+        err = job_runner_add_job_with_context(runner, job_runner_test_coalesce_job, &seen[i], COALESCE_PERIOD, &ids[i]);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_set_notif_coalescing(runner, ids[i], modes[i], merges[i]);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_coalesce_job, &filler_seen, COALESCE_PERIOD, &filler);
+    }
+
+    // The whole burst lands before the runner takes anything, each job gets one folded payload
+    for(uint32_t value = 1; err == JR_SUCCESS && value <= COALESCE_BURST; value++){
+
+        for(int i = 0; err == JR_SUCCESS && i < 3; i++){
+
+            uint32_t* payload = coalesce_payload(value);
+
+            err = (payload == NULL) ? JR_MEMORY_ALLOC_FAIL : job_runner_notify_job(runner, ids[i], payload, coalesce_dtor);
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    for(int i = 0; err == JR_SUCCESS && i < 3; i++){
+
+        if(seen[i] != expected[i]){
+            ESP_LOGE("job_runner_test", "FAIL %s: job saw %u, expected %u", names[i], (unsigned int) seen[i], (unsigned int) expected[i]);
+            err = JR_FAIL;
+        }
+
+    }
+
+    // A simulated runner refuses a full queue at once, a payload already given to the slot goes with the refusal
+    for(int i = 0; err == JR_SUCCESS && i < 64; i++){
+
+        if(job_runner_notify_job(runner, filler, &filler_seen, NULL) == JR_QUEUE_FULL){
+            break;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        uint32_t* payload = coalesce_payload(1);
+
+        if(payload == NULL){
+            err = JR_MEMORY_ALLOC_FAIL;
+        }
+        else if(job_runner_notify_job(runner, ids[0], payload, coalesce_dtor) != JR_QUEUE_FULL){
+            ESP_LOGE("job_runner_test", "FAIL notification went through a full queue");
+            err = JR_FAIL;
+        }
+
+    }
+
+    // Every payload made, the merged and refused ones included, went through its destructor exactly once
+    if(err == JR_SUCCESS && coalesce_destroyed != coalesce_created){
+        ESP_LOGE("job_runner_test", "FAIL %u payloads made, %u destroyed", (unsigned int) coalesce_created, (unsigned int) coalesce_destroyed);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL){
+
+        job_runner_shutdown(runner);
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS %u payloads, each destroyed once", (unsigned int) coalesce_created);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_coalesce_paused();
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_notif_rate();
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Coalescing test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_COALESCE
+
+
+#ifdef JOB_RUNNER_TEST_LATENCY
+
+#define LATENCY_BURST 3
+#define LATENCY_PERIOD 0x10000000
+
+static job_runner_state_t job_runner_test_latency_job(job_runner_state_t state, void* data, void* context){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    (*(uint32_t*) context)++;
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void job_runner_test_latency(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Latency Test.");
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_latency_stats stats;
+    int16_t tracked = -1;
+    int16_t untracked = -1;
+    uint32_t tracked_runs = 0;
+    uint32_t untracked_runs = 0;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_latency_job, &tracked_runs, LATENCY_PERIOD, &tracked);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_latency_job, &untracked_runs, LATENCY_PERIOD, &untracked);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_track_latency(runner, tracked, 1);
+    }
+
+    // The burst lands before the runner takes anything, some of it is replaced before the job gets to run
+    for(int i = 0; err == JR_SUCCESS && i < LATENCY_BURST; i++){
+        err = job_runner_notify_job(runner, tracked, NULL, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job(runner, untracked, NULL, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && (tracked_runs == 0 || tracked_runs >= LATENCY_BURST || untracked_runs != 1)){
+        ESP_LOGE("job_runner_test", "FAIL runs: tracked %u, untracked %u", (unsigned int) tracked_runs, (unsigned int) untracked_runs);
+        err = JR_FAIL;
+    }
+
+    // Every notification is a sample, whether its job ran or it was replaced
+    if(err == JR_SUCCESS){
+        err = job_runner_get_latency(runner, tracked, &stats);
+    }
+
+    if(err == JR_SUCCESS && (stats.queue.count != LATENCY_BURST || stats.total.count != LATENCY_BURST)){
+        ESP_LOGE("job_runner_test", "FAIL tracked job has %u samples, expected %u", (unsigned int) stats.total.count, LATENCY_BURST);
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_latency(runner, -1, &stats);
+    }
+
+    if(err == JR_SUCCESS && stats.total.count != LATENCY_BURST + 1){
+        ESP_LOGE("job_runner_test", "FAIL runner has %u samples, expected %u", (unsigned int) stats.total.count, LATENCY_BURST + 1);
+        err = JR_FAIL;
+    }
+
+    // The runner never allocates histograms for a job on its own
+    if(err == JR_SUCCESS){
+        err = job_runner_get_latency(runner, untracked, &stats);
+    }
+
+    if(err == JR_SUCCESS && stats.total.count != 0){
+        ESP_LOGE("job_runner_test", "FAIL untracked job has %u samples", (unsigned int) stats.total.count);
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_track_latency(runner, tracked, 0);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_latency(runner, tracked, &stats);
+    }
+
+    if(err == JR_SUCCESS && stats.total.count != 0){
+        ESP_LOGE("job_runner_test", "FAIL job still has %u samples after tracking stopped", (unsigned int) stats.total.count);
+        err = JR_FAIL;
+    }
+
+    // Failing before the first simulate leaves a runner that never started and cannot shut down
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS replaced notifications sampled, histograms only on tracked jobs");
+    }
+    else {
+        ESP_LOGE("job_runner_test", "Latency test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_LATENCY
+
+
+#ifdef JOB_RUNNER_TEST_ADMISSION
+
+#define ADMISSION_PERIOD 10
+
+// Share of a period in microseconds, percent of ADMISSION_PERIOD ticks
+#define ADMISSION_WCET(percent) ((uint32_t) ADMISSION_PERIOD * portTICK_PERIOD_MS * 10 * (percent))
+
+static job_runner_state_t job_runner_test_admission_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static jrerr_t job_runner_test_admission_load(struct job_runner* runner, uint32_t expected, const char* what){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_sched_stats stats;
+
+    err = job_runner_get_sched_stats(runner, &stats);
+
+    if(err == JR_SUCCESS && stats.utilization != expected){
+        ESP_LOGE("job_runner_test", "FAIL %s: utilization %u, expected %u", what, (unsigned int) stats.utilization, (unsigned int) expected);
+        err = JR_FAIL;
+    }
+
+    return err;
+
+}
+
+void job_runner_test_admission(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Admission Test.");
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    int16_t first = -1;
+    int16_t second = -1;
+    int16_t refused = -1;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_admission(runner, JOB_RUNNER_ADMIT_REJECT, JOB_RUNNER_BOUND_EDF);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_wcet(runner, job_runner_test_admission_job, ADMISSION_PERIOD, ADMISSION_WCET(60), &first);
+    }
+
+    // The declared cost of a new job counts, 60% more would put the set at 120%
+    if(err == JR_SUCCESS && job_runner_add_job_with_wcet(runner, job_runner_test_admission_job, ADMISSION_PERIOD, ADMISSION_WCET(60), &refused) != JR_UNSCHEDULABLE){
+        ESP_LOGE("job_runner_test", "FAIL an overloading job was admitted");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_wcet(runner, job_runner_test_admission_job, ADMISSION_PERIOD, ADMISSION_WCET(30), &second);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_admission_load(runner, 900, "after adding");
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 3 * ADMISSION_PERIOD, &finished);
+    }
+
+    // Halving the period doubles the load of the second job, refused while running and the old period stays
+    if(err == JR_SUCCESS && job_runner_set_job_period(runner, second, ADMISSION_PERIOD / 2) != JR_UNSCHEDULABLE){
+        ESP_LOGE("job_runner_test", "FAIL an overloading period was accepted");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_admission_load(runner, 900, "after a refused period");
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_job_period(runner, second, ADMISSION_PERIOD * 2);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_admission_load(runner, 750, "after a longer period");
+    }
+
+    // Failing before the first simulate leaves a runner that never started and cannot shut down
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS overloading jobs and periods refused, the load kept");
+    }
+    else {
+        ESP_LOGE("job_runner_test", "Admission test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_ADMISSION
+
+
+#ifdef JOB_RUNNER_TEST_BOOST
+
+#define BOOST_PERIOD 20
+#define BOOST_PHASE 10
+#define BOOST_STALL 5
+#define BOOST_PASSES 10
+
+static struct job_runner_virtual_clock boost_vclock;
+static int8_t boost_stalling = 1;
+
+// Holds the runner for context ticks of the virtual clock, the jobs after it in the pass start late
+static job_runner_state_t job_runner_test_boost_job(job_runner_state_t state, void* data, void* context){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(boost_stalling){
+        boost_vclock.now += *(uint32_t*) context;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static jrerr_t job_runner_test_boost_expect(struct job_runner* runner, int8_t boosted, uint32_t boosts, const char* what){
+
+    jrerr_t err = JR_SUCCESS;
+
+    struct job_runner_boost_stats stats;
+
+    err = job_runner_get_boost_stats(runner, &stats);
+
+    if(err == JR_SUCCESS && (stats.boosted != boosted || stats.boosts != boosts)){
+        ESP_LOGE("job_runner_test", "FAIL %s: boosted %d after %u boosts, expected %d after %u", what, (int) stats.boosted,
+            (unsigned int) stats.boosts, (int) boosted, (unsigned int) boosts);
+        err = JR_FAIL;
+    }
+
+    return err;
+
+}
+
+// Every pass runs a late job, then one on time, then a late one again. The on time job in between must not end the
+// boost, the runner stays raised until a whole pass runs on time.
+static jrerr_t job_runner_test_boost_backlog(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    static uint32_t stalls[] = { 0, 0, 1, BOOST_STALL };
+    static const uint32_t phases[] = { BOOST_PHASE, BOOST_PHASE + BOOST_STALL + 1, BOOST_PHASE, BOOST_PHASE };
+
+    struct job_runner* runner = NULL;
+    struct job_runner_clock clock;
+    struct job_runner_boost boost = { .priority = 1, .late_on = 2, .late_off = 0, .queue_on = 0, .queue_off = 0 };
+    int16_t job_id = -1;
+    int8_t finished = 0;
+
+    boost_stalling = 1;
+
+    job_runner_virtual_clock_init(&boost_vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_priority_boost(runner, &boost);
+    }
+
+    // Newest first, the staller leads every pass: late (6), on time, late (5), staller
+    for(int i = 0; err == JR_SUCCESS && i < 4; i++){
+
+        err = job_runner_add_job_with_context(runner, job_runner_test_boost_job, &stalls[i], BOOST_PERIOD, &job_id);
+
+        if(err == JR_SUCCESS){
+            err = job_runner_set_job_phase(runner, job_id, phases[i]);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, BOOST_PASSES * BOOST_PERIOD, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_boost_expect(runner, 1, 1, "behind every pass");
+    }
+
+    // Caught up, the first pass on time lowers it and nothing raises it again
+    if(err == JR_SUCCESS){
+
+        boost_stalling = 0;
+        err = job_runner_simulate(runner, BOOST_PASSES * BOOST_PERIOD, &finished);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_boost_expect(runner, 0, 1, "caught up");
+    }
+
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS backlog: one boost for a runner behind every pass, lowered once it caught up");
+    }
+
+    return err;
+
+}
+
+// A boost has to be above the priority the task runs at, checked by execute before the start and right away after it
+static jrerr_t job_runner_test_boost_priority(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    static uint32_t no_stall = 0;
+
+    struct job_runner* runner = NULL;
+    struct job_runner_boost boost = { .priority = 5, .late_on = 2, .late_off = 0, .queue_on = 0, .queue_off = 0 };
+    int16_t job_id = -1;
+
+    err = job_runner_create(&runner, 10 / portTICK_PERIOD_MS);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_boost_job, &no_stall, 60000 / portTICK_PERIOD_MS, &job_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_priority_boost(runner, &boost);
+    }
+
+    if(err == JR_SUCCESS && job_runner_execute(runner, "test_run", 4096, 5) != JR_FAIL){
+        ESP_LOGE("job_runner_test", "FAIL execute took a boost at its own priority");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_execute(runner, "test_run", 4096, 4);
+    }
+
+    if(err == JR_SUCCESS){
+
+        boost.priority = 3;
+
+        if(job_runner_set_priority_boost(runner, &boost) != JR_FAIL){
+            ESP_LOGE("job_runner_test", "FAIL a running runner took a boost below its priority");
+            err = JR_FAIL;
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+
+        boost.priority = 6;
+        err = job_runner_set_priority_boost(runner, &boost);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_boost_expect(runner, 0, 0, "running, on time");
+    }
+
+    if(runner != NULL){
+
+        job_runner_shutdown_response_handle_t hnd = NULL;
+
+        if(job_runner_shutdown_async(runner, &hnd) == JR_SUCCESS){
+            job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS priority: boosts not above the base refused before and after the start");
+    }
+
+    return err;
+
+}
+
+void job_runner_test_boost(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Priority Boost Test.");
+
+    err = job_runner_test_boost_backlog();
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_boost_priority();
+    }
+
+    if(err != JR_SUCCESS){
+        ESP_LOGE("job_runner_test", "Priority boost test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_BOOST
+
+
+#ifdef JOB_RUNNER_TEST_LANES
+
+#define LANES_PERIOD 0x10000000
+
+static uint32_t lanes_first = 0;
+static uint32_t lanes_second = 0;
+static uint32_t lanes_third = 0;
+
+static job_runner_state_t job_runner_test_lanes_job(job_runner_state_t state, void* data, void* context){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(data != NULL){
+        *(void**) context = data;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void job_runner_test_lanes(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Lane Order Test.");
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    int16_t overtaken = -1;
+    int16_t held = -1;
+    void* overtaken_seen = NULL;
+    void* held_seen = NULL;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_lanes_job, &overtaken_seen, LANES_PERIOD, &overtaken);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_context(runner, job_runner_test_lanes_job, &held_seen, LANES_PERIOD, &held);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_pause_job(runner, held);
+    }
+
+    // Paused so both wait for it. The urgent one overtakes the first, which has no destructor and must not stop the runner.
+    if(err == JR_SUCCESS){
+        err = job_runner_pause_job(runner, overtaken);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job(runner, overtaken, &lanes_first, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job_urgent(runner, overtaken, &lanes_second, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_resume_job(runner, overtaken);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && overtaken_seen != &lanes_second){
+        ESP_LOGE("job_runner_test", "FAIL overtaken: the job did not get the notification sent last");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job(runner, overtaken, &lanes_third, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && overtaken_seen != &lanes_third){
+        ESP_LOGE("job_runner_test", "FAIL overtaken: the runner stopped taking notifications");
+        err = JR_FAIL;
+    }
+
+    // Held by a paused job for longer than 32 bits of microseconds, the newer one still replaces it
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job(runner, held, &lanes_first, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+
+        vclock.now += 0x80000000u / (portTICK_PERIOD_MS * 1000) + 10;
+        err = job_runner_notify_job(runner, held, &lanes_second, NULL);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_resume_job(runner, held);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && held_seen != &lanes_second){
+        ESP_LOGE("job_runner_test", "FAIL held: the newer notification was taken for an older one");
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS the notification sent last wins across lanes and long waits");
+    }
+    else {
+        ESP_LOGE("job_runner_test", "Lane order test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_LANES
+
+
+#ifdef JOB_RUNNER_TEST_SNAPSHOT
+
+#define SNAPSHOT_JOBS 4
+
+// Layout of the snapshot header and entries in job_runner.c, an entry starts with its id
+#define SNAPSHOT_HEADER 8
+#define SNAPSHOT_ENTRY 12
+#define SNAPSHOT_BUFFER (SNAPSHOT_HEADER + SNAPSHOT_JOBS * SNAPSHOT_ENTRY)
+
+// Ids the admission check moves the saved jobs to, clear of the job already on that runner
+#define SNAPSHOT_MOVED_ID 10
+
+static job_runner_state_t job_runner_test_snapshot_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static uint32_t snapshot_context = 0;
+static uint32_t snapshot_context_runs = 0;
+
+static job_runner_state_t job_runner_test_snapshot_context_job(job_runner_state_t state, void* data, void* context){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    if(context == &snapshot_context){
+        snapshot_context_runs++;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+// Starts the runner for a tick, a runner without jobs ends there and one with jobs is shut down
+static void job_runner_test_snapshot_stop(struct job_runner* runner){
+
+    int8_t finished = 0;
+
+    if(runner != NULL && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS && ! finished && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+}
+
+static jrerr_t job_runner_test_snapshot_runner(struct job_runner** runner, struct job_runner_virtual_clock* vclock, struct job_runner_clock* clock){
+
+    jrerr_t err = JR_SUCCESS;
+
+    job_runner_virtual_clock_init(vclock, clock, 0);
+    err = job_runner_create(runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(*runner, clock);
+    }
+
+    return err;
+
+}
+
+void job_runner_test_snapshot(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Snapshot Test.");
+
+    static const uint32_t periods[SNAPSHOT_JOBS] = { 10, 20, 30, 40 };
+
+    struct job_runner* saved = NULL;
+    struct job_runner* restored = NULL;
+    struct job_runner* refused = NULL;
+    struct job_runner* admitting = NULL;
+    struct job_runner_virtual_clock vclocks[4];
+    struct job_runner_clock clocks[4];
+    struct job_runner_restore_entry callbacks[2 * SNAPSHOT_JOBS];
+    struct job_runner_info info;
+    struct job_runner_job_info before[SNAPSHOT_JOBS];
+    struct job_runner_job_info after[SNAPSHOT_JOBS];
+    uint8_t buffer[SNAPSHOT_BUFFER];
+    uint8_t broken[SNAPSHOT_BUFFER];
+    uint16_t num_before = 0;
+    uint16_t num_after = 0;
+    size_t used = 0;
+    int8_t finished = 0;
+
+    err = job_runner_test_snapshot_runner(&saved, &vclocks[0], &clocks[0]);
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < SNAPSHOT_JOBS; i++){
+
+        callbacks[i] = (struct job_runner_restore_entry) { .job_id = i, .job_callback = job_runner_test_snapshot_job };
+        callbacks[SNAPSHOT_JOBS + i] = (struct job_runner_restore_entry) { .job_id = SNAPSHOT_MOVED_ID + i, .job_callback = job_runner_test_snapshot_job };
+
+        if(i == SNAPSHOT_JOBS - 1){
+
+            // The context is not saved, the restore entry hands it back
+            callbacks[i] = (struct job_runner_restore_entry) { .job_id = i, .job_callback = job_runner_test_snapshot_context_job, .context = &snapshot_context };
+            err = job_runner_add_job_with_context(saved, job_runner_test_snapshot_context_job, &snapshot_context, periods[i], NULL);
+
+        }
+        else {
+            err = job_runner_add_job(saved, job_runner_test_snapshot_job, periods[i], NULL);
+        }
+
+    }
+
+    // One of each kind, the order of the active jobs is what the restored runner has to keep
+    if(err == JR_SUCCESS){
+        err = job_runner_pause_job(saved, 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_job_offload(saved, 2, 1);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_snapshot(saved, buffer, sizeof(buffer), &used);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(saved, &info, before, SNAPSHOT_JOBS, &num_before);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_snapshot_runner(&restored, &vclocks[1], &clocks[1]);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_restore(restored, buffer, used, callbacks, SNAPSHOT_JOBS);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(restored, &info, after, SNAPSHOT_JOBS, &num_after);
+    }
+
+    if(err == JR_SUCCESS && num_after != num_before){
+        ESP_LOGE("job_runner_test", "FAIL round trip: %u jobs saved, %u restored", (unsigned int) num_before, (unsigned int) num_after);
+        err = JR_FAIL;
+    }
+
+    for(uint16_t i = 0; err == JR_SUCCESS && i < num_before; i++){
+
+        if(after[i].job_id != before[i].job_id || after[i].repeat_delay != before[i].repeat_delay || after[i].flags != before[i].flags){
+
+            ESP_LOGE("job_runner_test", "FAIL round trip: position %u holds job %d every %u flags 0x%02x, saved was job %d every %u flags 0x%02x",
+                (unsigned int) i, (int) after[i].job_id, (unsigned int) after[i].repeat_delay, (unsigned int) after[i].flags,
+                (int) before[i].job_id, (unsigned int) before[i].repeat_delay, (unsigned int) before[i].flags);
+            err = JR_FAIL;
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(restored, 2 * periods[SNAPSHOT_JOBS - 1], &finished);
+    }
+
+    if(err == JR_SUCCESS && snapshot_context_runs == 0){
+        ESP_LOGE("job_runner_test", "FAIL context: the restored context job never got its context");
+        err = JR_FAIL;
+    }
+
+    // The same id twice is refused before any job is added
+    if(err == JR_SUCCESS){
+
+        memcpy(broken, buffer, used);
+        memcpy(broken + SNAPSHOT_HEADER + SNAPSHOT_ENTRY, broken + SNAPSHOT_HEADER, SNAPSHOT_ENTRY);
+
+        err = job_runner_test_snapshot_runner(&refused, &vclocks[2], &clocks[2]);
+
+    }
+
+    if(err == JR_SUCCESS && job_runner_restore(refused, broken, used, callbacks, SNAPSHOT_JOBS) != JR_INVALID_SNAPSHOT){
+        ESP_LOGE("job_runner_test", "FAIL duplicate: a snapshot holding an id twice was restored");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(refused, &info, NULL, 0, &num_after);
+    }
+
+    if(err == JR_SUCCESS && info.num_jobs + info.num_paused != 0){
+        ESP_LOGE("job_runner_test", "FAIL duplicate: the refused snapshot left %u jobs behind", (unsigned int) (info.num_jobs + info.num_paused));
+        err = JR_FAIL;
+    }
+
+    // Restored jobs go through admission, four more put an 80% job over the rate monotonic bound for five
+    if(err == JR_SUCCESS){
+
+        memcpy(broken, buffer, used);
+
+        for(uint16_t i = 0; i < num_before; i++){
+
+            int16_t job_id;
+
+            memcpy(&job_id, broken + SNAPSHOT_HEADER + i * SNAPSHOT_ENTRY, sizeof(job_id));
+            job_id += SNAPSHOT_MOVED_ID;
+            memcpy(broken + SNAPSHOT_HEADER + i * SNAPSHOT_ENTRY, &job_id, sizeof(job_id));
+
+        }
+
+        err = job_runner_test_snapshot_runner(&admitting, &vclocks[3], &clocks[3]);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_admission(admitting, JOB_RUNNER_ADMIT_REJECT, JOB_RUNNER_BOUND_RM);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job_with_wcet(admitting, job_runner_test_snapshot_job, 10, 10 * portTICK_PERIOD_MS * 800, NULL);
+    }
+
+    if(err == JR_SUCCESS && job_runner_restore(admitting, broken, used, callbacks, 2 * SNAPSHOT_JOBS) != JR_UNSCHEDULABLE){
+        ESP_LOGE("job_runner_test", "FAIL admission: a snapshot overloading the runner was restored");
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_inspect(admitting, &info, NULL, 0, &num_after);
+    }
+
+    if(err == JR_SUCCESS && info.num_jobs + info.num_paused != 1){
+        ESP_LOGE("job_runner_test", "FAIL admission: the refused snapshot left %u jobs behind", (unsigned int) (info.num_jobs + info.num_paused - 1));
+        err = JR_FAIL;
+    }
+
+    job_runner_test_snapshot_stop(saved);
+    job_runner_test_snapshot_stop(restored);
+    job_runner_test_snapshot_stop(refused);
+    job_runner_test_snapshot_stop(admitting);
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS restored jobs keep their order, periods, flags and context and are admitted as a set");
+    }
+    else {
+        ESP_LOGE("job_runner_test", "Snapshot test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_SNAPSHOT
+
+
+#ifdef JOB_RUNNER_TEST_MEM_BUDGET
+
+#define MEM_PAYLOAD 64
+
+static uint32_t mem_destroyed = 0;
+
+static job_runner_state_t job_runner_test_mem_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static void job_runner_test_mem_dtor(void* data){
+
+    mem_destroyed++;
+    free(data);
+
+}
+
+static jrerr_t job_runner_test_mem_check(struct job_runner* runner, uint32_t notif_bytes, uint32_t peak_bytes, uint32_t rejected, const char* when){
+
+    struct job_runner_mem_stats stats;
+
+    jrerr_t err = job_runner_get_mem_stats(runner, &stats);
+
+    if(err == JR_SUCCESS && (stats.job_bytes == 0 || stats.notif_bytes != notif_bytes || stats.peak_bytes != stats.job_bytes + peak_bytes
+        || stats.rejected != rejected)){
+
+        ESP_LOGE("job_runner_test", "FAIL %s: %u notification bytes, peak %u over the jobs, %u rejected, expected %u, %u and %u", when,
+            (unsigned int) stats.notif_bytes, (unsigned int) (stats.peak_bytes - stats.job_bytes), (unsigned int) stats.rejected,
+            (unsigned int) notif_bytes, (unsigned int) peak_bytes, (unsigned int) rejected);
+        err = JR_FAIL;
+
+    }
+
+    return err;
+
+}
+
+void job_runner_test_mem_budget(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Memory Budget Test.");
+
+    struct job_runner* runner = NULL;
+    struct job_runner_virtual_clock vclock;
+    struct job_runner_clock clock;
+    struct job_runner_mem_stats stats;
+    void* refused = NULL;
+    int16_t job_id = -1;
+    int8_t finished = 0;
+
+    job_runner_virtual_clock_init(&vclock, &clock, 0);
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_clock(runner, &clock);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_mem_job, 1000, &job_id);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_mem_check(runner, 0, 0, 0, "empty");
+    }
+
+    // Room for the jobs and one payload, not two
+    if(err == JR_SUCCESS){
+        err = job_runner_get_mem_stats(runner, &stats);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_mem_budget(runner, stats.job_bytes + MEM_PAYLOAD + MEM_PAYLOAD / 2);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_notify_job_sized(runner, job_id, malloc(MEM_PAYLOAD), job_runner_test_mem_dtor, MEM_PAYLOAD);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_mem_check(runner, MEM_PAYLOAD, MEM_PAYLOAD, 0, "queued");
+    }
+
+    if(err == JR_SUCCESS){
+
+        refused = malloc(MEM_PAYLOAD);
+
+        if(job_runner_notify_job_sized(runner, job_id, refused, job_runner_test_mem_dtor, MEM_PAYLOAD) != JR_OVER_BUDGET){
+            ESP_LOGE("job_runner_test", "FAIL refused: a notification over the budget was taken");
+            refused = NULL;
+            err = JR_FAIL;
+        }
+
+    }
+
+    // The refused one is not counted, it did not go in
+    if(err == JR_SUCCESS){
+        err = job_runner_test_mem_check(runner, MEM_PAYLOAD, MEM_PAYLOAD, 1, "refused");
+    }
+
+    // Delivered and destroyed, the bytes are given back but the peak stays
+    if(err == JR_SUCCESS){
+        err = job_runner_simulate(runner, 10, &finished);
+    }
+
+    if(err == JR_SUCCESS && mem_destroyed != 1){
+        ESP_LOGE("job_runner_test", "FAIL delivered: %u payloads destroyed, expected 1", (unsigned int) mem_destroyed);
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_test_mem_check(runner, 0, MEM_PAYLOAD, 1, "delivered");
+    }
+
+    if(err == JR_SUCCESS){
+
+        err = job_runner_notify_job_sized(runner, job_id, refused, job_runner_test_mem_dtor, MEM_PAYLOAD);
+        refused = NULL;
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_mem_stats(runner, &stats);
+    }
+
+    if(err == JR_SUCCESS && stats.budget != stats.job_bytes + MEM_PAYLOAD + MEM_PAYLOAD / 2){
+        ESP_LOGE("job_runner_test", "FAIL budget: stats report %u", (unsigned int) stats.budget);
+        err = JR_FAIL;
+    }
+
+    free(refused);
+
+    if(runner != NULL && job_runner_shutdown(runner) == JR_SUCCESS){
+
+        while( ! finished && job_runner_simulate(runner, 1, &finished) == JR_SUCCESS ){
+        }
+
+    }
+
+    if(err == JR_SUCCESS && mem_destroyed != 2){
+        ESP_LOGE("job_runner_test", "FAIL shutdown: %u payloads destroyed, expected 2", (unsigned int) mem_destroyed);
+        err = JR_FAIL;
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS the budget refuses what does not fit and the stats follow every payload");
+    }
+    else {
+        ESP_LOGE("job_runner_test", "Memory budget test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_MEM_BUDGET
+
+
+#ifdef JOB_RUNNER_TEST_STACK
+
+#define STACK_SIZE 6144
+#define STACK_DEEP 2048
+
+static job_runner_state_t job_runner_test_stack_deep_job(job_runner_state_t state, void* data){
+
+    volatile uint8_t buffer[STACK_DEEP];
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    for(int i = 0; i < STACK_DEEP; i++){
+        buffer[i] = (uint8_t) i;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+static job_runner_state_t job_runner_test_stack_shallow_job(job_runner_state_t state, void* data){
+
+    if(state == JOB_RUNNER_SHUT_DOWN){
+        return JOB_RUNNER_IM_DONE;
+    }
+
+    return JOB_RUNNER_KEEP_ALIVE;
+
+}
+
+void job_runner_test_stack(){
+
+    jrerr_t err = JR_SUCCESS;
+
+    ESP_LOGI("job_runner_test","Job Runner Stack Monitor Test.");
+
+    struct job_runner* runner = NULL;
+    struct job_runner_stack_stats stats;
+    job_runner_shutdown_response_handle_t hnd = NULL;
+    int16_t deep = -1;
+    uint32_t used = 0;
+
+    err = job_runner_create(&runner, 1);
+
+    if(err == JR_SUCCESS){
+        err = job_runner_set_stack_monitor(runner, JOB_RUNNER_STACK_MONITOR_CALIBRATE);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_stack_deep_job, 10, &deep);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_add_job(runner, job_runner_test_stack_shallow_job, 10, NULL);
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_stack_stats(runner, &stats);
+    }
+
+    if(err == JR_SUCCESS && (stats.recommended_stack != 0 || stats.deepest_job_id != -1)){
+        ESP_LOGE("job_runner_test", "FAIL before start: %u bytes recommended for job %d with nothing measured", (unsigned int) stats.recommended_stack,
+            (int) stats.deepest_job_id);
+        err = JR_FAIL;
+    }
+
+    // Calibration runs every job once on a freshly painted stack, the periodic runs after it keep measuring
+    if(err == JR_SUCCESS){
+
+        err = job_runner_execute(runner, "test_stack", STACK_SIZE, 5);
+        vTaskDelay(500 / portTICK_PERIOD_MS);
+
+    }
+
+    if(err == JR_SUCCESS){
+        err = job_runner_get_stack_stats(runner, &stats);
+    }
+
+    if(err == JR_SUCCESS){
+
+        used = stats.stack_size - stats.min_free;
+
+        if(stats.stack_size != STACK_SIZE || stats.min_free > STACK_SIZE || used < STACK_DEEP || stats.deepest_job_id != deep){
+
+            ESP_LOGE("job_runner_test", "FAIL watermark: %u of %u bytes used, deepest job %d, expected over %u bytes by job %d",
+                (unsigned int) used, (unsigned int) stats.stack_size, (int) stats.deepest_job_id, (unsigned int) STACK_DEEP, (int) deep);
+            err = JR_FAIL;
+
+        }
+
+    }
+
+    if(err == JR_SUCCESS && (stats.recommended_stack < used + JOB_RUNNER_STACK_MARGIN || stats.recommended_stack % 16 != 0)){
+        ESP_LOGE("job_runner_test", "FAIL recommended: %u bytes for %u used", (unsigned int) stats.recommended_stack, (unsigned int) used);
+        err = JR_FAIL;
+    }
+
+    if(runner != NULL && job_runner_shutdown_async(runner, &hnd) == JR_SUCCESS){
+        job_runner_await_shutdown(hnd, 10000 / portTICK_PERIOD_MS);
+    }
+
+    if(err == JR_SUCCESS){
+        ESP_LOGI("job_runner_test", "PASS the deepest job set the watermark, %u of %u bytes used", (unsigned int) used, (unsigned int) STACK_SIZE);
+    }
+    else {
+        ESP_LOGE("job_runner_test", "Stack monitor test failed code: %d", (int) err);
+    }
+
+    vTaskDelay(2000 / portTICK_PERIOD_MS);
+    esp_restart();
+
+}
+#endif //JOB_RUNNER_TEST_STACK
 #endif // JOB_RUNNER_TESTING_ENABLE
\ No newline at end of file
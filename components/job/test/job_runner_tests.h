@@ -18,6 +18,102 @@ void job_runner_test_rand_shutdown();
 void job_runner_test_notifications();
 #endif
 
+#ifdef JOB_RUNNER_TEST_BALANCER
+void job_runner_test_balancer();
+#endif
+
+#ifdef JOB_RUNNER_TEST_ADAPTIVE_DELAY
+void job_runner_test_adaptive_delay();
+#endif
+
+#ifdef JOB_RUNNER_TEST_SIMULATION
+void job_runner_test_simulation();
+#endif
+
+#ifdef JOB_RUNNER_TEST_INLINE_NOTIFY
+void job_runner_test_inline_notify();
+#endif
+
+#ifdef JOB_RUNNER_TEST_SCAN
+void job_runner_test_scan();
+#endif
+
+#ifdef JOB_RUNNER_TEST_PUBSUB
+void job_runner_test_pubsub();
+#endif
+
+#ifdef JOB_RUNNER_TEST_REPLAY
+void job_runner_test_replay();
+#endif
+
+#ifdef JOB_RUNNER_TEST_STREAM
+void job_runner_test_stream();
+#endif
+
+#ifdef JOB_RUNNER_TEST_STAGGER
+void job_runner_test_stagger();
+#endif
+
+#ifdef JOB_RUNNER_TEST_TIMERS
+void job_runner_test_timers();
+#endif
+
+#ifdef JOB_RUNNER_TEST_SHUTDOWN
+void job_runner_test_shutdown();
+#endif
+
+#ifdef JOB_RUNNER_TEST_CONSOLE
+void job_runner_test_console();
+#endif
+
+#ifdef JOB_RUNNER_TEST_COALESCE
+void job_runner_test_coalesce();
+#endif
+
+#ifdef JOB_RUNNER_TEST_LATENCY
+void job_runner_test_latency();
+#endif
+
+#ifdef JOB_RUNNER_TEST_ADMISSION
+void job_runner_test_admission();
+#endif
+
+#ifdef JOB_RUNNER_TEST_BOOST
+void job_runner_test_boost();
+#endif
+
+#ifdef JOB_RUNNER_TEST_LANES
+void job_runner_test_lanes();
+#endif
+
+#ifdef JOB_RUNNER_TEST_SNAPSHOT
+void job_runner_test_snapshot();
+#endif
+
+#ifdef JOB_RUNNER_TEST_MEM_BUDGET
+void job_runner_test_mem_budget();
+#endif
+
+#ifdef JOB_RUNNER_TEST_STACK
+void job_runner_test_stack();
+#endif
+
+// Lives in job_runner_cpp_tests.cpp, needs C++17
+#ifdef JOB_RUNNER_TEST_CPP
+#ifdef __cplusplus
+extern "C"
+#endif
+void job_runner_test_cpp();
+#endif
+
+// Lives in job_runner_coro_tests.cpp, needs C++20
+#ifdef JOB_RUNNER_TEST_CORO
+#ifdef __cplusplus
+extern "C"
+#endif
+void job_runner_test_coro();
+#endif
+
 
 #endif //JOB_RUNNER_TESTING_ENABLE
 